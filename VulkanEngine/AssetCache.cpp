@@ -0,0 +1,122 @@
+#include "pch.h"
+
+#include "AssetCache.h"
+#include "TextureLoader.h"
+#include "CookedMesh.h"
+
+#include <filesystem>
+
+AssetCache* AssetCache::s_Instance = nullptr;
+
+AssetCache* AssetCache::GetInstance()
+{
+	if (s_Instance == 0)
+		s_Instance = new AssetCache();
+
+	return s_Instance;
+}
+
+MeshHandle AssetCache::FindMesh(const std::string& path)
+{
+	const std::string key = MeshKey(path);
+
+	if (key.empty())
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto it = m_Meshes.find(key);
+	return it != m_Meshes.end() ? it->second.lock() : nullptr;
+}
+
+void AssetCache::AddMesh(const std::string& path, const MeshHandle& mesh)
+{
+	const std::string key = MeshKey(path);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (!key.empty())
+		m_Meshes[key] = mesh;
+}
+
+TextureHandle AssetCache::FindTexture(const std::string& path)
+{
+	const std::string key = FileKey(path);
+
+	if (key.empty())
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto it = m_Textures.find(key);
+	return it != m_Textures.end() ? it->second.lock() : nullptr;
+}
+
+void AssetCache::AddTexture(const std::string& path, const TextureHandle& texture)
+{
+	const std::string key = FileKey(path);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (!key.empty())
+		m_Textures[key] = texture;
+}
+
+void AssetCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Meshes.clear();
+	m_Textures.clear();
+}
+
+MeshHandle AssetCache::MakeMeshHandle(std::vector<Mesh>&& meshes, std::vector<TextureHandle>&& textures)
+{
+	MeshAsset* asset = new MeshAsset();
+	asset->Meshes	= std::move(meshes);
+	asset->Textures	= std::move(textures);
+
+	return MeshHandle(asset, [](MeshAsset* mesh_asset) {
+		for (auto& mesh : mesh_asset->Meshes)
+			mesh.destroyBuffers();
+
+		delete mesh_asset;
+	});
+}
+
+TextureHandle AssetCache::MakeTextureHandle(const int descriptor)
+{
+	TextureAsset* asset = new TextureAsset();
+	asset->Descriptor = descriptor;
+
+	return TextureHandle(asset, [](TextureAsset* texture_asset) {
+		TextureLoader::GetInstance()->DestroyTexture(texture_asset->Descriptor);
+		delete texture_asset;
+	});
+}
+
+std::string AssetCache::MeshKey(const std::string& path)
+{
+	// The cooked file is the one loaded when it is up to date, and it may ship without its source
+	return FileKey(CookedMesh::IsUpToDate(path) ? CookedMesh::GetCookedPath(path) : path);
+}
+
+std::string AssetCache::FileKey(const std::string& path)
+{
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	const fs::path file = fs::canonical(path, error);
+
+	// Missing file: no key, the loader reports the error
+	if (error)
+		return std::string();
+
+	const uintmax_t size			= fs::file_size(file, error);
+	const fs::file_time_type time	= fs::last_write_time(file, error);
+
+	if (error)
+		return std::string();
+
+	return file.string() + "|" + std::to_string(size) + "|" + std::to_string(time.time_since_epoch().count());
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Mesh.h"
+
+// Texture living in TextureObjects: the descriptor index is also the index of image and view
+struct TextureAsset {
+	int Descriptor = 0;
+};
+
+// GPU buffers of an imported model, shared by all its placements
+struct MeshAsset {
+	std::vector<Mesh>							Meshes;
+	std::vector<std::shared_ptr<TextureAsset>>	Textures;	// Keeps the materials alive as long as the meshes
+};
+
+using TextureHandle = std::shared_ptr<TextureAsset>;
+using MeshHandle	= std::shared_ptr<MeshAsset>;
+
+// Deduplicates meshes and textures loaded more than once. Assets are keyed by the canonical
+// path, size and modification time of the file that is actually read: a stat, not a read of the
+// whole file, and a file rewritten on disk is loaded again. Meshes use the cooked file when it is
+// up to date, so a build shipping only the .cooked files works. A missing file is never in the
+// cache. The cache only holds weak references: the GPU resources are destroyed when the last
+// handle goes away.
+class AssetCache
+{
+public:
+	static AssetCache* GetInstance();
+
+	MeshHandle FindMesh(const std::string& path);
+	void AddMesh(const std::string& path, const MeshHandle& mesh);
+
+	TextureHandle FindTexture(const std::string& path);
+	void AddTexture(const std::string& path, const TextureHandle& texture);
+
+	void Clear();
+
+	// Handles whose deleter releases the GPU resources (the device must be idle)
+	static MeshHandle MakeMeshHandle(std::vector<Mesh>&& meshes, std::vector<TextureHandle>&& textures);
+	static TextureHandle MakeTextureHandle(const int descriptor);
+
+private:
+	AssetCache() = default;
+	static AssetCache* s_Instance;
+
+	std::unordered_map<std::string, std::weak_ptr<MeshAsset>>		m_Meshes;
+	std::unordered_map<std::string, std::weak_ptr<TextureAsset>>	m_Textures;
+	std::mutex m_Mutex;
+
+private:
+	static std::string MeshKey(const std::string& path);
+	static std::string FileKey(const std::string& path);
+};
@@ -0,0 +1,213 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+
+CameraPath::CameraPath(const std::vector<CameraKey>& keys, const float duration)
+{
+	if (keys.size() < 2)
+		throw std::runtime_error("A camera path needs at least two keyframes!");
+
+	m_Keys		= keys;
+	m_Duration	= duration;
+}
+
+glm::mat4 CameraPath::Evaluate(const float time) const
+{
+	// The path is closed: the last keyframe blends back into the first one
+	const size_t key_count	= m_Keys.size();
+	const float loop_time	= std::fmod(time, m_Duration) / m_Duration * static_cast<float>(key_count);
+	const size_t segment	= static_cast<size_t>(loop_time) % key_count;
+	const float t			= loop_time - std::floor(loop_time);
+
+	const CameraKey& k0 = m_Keys[(segment + key_count - 1) % key_count];
+	const CameraKey& k1 = m_Keys[segment];
+	const CameraKey& k2 = m_Keys[(segment + 1) % key_count];
+	const CameraKey& k3 = m_Keys[(segment + 2) % key_count];
+
+	auto catmull_rom = [t](const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3)
+	{
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+
+		return 0.5f * ((2.0f * p1) + (-p0 + p2) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+	};
+
+	const glm::vec3 position	= catmull_rom(k0.position, k1.position, k2.position, k3.position);
+	const glm::vec3 target		= catmull_rom(k0.target, k1.target, k2.target, k3.target);
+
+	return glm::lookAt(position, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+CameraPath CameraPath::DefaultOrbit()
+{
+	// Orbit around the three Vivi models, with a close pass and a view from above the floor
+	const std::vector<CameraKey> keys = {
+		{ glm::vec3( 0.0f,  0.0f,  3.0f), glm::vec3( 0.0f, -0.3f, 0.0f) },
+		{ glm::vec3( 2.5f,  0.5f,  1.5f), glm::vec3( 0.0f, -0.3f, 0.0f) },
+		{ glm::vec3( 2.0f,  1.5f, -2.0f), glm::vec3( 0.0f, -0.5f, 0.0f) },
+		{ glm::vec3( 0.0f,  0.2f, -1.2f), glm::vec3( 0.0f, -0.2f, 0.0f) },
+		{ glm::vec3(-2.0f,  1.5f, -2.0f), glm::vec3( 0.0f, -0.5f, 0.0f) },
+		{ glm::vec3(-2.5f,  0.5f,  1.5f), glm::vec3(-1.0f, -0.3f, 0.0f) },
+	};
+
+	return CameraPath(keys, 20.0f);
+}
+
+BenchmarkReport::BenchmarkReport(const uint64_t first_frame, const uint32_t frame_count)
+{
+	m_FirstFrame = first_frame;
+	m_Samples.resize(frame_count);
+
+	for (uint32_t i = 0; i < frame_count; ++i)
+		m_Samples[i].frame = first_frame + i;
+}
+
+void BenchmarkReport::AddFrameSample(const uint64_t frame, const double frame_ms, const double cpu_ms)
+{
+	if (frame < m_FirstFrame || frame - m_FirstFrame >= m_Samples.size())
+		return;
+
+	m_Samples[frame - m_FirstFrame].frame_ms	= frame_ms;
+	m_Samples[frame - m_FirstFrame].cpu_ms		= cpu_ms;
+}
+
+void BenchmarkReport::SetGPUSample(const uint64_t frame, const double gpu_ms)
+{
+	// GPU timings arrive a few frames late, warmup frames are simply dropped
+	if (frame < m_FirstFrame || frame - m_FirstFrame >= m_Samples.size())
+		return;
+
+	m_Samples[frame - m_FirstFrame].gpu_ms = gpu_ms;
+}
+
+double BenchmarkReport::Percentile(std::vector<double> values, const double percentile)
+{
+	if (values.empty())
+		return 0.0;
+
+	// Nearest-rank percentile
+	std::sort(values.begin(), values.end());
+
+	const double rank	= std::ceil(percentile / 100.0 * static_cast<double>(values.size()));
+	const size_t index	= static_cast<size_t>(std::max(rank, 1.0)) - 1;
+
+	return values[std::min(index, values.size() - 1)];
+}
+
+SampleStatistics BenchmarkReport::ComputeStatistics(double FrameSample::* field) const
+{
+	std::vector<double> values;
+	values.reserve(m_Samples.size());
+
+	for (const auto& sample : m_Samples)
+	{
+		if (sample.*field >= 0.0)
+			values.push_back(sample.*field);
+	}
+
+	SampleStatistics stats;
+
+	if (values.empty())
+		return stats;
+
+	double sum = 0.0;
+	for (double value : values)
+		sum += value;
+
+	stats.min	= *std::min_element(values.begin(), values.end());
+	stats.max	= *std::max_element(values.begin(), values.end());
+	stats.mean	= sum / static_cast<double>(values.size());
+	stats.p50	= Percentile(values, 50.0);
+	stats.p95	= Percentile(values, 95.0);
+	stats.p99	= Percentile(values, 99.0);
+
+	return stats;
+}
+
+void BenchmarkReport::WriteCSV(const std::string& file) const
+{
+	std::ofstream out(file);
+
+	if (!out.is_open())
+		throw std::runtime_error("Failed to open the benchmark output file! (" + file + ")");
+
+	out << "frame,frame_ms,cpu_ms,gpu_ms\n";
+
+	for (const auto& sample : m_Samples)
+		out << sample.frame << "," << sample.frame_ms << "," << sample.cpu_ms << "," << sample.gpu_ms << "\n";
+
+	// Summary table after a blank line
+	const SampleStatistics frame_stats	= ComputeStatistics(&FrameSample::frame_ms);
+	const SampleStatistics cpu_stats	= ComputeStatistics(&FrameSample::cpu_ms);
+	const SampleStatistics gpu_stats	= ComputeStatistics(&FrameSample::gpu_ms);
+
+	out << "\nstatistic,frame_ms,cpu_ms,gpu_ms\n";
+	out << "min,"	<< frame_stats.min	<< "," << cpu_stats.min	 << "," << gpu_stats.min	<< "\n";
+	out << "mean,"	<< frame_stats.mean << "," << cpu_stats.mean << "," << gpu_stats.mean	<< "\n";
+	out << "p50,"	<< frame_stats.p50	<< "," << cpu_stats.p50	 << "," << gpu_stats.p50	<< "\n";
+	out << "p95,"	<< frame_stats.p95	<< "," << cpu_stats.p95	 << "," << gpu_stats.p95	<< "\n";
+	out << "p99,"	<< frame_stats.p99	<< "," << cpu_stats.p99	 << "," << gpu_stats.p99	<< "\n";
+	out << "max,"	<< frame_stats.max	<< "," << cpu_stats.max	 << "," << gpu_stats.max	<< "\n";
+}
+
+void BenchmarkReport::WriteJSON(const std::string& file) const
+{
+	std::ofstream out(file);
+
+	if (!out.is_open())
+		throw std::runtime_error("Failed to open the benchmark output file! (" + file + ")");
+
+	auto write_stats = [&out](const char* name, const SampleStatistics& stats, const bool last)
+	{
+		out << "    \"" << name << "\": { "
+			<< "\"min\": "	<< stats.min	<< ", "
+			<< "\"mean\": " << stats.mean	<< ", "
+			<< "\"p50\": "	<< stats.p50	<< ", "
+			<< "\"p95\": "	<< stats.p95	<< ", "
+			<< "\"p99\": "	<< stats.p99	<< ", "
+			<< "\"max\": "	<< stats.max	<< " }" << (last ? "\n" : ",\n");
+	};
+
+	out << "{\n";
+	out << "  \"frame_count\": " << m_Samples.size() << ",\n";
+	out << "  \"summary\": {\n";
+	write_stats("frame_ms", ComputeStatistics(&FrameSample::frame_ms), false);
+	write_stats("cpu_ms", ComputeStatistics(&FrameSample::cpu_ms), false);
+	write_stats("gpu_ms", ComputeStatistics(&FrameSample::gpu_ms), true);
+	out << "  },\n";
+	out << "  \"frames\": [\n";
+
+	for (size_t i = 0; i < m_Samples.size(); ++i)
+	{
+		const FrameSample& sample = m_Samples[i];
+
+		out << "    { \"frame\": " << sample.frame
+			<< ", \"frame_ms\": "	<< sample.frame_ms
+			<< ", \"cpu_ms\": "		<< sample.cpu_ms
+			<< ", \"gpu_ms\": "		<< sample.gpu_ms
+			<< (i + 1 < m_Samples.size() ? " },\n" : " }\n");
+	}
+
+	out << "  ]\n";
+	out << "}\n";
+}
+
+void BenchmarkReport::PrintSummary(std::ostream& out) const
+{
+	auto print_stats = [&out](const char* name, const SampleStatistics& stats)
+	{
+		out << name
+			<< " mean " << stats.mean
+			<< " | p50 " << stats.p50
+			<< " | p95 " << stats.p95
+			<< " | p99 " << stats.p99
+			<< " | max " << stats.max << std::endl;
+	};
+
+	out << "Measured frames: " << m_Samples.size() << std::endl;
+	print_stats("Frame (ms):", ComputeStatistics(&FrameSample::frame_ms));
+	print_stats("CPU   (ms):", ComputeStatistics(&FrameSample::cpu_ms));
+	print_stats("GPU   (ms):", ComputeStatistics(&FrameSample::gpu_ms));
+}
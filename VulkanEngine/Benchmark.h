@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pch.h"
+
+// Camera keyframe, the path goes through the positions while looking at the targets
+struct CameraKey {
+	glm::vec3 position;
+	glm::vec3 target;
+};
+
+// Deterministic camera path: Catmull-Rom spline evaluated from the simulated time,
+// so every run (and every build) renders exactly the same sequence of views.
+class CameraPath
+{
+public:
+	CameraPath(const std::vector<CameraKey>& keys, const float duration);
+
+	glm::mat4 Evaluate(const float time) const;
+
+	static CameraPath DefaultOrbit();
+
+private:
+	std::vector<CameraKey>	m_Keys;
+	float					m_Duration;
+};
+
+struct FrameSample {
+	uint64_t	frame		= 0;
+	double		frame_ms	= 0.0;		// Wall time of the whole frame
+	double		cpu_ms		= 0.0;		// Frame time minus the time spent waiting for the GPU
+	double		gpu_ms		= -1.0;		// Negative when the timestamps were not available
+};
+
+struct SampleStatistics {
+	double min	= 0.0;
+	double mean	= 0.0;
+	double p50	= 0.0;
+	double p95	= 0.0;
+	double p99	= 0.0;
+	double max	= 0.0;
+};
+
+class BenchmarkReport
+{
+public:
+	BenchmarkReport(const uint64_t first_frame, const uint32_t frame_count);
+
+	void AddFrameSample(const uint64_t frame, const double frame_ms, const double cpu_ms);
+	void SetGPUSample(const uint64_t frame, const double gpu_ms);
+
+	SampleStatistics ComputeStatistics(double FrameSample::* field) const;
+
+	void WriteCSV(const std::string& file) const;
+	void WriteJSON(const std::string& file) const;
+	void PrintSummary(std::ostream& out) const;
+
+	static double Percentile(std::vector<double> values, const double percentile);
+
+private:
+	uint64_t				 m_FirstFrame;
+	std::vector<FrameSample> m_Samples;
+};
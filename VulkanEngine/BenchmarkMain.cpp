@@ -0,0 +1,294 @@
+#include "pch.h"
+
+#include "VulkanRenderer.h"
+#include "Benchmark.h"
+
+static VulkanRenderer* vulkanRenderer = new VulkanRenderer();
+
+// Fixed simulation step: the scripted path does not depend on how fast the frames are rendered
+constexpr float BENCHMARK_TIME_STEP = 1.0f / 60.0f;
+
+struct BenchmarkOptions {
+	uint32_t	warmup_frames	= 200;
+	uint32_t	measured_frames = 1000;
+	uint32_t	width			= 1280;
+	uint32_t	height			= 720;
+	std::string output			= "benchmark.csv";
+	std::string format			= "";		// "csv" or "json", deduced from the output file when empty
+	std::string lighting		= "fullscreen";	// "fullscreen", "tiled", "clustered" or "volumes"
+	uint32_t	lights			= NUM_LIGHTS;
+	std::string vertex_format	= "full";		// "full" (Vertex) or "packed" (PackedVertex)
+	float		light_radius	= 1.0f;
+	bool		cluster_build	= false;		// Time only the CPU cluster builder, no Vulkan device is created
+};
+
+void printUsage()
+{
+	std::cout << "VulkanBenchmark [--warmup N] [--frames N] [--width W] [--height H] "
+				 "[--output file] [--format csv|json] [--lighting fullscreen|tiled|clustered|volumes] [--lights N] [--light-radius R] "
+				 "[--vertex-format full|packed] [--cluster-build]" << std::endl;
+}
+
+bool parseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool has_value  = i + 1 < argc;
+
+		if (arg == "--warmup" && has_value)			options.warmup_frames	= static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--frames" && has_value)	options.measured_frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--width" && has_value)		options.width			= static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--height" && has_value)	options.height			= static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--output" && has_value)	options.output			= argv[++i];
+		else if (arg == "--format" && has_value)	options.format			= argv[++i];
+		else if (arg == "--lighting" && has_value)	options.lighting		= argv[++i];
+		else if (arg == "--lights" && has_value)	options.lights			= static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--light-radius" && has_value)	options.light_radius = std::stof(argv[++i]);
+		else if (arg == "--vertex-format" && has_value)	options.vertex_format = argv[++i];
+		else if (arg == "--cluster-build")			options.cluster_build	= true;
+		else
+			return false;
+	}
+
+	if (options.format.empty())
+	{
+		const size_t dot = options.output.find_last_of('.');
+		options.format = (dot != std::string::npos && options.output.substr(dot) == ".json") ? "json" : "csv";
+	}
+
+	return options.measured_frames > 0 && options.width > 0 && options.height > 0 &&
+		(options.format == "csv" || options.format == "json") &&
+		(options.lighting == "fullscreen" || options.lighting == "tiled" || options.lighting == "clustered" || options.lighting == "volumes") &&
+		(options.vertex_format == "full" || options.vertex_format == "packed") &&
+		options.lights > 0 && options.light_radius > 0.0f;
+}
+
+LightingMode lightingMode(const std::string& lighting)
+{
+	if (lighting == "tiled")
+		return LIGHTING_TILED;
+	if (lighting == "clustered")
+		return LIGHTING_CLUSTERED;
+	if (lighting == "volumes")
+		return LIGHTING_VOLUMES;
+
+	return LIGHTING_FULLSCREEN;
+}
+
+// Same placement used by the interactive application
+void setupScene(const BenchmarkOptions& options)
+{
+	vulkanRenderer->GetUBOSettingsRef()->lighting_mode = lightingMode(options.lighting);
+	vulkanRenderer->SetLightCount(options.lights);
+
+	glm::mat4 model(1.0f);
+	model = glm::translate(model, glm::vec3(-4.5f, -0.5f, 2.5f));
+	model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	vulkanRenderer->UpdateModel(1, model);
+
+	const std::array<float, 3> vivi_x = { 0.0f, -1.0f, 1.0f };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		glm::mat4 vivi_model(1.0f);
+		vivi_model = glm::translate(vivi_model, glm::vec3(vivi_x[i], -0.5f, 0.0f));
+		vivi_model = glm::scale(vivi_model, 0.4f * glm::vec3(1.0f, 1.0f, 1.0f));
+
+		// Instances of model 0: the first one already exists
+		if (i == 0)
+			vulkanRenderer->UpdateModel(0, vivi_model);
+		else
+			vulkanRenderer->AddModelInstance(0, vivi_model);
+	}
+
+	// Fixed seed: light colours are the same in every run
+	pcg32 rng(42u);
+	std::uniform_real_distribution<float> uniform_dist(0.0f, 1.0f);
+
+	for (unsigned int i = 0; i < vulkanRenderer->GetLightCount(); ++i)
+	{
+		const float r = uniform_dist(rng);
+		const float g = uniform_dist(rng);
+		const float b = uniform_dist(rng);
+		vulkanRenderer->UpdateLightColour(i, glm::vec3(r, g, b));
+		vulkanRenderer->UpdateLightRadius(i, options.light_radius);
+	}
+}
+
+// Scripted replacement of the random light movement done in Main.cpp
+glm::vec3 scriptedLightPosition(const unsigned int light, const float time)
+{
+	const float lights_pos	= 0.5f * time;
+	const float phase		= 0.7f * static_cast<float>(light);
+
+	return glm::vec3(
+		sinf(phase + lights_pos),
+		0.5f * cosf(1.3f * phase + lights_pos) - 0.2f,
+		sinf(2.1f * phase + lights_pos));
+}
+
+void updateLights(const float time)
+{
+	for (unsigned int i = 0; i < vulkanRenderer->GetLightCount(); ++i)
+		vulkanRenderer->UpdateLightPosition(i, scriptedLightPosition(i, time));
+}
+
+// CPU cluster builder alone, on the same lights and camera path of the rendered benchmark.
+// Frame and CPU columns both hold the build time, there is no GPU column.
+int runClusterBuildBenchmark(const BenchmarkOptions& options)
+{
+	constexpr float near_plane	= 0.1f;		// Same planes of VulkanRenderer
+	constexpr float far_plane	= 100.0f;
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f),
+		static_cast<float>(options.width) / static_cast<float>(options.height), near_plane, far_plane);
+	projection[1][1] *= -1;
+
+	std::vector<LightData> lights(options.lights);
+
+	for (auto& light : lights)
+		light.m_Radius = options.light_radius;
+
+	const CameraPath camera_path = CameraPath::DefaultOrbit();
+	LightClusters clusters;
+
+	const uint32_t total_frames = options.warmup_frames + options.measured_frames;
+	BenchmarkReport report(options.warmup_frames, options.measured_frames);
+
+	uint64_t index_count = 0;
+
+	for (uint32_t frame = 0; frame < total_frames; ++frame)
+	{
+		const float time = static_cast<float>(frame) * BENCHMARK_TIME_STEP;
+
+		for (unsigned int i = 0; i < options.lights; ++i)
+			lights[i].m_LightPosition = scriptedLightPosition(i, time);
+
+		auto const build_begin = std::chrono::high_resolution_clock::now();
+		clusters.Build(lights, camera_path.Evaluate(time), projection, near_plane, far_plane);
+		const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - build_begin).count();
+
+		report.AddFrameSample(frame, build_ms, build_ms);
+
+		if (frame >= options.warmup_frames)
+			index_count += clusters.GetHeader().index_count;
+	}
+
+	std::cout << "Cluster build, " << options.lights << " lights, " << CLUSTER_COUNT << " clusters, "
+			  << index_count / options.measured_frames << " light indices per frame" << std::endl;
+	report.PrintSummary(std::cout);
+
+	try
+	{
+		if (options.format == "json")
+			report.WriteJSON(options.output);
+		else
+			report.WriteCSV(options.output);
+	}
+	catch (std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "Results written to " << options.output << std::endl;
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+
+	if (!parseArguments(argc, argv, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (options.cluster_build)
+		return runClusterBuildBenchmark(options);
+
+	vulkanRenderer->SetVertexFormat(options.vertex_format == "packed" ? VertexFormat::Packed : VertexFormat::Full);
+
+	if (vulkanRenderer->InitHeadless(options.width, options.height) == EXIT_FAILURE)
+		return EXIT_FAILURE;
+
+	setupScene(options);
+
+	const CameraPath camera_path = CameraPath::DefaultOrbit();
+
+	// GPU timings come back MAX_FRAMES_IN_FLIGHT frames late, a few extra frames drain them
+	const uint32_t total_frames = options.warmup_frames + options.measured_frames + MAX_FRAMES_IN_FLIGHT;
+	BenchmarkReport report(vulkanRenderer->GetFrameCount() + options.warmup_frames, options.measured_frames);
+
+	// Worst frame of the tiled lighting: lights dropped from a full tile make the run not comparable
+	TiledLightingStats worst_tiled_stats = {};
+
+	try
+	{
+		for (uint32_t frame = 0; frame < total_frames; ++frame)
+		{
+			auto const frame_begin = std::chrono::high_resolution_clock::now();
+			const float time = static_cast<float>(frame) * BENCHMARK_TIME_STEP;
+
+			/* Camera */
+			vulkanRenderer->UpdateCameraPosition(camera_path.Evaluate(time));
+
+			/* Lights Movement */
+			updateLights(time);
+
+			const uint64_t frame_number = vulkanRenderer->GetFrameCount();
+			vulkanRenderer->Draw(nullptr);
+
+			const double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frame_begin).count();
+			report.AddFrameSample(frame_number, frame_ms, frame_ms - vulkanRenderer->GetLastFenceWaitTime());
+
+			const GPUTimings& gpu_timings = vulkanRenderer->GetGPUTimings();
+
+			if (gpu_timings.valid)
+				report.SetGPUSample(gpu_timings.frame_number, gpu_timings.frame_ms);
+
+			const TiledLightingStats& tiled_stats = vulkanRenderer->GetTiledLightingStats();
+			worst_tiled_stats.overflow_tiles	= std::max(worst_tiled_stats.overflow_tiles, tiled_stats.overflow_tiles);
+			worst_tiled_stats.max_tile_lights	= std::max(worst_tiled_stats.max_tile_lights, tiled_stats.max_tile_lights);
+		}
+	}
+	catch (std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		vulkanRenderer->Cleanup();
+		return EXIT_FAILURE;
+	}
+
+	vulkanRenderer->Cleanup();
+
+	report.PrintSummary(std::cout);
+
+	if (options.lighting == "tiled")
+	{
+		std::cout << "Tiled lighting: up to " << worst_tiled_stats.max_tile_lights << " lights in a tile" << std::endl;
+
+		if (worst_tiled_stats.overflow_tiles > 0)
+			std::cerr << "Warning: " << worst_tiled_stats.overflow_tiles << " tiles over the limit of " << TILED_MAX_LIGHTS_PER_TILE
+					  << " lights, their extra lights were not shaded" << std::endl;
+	}
+
+	try
+	{
+		if (options.format == "json")
+			report.WriteJSON(options.output);
+		else
+			report.WriteCSV(options.output);
+	}
+	catch (std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "Results written to " << options.output << std::endl;
+
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 
 #include "CommandHandler.h"
+#include "ThreadPool.h"
 
 CommandHandler::CommandHandler()
 {
@@ -50,20 +51,88 @@ void CommandHandler::CreateCommandBuffers(size_t const numFrameBuffers)
 		throw std::runtime_error("Failed to allocate Command Buffers!");
 }
 
-void CommandHandler::RecordOffScreenCommands(ImDrawData* draw_data, uint32_t currentImage, VkExtent2D& imageExtent,
-	std::vector<VkFramebuffer>& offScreenFrameBuffers, std::vector<Mesh>& meshList, std::vector<MeshModel>& modelList,
-	TextureObjects& textureObjects, std::vector<VkDescriptorSet>& descriptorSets, std::vector<VkDescriptorSet>& inputDescriptorSet,
-	std::vector<BufferImage>& position_image, std::vector<BufferImage>& colour_image, std::vector<BufferImage>& normal_image, QueueFamilyIndices queueFamilyIndices)
+void CommandHandler::CreateSecondaryCommandBuffers(QueueFamilyIndices& queueIndices, size_t const numFrameBuffers)
 {
+	m_OffScreenImageCount = numFrameBuffers;
+	m_SecondaryRecorders.resize(MAX_FRAMES_IN_FLIGHT * numFrameBuffers);
+	m_OffScreenRecorded.assign(m_SecondaryRecorders.size(), OffScreenRecordState());
+
+	// Un job per worker piu' quello registrato dal main thread
+	const uint32_t recorder_count = ThreadPool::GetInstance()->GetWorkerCount() + 1;
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType				= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags				= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;	// Resettati in blocco ogni frame con vkResetCommandPool
+	pool_info.queueFamilyIndex	= queueIndices.GraphicsFamily;
+
+	VkCommandBufferAllocateInfo alloc_info = {};
+	alloc_info.sType				= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.level				= VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	alloc_info.commandBufferCount	= 1;
+
+	// A command pool can be used by one thread at a time: every job of every (frame slot, image) pair has its own
+	for (auto& recorders : m_SecondaryRecorders)
+	{
+		recorders.resize(recorder_count);
+
+		for (auto& recorder : recorders)
+		{
+			VkResult res = vkCreateCommandPool(m_MainDevice->LogicalDevice, &pool_info, nullptr, &recorder.Pool);
+
+			if (res != VK_SUCCESS)
+				throw std::runtime_error("Failed to create a secondary Command Pool!");
+
+			alloc_info.commandPool = recorder.Pool;
+
+			res = vkAllocateCommandBuffers(m_MainDevice->LogicalDevice, &alloc_info, &recorder.Buffer);
+
+			if (res != VK_SUCCESS)
+				throw std::runtime_error("Failed to allocate a secondary Command Buffer!");
+		}
+	}
+}
+
+// Returns false when the command buffer of the frame slot and image already holds this frame's commands and is submitted again as is
+bool CommandHandler::RecordOffScreenCommands(ImDrawData* draw_data, uint32_t currentImage, uint32_t current_frame, uint64_t scene_version, VkExtent2D& imageExtent,
+	std::vector<VkFramebuffer>& offScreenFrameBuffers, std::vector<Mesh>& meshList, const DrawList& draw_list,
+	TextureObjects& textureObjects, VkDescriptorSet& view_projection_set, VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets, std::vector<VkDescriptorSet>& inputDescriptorSet,
+	std::vector<BufferImage>& depth_image, std::vector<BufferImage>& colour_image, std::vector<BufferImage>& normal_image,
+	const HiZPyramid& hiz, std::vector<VkDescriptorSet>& hiz_sets, VkDescriptorSet& cull_set, QueueFamilyIndices queueFamilyIndices)
+{
+	if (currentImage >= m_OffScreenImageCount)
+		throw std::runtime_error("Offscreen command buffers created for fewer swap chain images!");
+
+	const size_t slot = OffScreenSlot(current_frame, currentImage);
+
+	// Le model matrix e la camera cambiano solo il contenuto dei buffer, non i comandi: si ri-registra per un nuovo
+	// framebuffer, offset diversi, una scena diversa (nuovo DrawList) o un nuovo ordine dei batch
+	OffScreenRecordState state;
+	state.Valid					= true;
+	state.Framebuffer			= offScreenFrameBuffers[currentImage];
+	state.Extent				= imageExtent;
+	state.ViewProjectionOffset	= uniform_offsets.ViewProjection;
+	state.ObjectsOffset			= uniform_offsets.Objects;
+	state.CullingOffset			= uniform_offsets.Culling;
+	state.SceneVersion			= scene_version;
+	state.DrawOrder				= draw_list.GetOrderVersion();
+
+	if (m_OffScreenRecorded[slot] == state)
+	{
+		// The timestamps of the slot are reset and written again by the resubmitted buffer
+		if (m_Profiler)
+			m_Profiler->MarkRecorded();
+
+		return false;
+	}
+
 	VkCommandBufferBeginInfo buffer_begin_info = {};
 	buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; // Il buffer pu essere re-inviato al momento della resubmit
 
-	std::array<VkClearValue, 4> clear_values;
-	clear_values[0].color = { 0.0f, 0.0f, 0.0f, 0.0f }; // Position
-	clear_values[1].color = { 0.0f, 0.0f, 0.0f, 0.0f }; // Colour
-	clear_values[2].color = { 0.0f, 0.0f, 0.0f, 0.0f }; // Normal
-	clear_values[3].depthStencil.depth = 1.0f;
+	std::array<VkClearValue, 3> clear_values;
+	clear_values[0].color = { 0.0f, 0.0f, 0.0f, 0.0f }; // Colour
+	clear_values[1].color = { 0.0f, 0.0f, 0.0f, 0.0f }; // Normal
+	clear_values[2].depthStencil.depth = 1.0f;			// Depth = 1 -> nessuna geometria, il lighting pass lo tratta come sfondo
 
 	VkRenderPassBeginInfo renderpass_begin_info = {};
 	renderpass_begin_info.sType				= VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -74,61 +143,329 @@ void CommandHandler::RecordOffScreenCommands(ImDrawData* draw_data, uint32_t cur
 	renderpass_begin_info.clearValueCount	= static_cast<uint32_t>(clear_values.size());	
 	renderpass_begin_info.framebuffer		= offScreenFrameBuffers[currentImage];
 
-	VkResult res = vkBeginCommandBuffer(m_CommandBuffers[currentImage], &buffer_begin_info);
+	// I job si dividono i batch del DrawList nell'ordine della render queue (una draw indirect ciascuno), le scene piccole restano sul main thread
+	std::vector<SecondaryRecorder>& recorders = m_SecondaryRecorders[slot];
+
+	const size_t batch_count	= draw_list.GetBatches().size();
+	const size_t job_count		= std::max<size_t>(1, std::min<size_t>(recorders.size(),
+		(batch_count + MIN_BATCHES_PER_SECONDARY - 1) / MIN_BATCHES_PER_SECONDARY));
+	const size_t batches_per_job = (batch_count + job_count - 1) / job_count;
+
+	// The fence of current_frame has been waited: the primary and the secondaries of this slot (only submitted by this frame slot) are no longer in use
+	for (size_t i = 0; i < job_count; ++i)
+		vkResetCommandPool(m_MainDevice->LogicalDevice, recorders[i].Pool, 0);
+
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType			= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.renderPass		= renderpass_begin_info.renderPass;
+	inheritance_info.subpass		= 0;
+	inheritance_info.framebuffer	= renderpass_begin_info.framebuffer;
+
+	std::vector<std::future<void>> jobs;
+	jobs.reserve(job_count - 1);
+
+	for (size_t i = 1; i < job_count; ++i)
+	{
+		const size_t first = i * batches_per_job;
+		const size_t count = std::min(batches_per_job, batch_count - std::min(first, batch_count));
+
+		jobs.push_back(ThreadPool::GetInstance()->Submit([this, &recorders, &inheritance_info, &draw_list, &textureObjects, &view_projection_set, &object_set, &uniform_offsets, i, first, count]() {
+			RecordOffScreenDraws(recorders[i].Buffer, inheritance_info, draw_list, first, count, textureObjects, view_projection_set, object_set, uniform_offsets);
+		}));
+	}
+
+	RecordOffScreenDraws(recorders[0].Buffer, inheritance_info, draw_list, 0, std::min(batches_per_job, batch_count),
+		textureObjects, view_projection_set, object_set, uniform_offsets);
+
+	// get() rilancia l'eccezione del worker, va comunque atteso ogni job prima di uscire
+	std::exception_ptr job_error;
+
+	for (auto& job : jobs)
+	{
+		try { job.get(); }
+		catch (...) { if (!job_error) job_error = std::current_exception(); }
+	}
+
+	if (job_error)
+		std::rethrow_exception(job_error);
+
+	VkCommandBuffer command_buffer = m_CommandBuffers[slot];
+
+	VkResult res = vkBeginCommandBuffer(command_buffer, &buffer_begin_info);
 
 	if (res != VK_SUCCESS)
 		throw std::runtime_error("Failed to start recording a Command Buffer!");
 
-	// Offscreen render pass
-	vkCmdBeginRenderPass(m_CommandBuffers[currentImage], &renderpass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(m_CommandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetPipeline());
+	// The offscreen buffer is the first one submitted in the frame
+	if (m_Profiler)
+	{
+		m_Profiler->ResetQueries(command_buffer);
+		m_Profiler->WriteTimestamp(command_buffer, QUERY_FRAME_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+	}
+
+	// Frustum + occlusion culling prima del render pass: le draw leggono i comandi visibili scritti qui
+	const bool culling = draw_list.IsCullingEnabled();
+
+	if (culling)
+		RecordCulling(command_buffer, draw_list, cull_set, object_set, uniform_offsets);
+
+	if (m_Profiler)
+		m_Profiler->WriteTimestamp(command_buffer, QUERY_GBUFFER_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+	// Offscreen render pass: il contenuto arriva solo dai secondary command buffers
+	vkCmdBeginRenderPass(command_buffer, &renderpass_begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	std::vector<VkCommandBuffer> secondaries(job_count);
+
+	for (size_t i = 0; i < job_count; ++i)
+		secondaries[i] = recorders[i].Buffer;
 
-	for (size_t j = 0; j < modelList.size(); ++j)
+	vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+
+	vkCmdEndRenderPass(command_buffer);
+
+	if (m_Profiler)
+		m_Profiler->WriteTimestamp(command_buffer, QUERY_GBUFFER_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+	// La depth appena scritta diventa la Hi-Z con cui il frame successivo fa l'occlusion culling
+	if (culling)
+		RecordHiZBuild(command_buffer, currentImage, depth_image.size(), hiz, hiz_sets);
+
+	res = vkEndCommandBuffer(command_buffer);
+
+	if (res != VK_SUCCESS)
 	{
-		MeshModel mesh_model = modelList[j];
-		Model m;
-		m.model = mesh_model.GetModel();
+		throw std::runtime_error("Failed to stop recording offscreen Command Buffer!");
+	}
 
-		vkCmdPushConstants(m_CommandBuffers[currentImage], m_GraphicPipeline->GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Model), &m);
+	m_OffScreenRecorded[slot] = state;
 
-		for (size_t k = 0; k < mesh_model.GetMeshCount(); k++)
-		{
-			VkBuffer vertexBuffers[] = { mesh_model.GetMesh(k)->getVertexBuffer() };
-			VkDeviceSize offsets[] = { 0 };
+	return true;
+}
 
-			vkCmdBindVertexBuffers(m_CommandBuffers[currentImage], 0, 1, vertexBuffers, offsets);
+// Due dispatch: un thread per istanza (le visibili compattate per comando), poi un thread per comando indirect:
+// i comandi con istanze visibili finiscono nel culled buffer, compattati per batch se c'e' il count buffer
+void CommandHandler::RecordCulling(VkCommandBuffer command_buffer, const DrawList& draw_list, VkDescriptorSet& cull_set,
+	VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets)
+{
+	// Il frame precedente legge ancora comandi e contatori (draw indirect) e istanze (vertex) e ha scritto la Hi-Z (compute)
+	VkMemoryBarrier reuse_barrier = {};
+	reuse_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	reuse_barrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	reuse_barrier.dstAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
-			vkCmdBindIndexBuffer(m_CommandBuffers[currentImage], mesh_model.GetMesh(k)->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+		0, 1, &reuse_barrier, 0, nullptr, 0, nullptr);
 
-			std::array<VkDescriptorSet, 2> desc_set_group = {
-				descriptorSets[currentImage],
-				textureObjects.SamplerDescriptorSets[mesh_model.GetMesh(k)->getTexID()]
-			};
+	vkCmdFillBuffer(command_buffer, draw_list.GetCountBuffer(), 0, VK_WHOLE_SIZE, 0);
+	vkCmdFillBuffer(command_buffer, draw_list.GetInstanceCountBuffer(), 0, VK_WHOLE_SIZE, 0);
 
-			vkCmdBindDescriptorSets(m_CommandBuffers[currentImage], VK_PIPELINE_BIND_POINT_GRAPHICS,
-				m_GraphicPipeline->GetLayout(), 0, static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(), 0, nullptr);
+	VkMemoryBarrier clear_barrier = {};
+	clear_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clear_barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+	clear_barrier.dstAccessMask	= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
-			vkCmdDrawIndexed(m_CommandBuffers[currentImage], mesh_model.GetMesh(k)->getIndexCount(), 1, 0, 0, 0);
-		}
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->GetInstanceCullingPipeline());
+
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_ComputePipeline->GetCullingLayout(), 0, 1, &cull_set, 1, &uniform_offsets.Culling);
+
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_ComputePipeline->GetCullingLayout(), 1, 1, &object_set, 1, &uniform_offsets.Objects);
+
+	vkCmdDispatch(command_buffer, (draw_list.GetInstanceCount() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	// Il passo sui comandi legge i contatori delle istanze visibili
+	VkMemoryBarrier instances_barrier = {};
+	instances_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	instances_barrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	instances_barrier.dstAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &instances_barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->GetCullingPipeline());
+
+	vkCmdDispatch(command_buffer, (draw_list.GetCommandCount() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	// Comandi e contatori per le draw indirect, istanze visibili per il vertex shader del G-buffer
+	VkMemoryBarrier culled_barrier = {};
+	culled_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	culled_barrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	culled_barrier.dstAccessMask	= VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		0, 1, &culled_barrier, 0, nullptr, 0, nullptr);
+}
+
+// Riduzione max 2x2 mip per mip: la mip 0 legge la depth del G-buffer di currentImage, le altre la mip precedente
+void CommandHandler::RecordHiZBuild(VkCommandBuffer command_buffer, uint32_t currentImage, size_t image_count, const HiZPyramid& hiz,
+	std::vector<VkDescriptorSet>& hiz_sets)
+{
+	// La Hi-Z e' appena stata letta dal culling di questo frame (la depth e' coperta dalla dependency del render pass)
+	VkMemoryBarrier read_barrier = {};
+	read_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	read_barrier.srcAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+	read_barrier.dstAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &read_barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->GetHiZPipeline());
+
+	VkMemoryBarrier level_barrier = {};
+	level_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	level_barrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	level_barrier.dstAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+
+	for (size_t mip = 0; mip < hiz.MipExtents.size(); ++mip)
+	{
+		VkDescriptorSet& level_set = mip == 0 ? hiz_sets[currentImage] : hiz_sets[image_count + mip - 1];
+
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			m_ComputePipeline->GetHiZLayout(), 0, 1, &level_set, 0, nullptr);
+
+		vkCmdDispatch(command_buffer,
+			(hiz.MipExtents[mip].width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+			(hiz.MipExtents[mip].height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+		// La mip successiva (o il culling del prossimo frame) legge questa
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &level_barrier, 0, nullptr, 0, nullptr);
 	}
+}
 
-	vkCmdEndRenderPass(m_CommandBuffers[currentImage]);
+// Records the batches at [first_batch, first_batch + batch_count) of the draw list order, called from any thread
+void CommandHandler::RecordOffScreenDraws(VkCommandBuffer command_buffer, const VkCommandBufferInheritanceInfo& inheritance_info,
+	const DrawList& draw_list, size_t first_batch, size_t batch_count, TextureObjects& textureObjects, VkDescriptorSet& view_projection_set,
+	VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets)
+{
+	// Niente ONE_TIME_SUBMIT: il primary che li esegue viene re-inviato finche' la scena non cambia
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType			= VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags			= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	begin_info.pInheritanceInfo = &inheritance_info;
 
-	res = vkEndCommandBuffer(m_CommandBuffers[currentImage]);
+	VkResult res = vkBeginCommandBuffer(command_buffer, &begin_info);
 
 	if (res != VK_SUCCESS)
+		throw std::runtime_error("Failed to start recording a secondary Command Buffer!");
+
+	// Un secondary non eredita lo stato del primary: pipeline e set vanno ri-bindati
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetPipeline());
+
+	// View-Projection (set 0) e object buffer (set 2) sono gli stessi per ogni draw, cambia solo la texture (set 1)
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		m_GraphicPipeline->GetLayout(), 0, 1, &view_projection_set, 1, &uniform_offsets.ViewProjection);
+
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		m_GraphicPipeline->GetLayout(), 2, 1, &object_set, 1, &uniform_offsets.Objects);
+
+	// Texture bindless: l'array di tutte le texture sta nel set 1 per tutto il secondary, nessun bind per batch
+	const bool bindless = textureObjects.BindlessDescriptorSet != VK_NULL_HANDLE;
+
+	if (bindless)
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicPipeline->GetLayout(), 1, 1, &textureObjects.BindlessDescriptorSet, 0, nullptr);
+
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	const std::vector<VkDrawIndexedIndirectCommand>& commands = draw_list.GetCommands();
+
+	// Con il culling le draw leggono i comandi scritti dal compute shader
+	const bool culling				= draw_list.IsCullingEnabled();
+	const VkBuffer indirect_buffer	= culling ? draw_list.GetCulledBuffer() : draw_list.GetBuffer();
+
+	// Batch ordinati per texture e profondita': ogni bind che non cambia lo stato viene saltato
+	int		 last_texture		= -1;
+	VkBuffer last_vertex_buffer	= VK_NULL_HANDLE;
+	VkBuffer last_index_buffer	= VK_NULL_HANDLE;
+
+	for (size_t i = first_batch; i < first_batch + batch_count; ++i)
 	{
-		throw std::runtime_error("Failed to stop recording offscreen Command Buffer!");
+		const uint32_t b		= draw_list.GetBatchOrder()[i];
+		const DrawBatch& batch	= draw_list.GetBatches()[b];
+
+		if (batch.Geometry->getVertexBuffer() != last_vertex_buffer)
+		{
+			last_vertex_buffer = batch.Geometry->getVertexBuffer();
+
+			VkBuffer vertexBuffers[] = { last_vertex_buffer };
+			VkDeviceSize offsets[] = { 0 };
+
+			vkCmdBindVertexBuffers(command_buffer, 0, 1, vertexBuffers, offsets);
+		}
+
+		if (batch.Geometry->getIndexBuffer() != last_index_buffer)
+		{
+			last_index_buffer = batch.Geometry->getIndexBuffer();
+
+			vkCmdBindIndexBuffer(command_buffer, last_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+
+		if (!bindless && batch.Geometry->getTexID() != last_texture)
+		{
+			last_texture = batch.Geometry->getTexID();
+
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_GraphicPipeline->GetLayout(), 1, 1, &textureObjects.SamplerDescriptorSets[last_texture], 0, nullptr);
+		}
+
+		// firstInstance = prima draw instance: il vertex shader legge oggetto e texture con gl_InstanceIndex
+		if (culling && m_MainDevice->DrawIndexedIndirectCount)
+		{
+			// Comandi compattati in testa al batch, il numero dei visibili e' nel count buffer
+			m_MainDevice->DrawIndexedIndirectCount(command_buffer, indirect_buffer,
+				static_cast<VkDeviceSize>(batch.FirstCommand) * stride,
+				draw_list.GetCountBuffer(), static_cast<VkDeviceSize>(b) * sizeof(uint32_t), batch.CommandCount, stride);
+		}
+		else if (m_MainDevice->MultiDrawIndirect && m_MainDevice->DrawIndirectFirstInstance)
+		{
+			vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer,
+				static_cast<VkDeviceSize>(batch.FirstCommand) * stride, batch.CommandCount, stride);
+		}
+		else if (m_MainDevice->DrawIndirectFirstInstance)
+		{
+			for (uint32_t c = 0; c < batch.CommandCount; ++c)
+				vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer,
+					static_cast<VkDeviceSize>(batch.FirstCommand + c) * stride, 1, stride);
+		}
+		else
+		{
+			// Senza drawIndirectFirstInstance il firstInstance dei comandi indirect deve essere 0: draw dirette (instanced)
+			for (uint32_t c = batch.FirstCommand; c < batch.FirstCommand + batch.CommandCount; ++c)
+				vkCmdDrawIndexed(command_buffer, commands[c].indexCount, commands[c].instanceCount, commands[c].firstIndex,
+					commands[c].vertexOffset, commands[c].firstInstance);
+		}
 	}
+
+	res = vkEndCommandBuffer(command_buffer);
+
+	if (res != VK_SUCCESS)
+		throw std::runtime_error("Failed to stop recording a secondary Command Buffer!");
 }
 
 void CommandHandler::RecordCommands(
 	ImDrawData* draw_data, uint32_t current_img, VkExtent2D& imageExtent,
 	std::vector<VkFramebuffer>& frameBuffers,
-	std::vector<VkDescriptorSet>& light_desc_sets,
+	VkDescriptorSet& light_desc_set,
 	std::vector<VkDescriptorSet>& inputDescriptorSet,
-	std::vector<VkDescriptorSet>& settings_desc_set)
+	VkDescriptorSet& settings_desc_set,
+	VkDescriptorSet& view_projection_set,
+	const FrameUniformOffsets& uniform_offsets,
+	std::vector<VkDescriptorSet>& tiled_lighting_sets,
+	std::vector<VkDescriptorSet>& composite_sets,
+	std::vector<BufferImage>& lighting_image,
+	VkDescriptorSet& cluster_set,
+	int lighting_mode,
+	uint32_t light_count)
 {
+	const bool tiled_lighting = lighting_mode == LIGHTING_TILED;
+
 	VkCommandBufferBeginInfo buffer_begin_info = {};
 	buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; // Il buffer pu essere re-inviato al momento della resubmit
@@ -151,32 +488,148 @@ void CommandHandler::RecordCommands(
 	if (res != VK_SUCCESS)
 		throw std::runtime_error("Failed to start recording the Command Buffer for the presentation!"); 
 
+	// Il compute shader non pu stare dentro un render pass: illumina prima, il render pass compone e disegna la GUI
+	if (tiled_lighting)
+	{
+		if (m_Profiler)
+			m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_LIGHTING_BEGIN, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		RecordTiledLighting(current_img, imageExtent, inputDescriptorSet, tiled_lighting_sets,
+			view_projection_set, settings_desc_set, uniform_offsets, lighting_image[current_img]);
+	}
+
 	// View render pass
 	vkCmdBeginRenderPass(m_CommandBuffers[current_img], &renderpass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
-	vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetSecondPipeline());
+	if (tiled_lighting)
+	{
+		vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetCompositePipeline());
+
+		vkCmdBindDescriptorSets(
+			m_CommandBuffers[current_img],
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicPipeline->GetCompositeLayout(), 0,
+			1, &composite_sets[current_img],
+			0, nullptr);
+
+		vkCmdDraw(m_CommandBuffers[current_img], 3, 1, 0, 0);
+	}
+	else if (lighting_mode == LIGHTING_CLUSTERED)
+	{
+		vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetClusteredPipeline());
+
+		std::array<VkDescriptorSet, 4> desc_set_group =
+		{
+			inputDescriptorSet[current_img],
+			cluster_set,
+			settings_desc_set,
+			view_projection_set
+		};
+
+		// Set 1 ha due dynamic storage buffer: luci e cluster, nell'ordine dei binding
+		std::array<uint32_t, 4> dynamic_offsets = { uniform_offsets.Lights, uniform_offsets.Clusters, uniform_offsets.Settings, uniform_offsets.ViewProjection };
+
+		vkCmdBindDescriptorSets(
+			m_CommandBuffers[current_img],
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicPipeline->GetClusteredLayout(), 0,
+			static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(),
+			static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
 
+		if (m_Profiler)
+			m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_LIGHTING_BEGIN, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		vkCmdDraw(m_CommandBuffers[current_img], 3, 1, 0, 0);
+	}
+	else if (lighting_mode == LIGHTING_VOLUMES)
 	{
-		std::array<VkDescriptorSet, 3> desc_set_group =
+		if (m_Profiler)
+			m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_LIGHTING_BEGIN, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		// La depth del G-buffer finisce nel depth attachment, i volumi la testano senza scriverla
+		vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetDepthPrimePipeline());
+
+		vkCmdBindDescriptorSets(
+			m_CommandBuffers[current_img],
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicPipeline->GetDepthPrimeLayout(), 0,
+			1, &inputDescriptorSet[current_img],
+			0, nullptr);
+
+		vkCmdDraw(m_CommandBuffers[current_img], 3, 1, 0, 0);
+
+		vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetLightVolumePipeline());
+
+		std::array<VkDescriptorSet, 4> desc_set_group =
 		{
 			inputDescriptorSet[current_img],
-			light_desc_sets[current_img],
-			settings_desc_set[current_img]
+			cluster_set,
+			settings_desc_set,
+			view_projection_set
 		};
 
+		// Il binding dei cluster non  letto, il suo offset resta quello (valido) dell'inizio del ring
+		std::array<uint32_t, 4> dynamic_offsets = { uniform_offsets.Lights, uniform_offsets.Clusters, uniform_offsets.Settings, uniform_offsets.ViewProjection };
+
+		vkCmdBindDescriptorSets(
+			m_CommandBuffers[current_img],
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicPipeline->GetLightVolumeLayout(), 0,
+			static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(),
+			static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+		// Un'istanza della sfera per luce
+		vkCmdDraw(m_CommandBuffers[current_img], LIGHT_VOLUME_VERTEX_COUNT, light_count, 0, 0);
+	}
+	else
+	{
+		vkCmdBindPipeline(m_CommandBuffers[current_img], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicPipeline->GetSecondPipeline());
+
+		std::array<VkDescriptorSet, 4> desc_set_group =
+		{
+			inputDescriptorSet[current_img],
+			light_desc_set,
+			settings_desc_set,
+			view_projection_set
+		};
+
+		// Un dynamic offset per ogni dynamic uniform buffer, nell'ordine dei set
+		std::array<uint32_t, 3> dynamic_offsets = { uniform_offsets.Lights, uniform_offsets.Settings, uniform_offsets.ViewProjection };
+
 		vkCmdBindDescriptorSets(
 			m_CommandBuffers[current_img], 
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_GraphicPipeline->GetSecondLayout(), 0, 
-			static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(), 0, nullptr);
+			static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(),
+			static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+		// BOTTOM_OF_PIPE timestamps are written once every previous command has completed,
+		// so the fullscreen triangle and the GUI are measured one after the other
+		if (m_Profiler)
+			m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_LIGHTING_BEGIN, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		vkCmdDraw(m_CommandBuffers[current_img], 3, 1, 0, 0);
 	}
 
-	vkCmdDraw(m_CommandBuffers[current_img], 3, 1, 0, 0);
+	// Tiled: il tempo di lighting comprende dispatch e composizione
+	if (m_Profiler)
+	{
+		m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_LIGHTING_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+		m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_IMGUI_BEGIN, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+	}
 
-	ImGui_ImplVulkan_RenderDrawData(draw_data, m_CommandBuffers[current_img]);
+	// No GUI draw data when rendering headless
+	if (draw_data)
+		ImGui_ImplVulkan_RenderDrawData(draw_data, m_CommandBuffers[current_img]);
+
+	if (m_Profiler)
+		m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_IMGUI_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
 	vkCmdEndRenderPass(m_CommandBuffers[current_img]);
 
+	if (m_Profiler)
+		m_Profiler->WriteTimestamp(m_CommandBuffers[current_img], QUERY_FRAME_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
 	res = vkEndCommandBuffer(m_CommandBuffers[current_img]);
 
 	if (res != VK_SUCCESS)
@@ -185,11 +638,89 @@ void CommandHandler::RecordCommands(
 	}
 }
 
+void CommandHandler::RecordTiledLighting(uint32_t current_img, VkExtent2D& imageExtent,
+	std::vector<VkDescriptorSet>& inputDescriptorSet, std::vector<VkDescriptorSet>& tiled_lighting_sets,
+	VkDescriptorSet& view_projection_set, VkDescriptorSet& settings_desc_set,
+	const FrameUniformOffsets& uniform_offsets, BufferImage& lighting_image)
+{
+	VkCommandBuffer command_buffer = m_CommandBuffers[current_img];
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.image							= lighting_image.Image;
+	barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel	= 0;
+	barrier.subresourceRange.levelCount		= 1;
+	barrier.subresourceRange.baseArrayLayer	= 0;
+	barrier.subresourceRange.layerCount		= 1;
+
+	// Il contenuto precedente non serve (UNDEFINED), basta che la composizione dell'ultimo uso sia terminata
+	barrier.oldLayout		= VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout		= VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcAccessMask	= 0;
+	barrier.dstAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &barrier);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->GetTiledLightingPipeline());
+
+	std::array<VkDescriptorSet, 4> desc_set_group =
+	{
+		inputDescriptorSet[current_img],
+		tiled_lighting_sets[current_img],
+		view_projection_set,
+		settings_desc_set
+	};
+
+	// Un dynamic offset per ogni dynamic buffer, nell'ordine dei set e dei binding (luci e contatori nel set 1)
+	std::array<uint32_t, 4> dynamic_offsets = { uniform_offsets.Lights, uniform_offsets.TiledStats, uniform_offsets.ViewProjection, uniform_offsets.Settings };
+
+	vkCmdBindDescriptorSets(
+		command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_ComputePipeline->GetTiledLightingLayout(), 0,
+		static_cast<uint32_t>(desc_set_group.size()), desc_set_group.data(),
+		static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+	// Un workgroup per tile, le tile sul bordo sono parziali
+	const uint32_t tiles_x = (imageExtent.width + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE;
+	const uint32_t tiles_y = (imageExtent.height + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE;
+
+	vkCmdDispatch(command_buffer, tiles_x, tiles_y, 1);
+
+	// Scrittura del compute -> lettura nel fragment shader della composizione
+	barrier.oldLayout		= VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 void CommandHandler::DestroyCommandPool()
 {
 	vkDestroyCommandPool(m_MainDevice->LogicalDevice, m_GraphicsComandPool, nullptr);
 }
 
+void CommandHandler::DestroySecondaryCommandBuffers()
+{
+	// Distruggere il pool libera anche il suo command buffer
+	for (auto& recorders : m_SecondaryRecorders)
+	{
+		for (auto& recorder : recorders)
+			vkDestroyCommandPool(m_MainDevice->LogicalDevice, recorder.Pool, nullptr);
+	}
+
+	m_SecondaryRecorders.clear();
+	m_OffScreenRecorded.clear();
+}
+
 void CommandHandler::FreeCommandBuffers()
 {
 	vkFreeCommandBuffers(m_MainDevice->LogicalDevice, m_GraphicsComandPool, static_cast<uint32_t>(m_CommandBuffers.size()), m_CommandBuffers.data());
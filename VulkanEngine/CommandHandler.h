@@ -3,14 +3,47 @@
 #include "pch.h"
 
 #include "GraphicPipeline.h"
+#include "ComputePipeline.h"
 #include "RenderPassHandler.h"
 #include "Mesh.h"
 #include "MeshModel.h"
+#include "GPUProfiler.h"
+#include "UniformRing.h"
+#include "Light.h"
+#include "DrawList.h"
 
 struct RecordObjects {
 	TextureObjects TextureObjects;
 };
 
+constexpr uint32_t MIN_BATCHES_PER_SECONDARY = 64;	// Below this a worker thread costs more than the draw calls it records
+
+// Secondary command buffer of the offscreen pass, with its own pool: one per recording job and frame in flight
+struct SecondaryRecorder {
+	VkCommandPool	Pool	= VK_NULL_HANDLE;
+	VkCommandBuffer Buffer	= VK_NULL_HANDLE;
+};
+
+// Everything baked in an offscreen command buffer: while it does not change the buffer is submitted again as is
+struct OffScreenRecordState {
+	bool			Valid					= false;
+	VkFramebuffer	Framebuffer				= VK_NULL_HANDLE;
+	VkExtent2D		Extent					= {};
+	uint32_t		ViewProjectionOffset	= 0;
+	uint32_t		ObjectsOffset			= 0;
+	uint32_t		CullingOffset			= 0;
+	uint64_t		SceneVersion			= 0;
+	uint64_t		DrawOrder				= 0;	// DrawList::GetOrderVersion, cambia quando i batch si riordinano
+
+	bool operator==(const OffScreenRecordState& other) const
+	{
+		return Valid == other.Valid && Framebuffer == other.Framebuffer &&
+			Extent.width == other.Extent.width && Extent.height == other.Extent.height &&
+			ViewProjectionOffset == other.ViewProjectionOffset && ObjectsOffset == other.ObjectsOffset && CullingOffset == other.CullingOffset &&
+			SceneVersion == other.SceneVersion && DrawOrder == other.DrawOrder;
+	}
+};
+
 class CommandHandler
 {
 public:
@@ -19,28 +52,72 @@ public:
 
 	void CreateCommandPool(QueueFamilyIndices& queueIndices);
 	void CreateCommandBuffers(size_t const numFrameBuffers);
-	void RecordOffScreenCommands(ImDrawData* draw_data, uint32_t currentImage, VkExtent2D& imageExtent, 
-		std::vector<VkFramebuffer>& offScreenFrameBuffers, std::vector<Mesh>& meshList, std::vector<MeshModel>& modelList,
-		TextureObjects& textureObjects, std::vector<VkDescriptorSet>& descriptorSets, std::vector<VkDescriptorSet>& inputDescriptorSet,
-		std::vector<BufferImage>& position_image, std::vector<BufferImage>& colour_image, std::vector<BufferImage>& normal_image, QueueFamilyIndices queueFamilyIndices);
+	void CreateSecondaryCommandBuffers(QueueFamilyIndices& queueIndices, size_t const numFrameBuffers);
+	bool RecordOffScreenCommands(ImDrawData* draw_data, uint32_t currentImage, uint32_t current_frame, uint64_t scene_version, VkExtent2D& imageExtent, 
+		std::vector<VkFramebuffer>& offScreenFrameBuffers, std::vector<Mesh>& meshList, const DrawList& draw_list,
+		TextureObjects& textureObjects, VkDescriptorSet& view_projection_set, VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets, std::vector<VkDescriptorSet>& inputDescriptorSet,
+		std::vector<BufferImage>& depth_image, std::vector<BufferImage>& colour_image, std::vector<BufferImage>& normal_image,
+		const HiZPyramid& hiz, std::vector<VkDescriptorSet>& hiz_sets, VkDescriptorSet& cull_set, QueueFamilyIndices queueFamilyIndices);
 	void RecordCommands(ImDrawData* draw_data, uint32_t current_img, VkExtent2D& imageExtent,
 		std::vector<VkFramebuffer>& frameBuffers,
-		std::vector<VkDescriptorSet>& light_desc_sets,
+		VkDescriptorSet& light_desc_set,
 		std::vector<VkDescriptorSet>& inputDescriptorSet,
-		std::vector<VkDescriptorSet>& settings_desc_set);
+		VkDescriptorSet& settings_desc_set,
+		VkDescriptorSet& view_projection_set,
+		const FrameUniformOffsets& uniform_offsets,
+		std::vector<VkDescriptorSet>& tiled_lighting_sets,
+		std::vector<VkDescriptorSet>& composite_sets,
+		std::vector<BufferImage>& lighting_image,
+		VkDescriptorSet& cluster_set,
+		int lighting_mode,
+		uint32_t light_count);
 
 	void DestroyCommandPool();
+	void DestroySecondaryCommandBuffers();
 	void FreeCommandBuffers();
 
+	void SetProfiler(GPUProfiler* profiler)					{ m_Profiler = profiler; }
+	void SetComputePipeline(ComputePipeline* pipeline)		{ m_ComputePipeline = pipeline; }
+	// Un set letto dai command buffer offscreen e' stato riscritto: vanno tutti ri-registrati
+	void InvalidateOffScreenCommands()						{ m_OffScreenRecorded.assign(m_OffScreenRecorded.size(), OffScreenRecordState()); }
+
 	VkCommandPool& GetCommandPool()							{ return m_GraphicsComandPool; }
 	VkCommandBuffer& GetCommandBuffer(uint32_t const index) { return m_CommandBuffers[index]; }
+	VkCommandBuffer& GetOffScreenCommandBuffer(uint32_t const current_frame, uint32_t const current_image) { return m_CommandBuffers[OffScreenSlot(current_frame, current_image)]; }
 	std::vector<VkCommandBuffer>& GetCommandBuffers()		{ return m_CommandBuffers; }
 
 private:
 	MainDevice			*m_MainDevice;
 	RenderPassHandler	*m_RenderPassHandler;
 	GraphicPipeline		*m_GraphicPipeline;
+	GPUProfiler			*m_Profiler = nullptr;
+	ComputePipeline		*m_ComputePipeline = nullptr;
 	
 	VkCommandPool	m_GraphicsComandPool;
 	std::vector<VkCommandBuffer> m_CommandBuffers;
+
+	// Offscreen: un primary per coppia (frame in flight, immagine), ri-registrato solo se cambia qualcosa di quello che contiene.
+	// Con un solo buffer per frame slot le immagini (piu' dei frame in flight) si alternerebbero e la cache non reggerebbe mai
+	size_t m_OffScreenImageCount = 0;
+	// Offscreen pass: il job i registra con m_SecondaryRecorders[OffScreenSlot][i], i pool si resettano quando si ri-registra
+	std::vector<std::vector<SecondaryRecorder>> m_SecondaryRecorders;
+	std::vector<OffScreenRecordState> m_OffScreenRecorded;
+
+private:
+	size_t OffScreenSlot(uint32_t const current_frame, uint32_t const current_image) const
+	{
+		return (current_frame % MAX_FRAMES_IN_FLIGHT) * m_OffScreenImageCount + current_image;
+	}
+
+	void RecordOffScreenDraws(VkCommandBuffer command_buffer, const VkCommandBufferInheritanceInfo& inheritance_info,
+		const DrawList& draw_list, size_t first_batch, size_t batch_count, TextureObjects& textureObjects, VkDescriptorSet& view_projection_set,
+		VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets);
+	void RecordCulling(VkCommandBuffer command_buffer, const DrawList& draw_list, VkDescriptorSet& cull_set,
+		VkDescriptorSet& object_set, const FrameUniformOffsets& uniform_offsets);
+	void RecordHiZBuild(VkCommandBuffer command_buffer, uint32_t currentImage, size_t image_count, const HiZPyramid& hiz,
+		std::vector<VkDescriptorSet>& hiz_sets);
+	void RecordTiledLighting(uint32_t current_img, VkExtent2D& imageExtent,
+		std::vector<VkDescriptorSet>& inputDescriptorSet, std::vector<VkDescriptorSet>& tiled_lighting_sets,
+		VkDescriptorSet& view_projection_set, VkDescriptorSet& settings_desc_set,
+		const FrameUniformOffsets& uniform_offsets, BufferImage& lighting_image);
 };
\ No newline at end of file
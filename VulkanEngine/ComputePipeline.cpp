@@ -0,0 +1,137 @@
+#include "pch.h"
+
+#include "ComputePipeline.h"
+
+ComputePipeline::ComputePipeline()
+{
+	m_MainDevice				= nullptr;
+	m_InputSetLayout			= VK_NULL_HANDLE;
+	m_TiledLightingSetLayout	= VK_NULL_HANDLE;
+	m_ViewProjectionSetLayout	= VK_NULL_HANDLE;
+	m_SettingsSetLayout			= VK_NULL_HANDLE;
+	m_HiZSetLayout				= VK_NULL_HANDLE;
+	m_CullSetLayout				= VK_NULL_HANDLE;
+	m_ObjectSetLayout			= VK_NULL_HANDLE;
+	m_TiledLightingPipeline		= VK_NULL_HANDLE;
+	m_TiledLightingLayout		= VK_NULL_HANDLE;
+	m_HiZPipeline				= VK_NULL_HANDLE;
+	m_HiZLayout					= VK_NULL_HANDLE;
+	m_InstanceCullingPipeline	= VK_NULL_HANDLE;
+	m_InstanceCullingLayout		= VK_NULL_HANDLE;
+	m_CullingPipeline			= VK_NULL_HANDLE;
+	m_CullingLayout				= VK_NULL_HANDLE;
+}
+
+ComputePipeline::ComputePipeline(MainDevice* main_device) : ComputePipeline()
+{
+	m_MainDevice = main_device;
+}
+
+void ComputePipeline::SetDescriptorSetLayouts(
+	VkDescriptorSetLayout& input_set_layout,
+	VkDescriptorSetLayout& tiled_lighting_set_layout,
+	VkDescriptorSetLayout& view_projection_set_layout,
+	VkDescriptorSetLayout& settings_set_layout)
+{
+	m_InputSetLayout			= input_set_layout;
+	m_TiledLightingSetLayout	= tiled_lighting_set_layout;
+	m_ViewProjectionSetLayout	= view_projection_set_layout;
+	m_SettingsSetLayout			= settings_set_layout;
+}
+
+void ComputePipeline::SetCullingSetLayouts(
+	VkDescriptorSetLayout& hiz_set_layout,
+	VkDescriptorSetLayout& cull_set_layout,
+	VkDescriptorSetLayout& object_set_layout)
+{
+	m_HiZSetLayout		= hiz_set_layout;
+	m_CullSetLayout		= cull_set_layout;
+	m_ObjectSetLayout	= object_set_layout;
+}
+
+void ComputePipeline::CreateTiledLightingPipeline()
+{
+	// G-buffer, luci + immagine di output, View-Projection (ricostruzione della posizione), settings (render target)
+	CreatePipeline("./Shaders/tiled_lighting_comp.spv",
+		{ m_InputSetLayout, m_TiledLightingSetLayout, m_ViewProjectionSetLayout, m_SettingsSetLayout },
+		m_TiledLightingPipeline, m_TiledLightingLayout, "Tiled Lighting");
+}
+
+void ComputePipeline::CreateHiZPipeline()
+{
+	// Livello sorgente (depth del G-buffer o mip precedente) + mip di destinazione
+	CreatePipeline("./Shaders/hiz_build_comp.spv", { m_HiZSetLayout }, m_HiZPipeline, m_HiZLayout, "Hi-Z");
+}
+
+void ComputePipeline::CreateCullingPipeline()
+{
+	// Buffer del DrawList + Hi-Z + CullData, model matrix degli oggetti. Prima le istanze, poi i comandi con le istanze visibili
+	CreatePipeline("./Shaders/cull_instances_comp.spv", { m_CullSetLayout, m_ObjectSetLayout },
+		m_InstanceCullingPipeline, m_InstanceCullingLayout, "Instance Culling");
+	CreatePipeline("./Shaders/cull_comp.spv", { m_CullSetLayout, m_ObjectSetLayout }, m_CullingPipeline, m_CullingLayout, "Culling");
+}
+
+void ComputePipeline::CreatePipeline(const std::string& shader_file, const std::vector<VkDescriptorSetLayout>& desc_set_layouts,
+	VkPipeline& pipeline, VkPipelineLayout& layout, const std::string& name)
+{
+	std::vector<char> shader_code = Utility::ReadFile(shader_file);
+	VkShaderModule shader_module = Utility::CreateShaderModule(shader_code);
+
+	VkPipelineShaderStageCreateInfo compute_stage = {};
+	compute_stage.sType		= VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_stage.stage		= VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_stage.module	= shader_module;
+	compute_stage.pName		= "main";
+
+	VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+	pipeline_layout_info.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_info.setLayoutCount			= static_cast<uint32_t>(desc_set_layouts.size());
+	pipeline_layout_info.pSetLayouts			= desc_set_layouts.data();
+	pipeline_layout_info.pushConstantRangeCount	= 0;
+	pipeline_layout_info.pPushConstantRanges	= nullptr;
+
+	VkResult result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &pipeline_layout_info, nullptr, &layout);
+
+	if (result != VK_SUCCESS)
+	{
+		vkDestroyShaderModule(m_MainDevice->LogicalDevice, shader_module, nullptr);
+		throw std::runtime_error("Failed to create the " + name + " Pipeline Layout!");
+	}
+
+	VkComputePipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType					= VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_info.stage					= compute_stage;
+	pipeline_info.layout				= layout;
+	pipeline_info.basePipelineHandle	= VK_NULL_HANDLE;
+	pipeline_info.basePipelineIndex		= -1;
+
+	result = vkCreateComputePipelines(m_MainDevice->LogicalDevice, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
+
+	vkDestroyShaderModule(m_MainDevice->LogicalDevice, shader_module, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the " + name + " Compute Pipeline!");
+	}
+}
+
+void ComputePipeline::DestroyPipeline()
+{
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_TiledLightingPipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_TiledLightingLayout, nullptr);
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_HiZPipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_HiZLayout, nullptr);
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_InstanceCullingPipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_InstanceCullingLayout, nullptr);
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_CullingPipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_CullingLayout, nullptr);
+
+	m_TiledLightingPipeline = VK_NULL_HANDLE;
+	m_TiledLightingLayout	= VK_NULL_HANDLE;
+	m_HiZPipeline			= VK_NULL_HANDLE;
+	m_HiZLayout				= VK_NULL_HANDLE;
+	m_InstanceCullingPipeline	= VK_NULL_HANDLE;
+	m_InstanceCullingLayout		= VK_NULL_HANDLE;
+	m_CullingPipeline		= VK_NULL_HANDLE;
+	m_CullingLayout			= VK_NULL_HANDLE;
+}
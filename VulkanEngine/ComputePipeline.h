@@ -0,0 +1,64 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utilities.h"
+
+constexpr uint32_t LIGHTING_TILE_SIZE = 16;	// Deve coincidere con il local_size di tiled_lighting.comp
+constexpr uint32_t TILED_MAX_LIGHTS_PER_TILE = 512;	// MAX_LIGHTS_PER_TILE di tiled_lighting.comp (lista in shared memory)
+constexpr uint32_t HIZ_GROUP_SIZE		= 8;	// local_size di hiz_build.comp (8x8)
+constexpr uint32_t CULL_GROUP_SIZE		= 64;	// local_size di cull.comp
+
+// Pipeline compute del tiled deferred lighting: ogni workgroup copre una tile 16x16 dello schermo,
+// calcola min/max depth della tile, seleziona in shared memory le luci che la toccano e illumina solo con quelle.
+// Contiene anche le pipeline del culling su GPU: costruzione della piramide Hi-Z e test frustum/occlusion dei comandi indirect
+class ComputePipeline
+{
+public:
+	ComputePipeline();
+	ComputePipeline(MainDevice* main_device);
+
+	void SetDescriptorSetLayouts(
+		VkDescriptorSetLayout& input_set_layout, VkDescriptorSetLayout& tiled_lighting_set_layout,
+		VkDescriptorSetLayout& view_projection_set_layout, VkDescriptorSetLayout& settings_set_layout);
+
+	void SetCullingSetLayouts(VkDescriptorSetLayout& hiz_set_layout, VkDescriptorSetLayout& cull_set_layout,
+		VkDescriptorSetLayout& object_set_layout);
+
+	void CreateTiledLightingPipeline();
+	void CreateHiZPipeline();
+	void CreateCullingPipeline();
+	void DestroyPipeline();
+
+	VkPipeline&			GetTiledLightingPipeline()	{ return m_TiledLightingPipeline; }
+	VkPipelineLayout&	GetTiledLightingLayout()	{ return m_TiledLightingLayout; }
+	VkPipeline&			GetHiZPipeline()			{ return m_HiZPipeline; }
+	VkPipelineLayout&	GetHiZLayout()				{ return m_HiZLayout; }
+	VkPipeline&			GetInstanceCullingPipeline(){ return m_InstanceCullingPipeline; }
+	VkPipeline&			GetCullingPipeline()		{ return m_CullingPipeline; }
+	VkPipelineLayout&	GetCullingLayout()			{ return m_CullingLayout; }
+
+private:
+	MainDevice				*m_MainDevice;
+
+	VkDescriptorSetLayout	m_InputSetLayout;
+	VkDescriptorSetLayout	m_TiledLightingSetLayout;
+	VkDescriptorSetLayout	m_ViewProjectionSetLayout;
+	VkDescriptorSetLayout	m_SettingsSetLayout;
+	VkDescriptorSetLayout	m_HiZSetLayout;
+	VkDescriptorSetLayout	m_CullSetLayout;
+	VkDescriptorSetLayout	m_ObjectSetLayout;
+
+	VkPipeline				m_TiledLightingPipeline;
+	VkPipelineLayout		m_TiledLightingLayout;
+	VkPipeline				m_HiZPipeline;
+	VkPipelineLayout		m_HiZLayout;
+	VkPipeline				m_InstanceCullingPipeline;
+	VkPipelineLayout		m_InstanceCullingLayout;	// Stessi set di m_CullingLayout, i set legati restano validi tra i due dispatch
+	VkPipeline				m_CullingPipeline;
+	VkPipelineLayout		m_CullingLayout;
+
+private:
+	void CreatePipeline(const std::string& shader_file, const std::vector<VkDescriptorSetLayout>& desc_set_layouts,
+		VkPipeline& pipeline, VkPipelineLayout& layout, const std::string& name);
+};
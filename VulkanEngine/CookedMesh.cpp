@@ -0,0 +1,220 @@
+#include "pch.h"
+
+#include "CookedMesh.h"
+#include "MeshImporter.h"
+
+#include <assimp/Importer.hpp>
+#include <filesystem>
+
+constexpr uint64_t COOKED_BLOB_ALIGNMENT = 16;
+
+static uint64_t AlignBlob(const uint64_t offset)
+{
+	return (offset + COOKED_BLOB_ALIGNMENT - 1) & ~(COOKED_BLOB_ALIGNMENT - 1);
+}
+
+std::string CookedMesh::GetCookedPath(const std::string& source_file)
+{
+	return source_file + ".cooked";
+}
+
+bool CookedMesh::IsUpToDate(const std::string& source_file)
+{
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	const fs::path cooked_path = GetCookedPath(source_file);
+
+	if (!fs::exists(cooked_path, error))
+		return false;
+
+	// Without the source (e.g. a shipped build) the cooked file is all we have
+	if (!fs::exists(source_file, error))
+		return true;
+
+	return fs::last_write_time(cooked_path, error) >= fs::last_write_time(source_file, error);
+}
+
+void CookedMesh::Cook(const std::string& source_file, const std::string& cooked_file)
+{
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(source_file, MeshImporter::IMPORT_FLAGS);
+
+	if (!scene)
+		throw std::runtime_error("Failed to load model! (" + source_file + ")");
+
+	const std::vector<std::string> texture_names = MeshImporter::LoadMaterials(scene);
+
+	std::vector<const aiMesh*> scene_meshes;
+	MeshImporter::CollectMeshes(scene->mRootNode, scene, scene_meshes);
+
+	const uint32_t mesh_count = static_cast<uint32_t>(scene_meshes.size());
+
+	std::vector<std::vector<Vertex>>	vertices(mesh_count);
+	std::vector<std::vector<uint32_t>>	indices(mesh_count);
+	std::vector<CookedMeshEntry>		entries(mesh_count);
+	std::vector<CookedMaterial>			materials(texture_names.size());
+
+	for (size_t i = 0; i < texture_names.size(); ++i)
+	{
+		if (texture_names[i].size() >= COOKED_TEXTURE_NAME_SIZE)
+			throw std::runtime_error("Texture name too long for the cooked format! (" + texture_names[i] + ")");
+
+		materials[i] = {};
+		std::copy(texture_names[i].begin(), texture_names[i].end(), materials[i].Texture);
+	}
+
+	CookedMeshHeader header = {};
+	header.Magic			= COOKED_MESH_MAGIC;
+	header.Version			= COOKED_MESH_VERSION;
+	header.VertexStride		= sizeof(Vertex);
+	header.MeshCount		= mesh_count;
+	header.MaterialCount	= static_cast<uint32_t>(materials.size());
+	header.BoundsMin		= glm::vec3(std::numeric_limits<float>::max());
+	header.BoundsMax		= glm::vec3(std::numeric_limits<float>::lowest());
+
+	uint64_t offset = AlignBlob(sizeof(CookedMeshHeader) + entries.size() * sizeof(CookedMeshEntry) + materials.size() * sizeof(CookedMaterial));
+
+	for (uint32_t i = 0; i < mesh_count; ++i)
+	{
+		MeshImporter::ConvertMesh(scene_meshes[i], vertices[i], indices[i]);
+
+		CookedMeshEntry& entry = entries[i];
+		entry = {};
+		entry.VertexCount	= static_cast<uint32_t>(vertices[i].size());
+		entry.IndexCount	= static_cast<uint32_t>(indices[i].size());
+		entry.MaterialIndex	= scene_meshes[i]->mMaterialIndex;
+
+		MeshImporter::ComputeBounds(vertices[i], entry.BoundsMin, entry.BoundsMax);
+		header.BoundsMin = glm::min(header.BoundsMin, entry.BoundsMin);
+		header.BoundsMax = glm::max(header.BoundsMax, entry.BoundsMax);
+
+		entry.VertexOffset	= offset;
+		offset				= AlignBlob(offset + vertices[i].size() * sizeof(Vertex));
+		entry.IndexOffset	= offset;
+		offset				= AlignBlob(offset + indices[i].size() * sizeof(uint32_t));
+	}
+
+	if (mesh_count == 0)
+	{
+		header.BoundsMin = glm::vec3(0.0f);
+		header.BoundsMax = glm::vec3(0.0f);
+	}
+
+	std::ofstream file(cooked_file, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open " + cooked_file + " for writing!");
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CookedMeshEntry));
+	file.write(reinterpret_cast<const char*>(materials.data()), materials.size() * sizeof(CookedMaterial));
+
+	// Zero padding up to the next blob offset
+	auto pad_to = [&file](const uint64_t target) {
+		static const char zeros[COOKED_BLOB_ALIGNMENT] = {};
+		const uint64_t position = static_cast<uint64_t>(file.tellp());
+		file.write(zeros, static_cast<std::streamsize>(target - position));
+	};
+
+	for (uint32_t i = 0; i < mesh_count; ++i)
+	{
+		pad_to(entries[i].VertexOffset);
+		file.write(reinterpret_cast<const char*>(vertices[i].data()), vertices[i].size() * sizeof(Vertex));
+
+		pad_to(entries[i].IndexOffset);
+		file.write(reinterpret_cast<const char*>(indices[i].data()), indices[i].size() * sizeof(uint32_t));
+	}
+
+	if (!file)
+		throw std::runtime_error("Failed to write " + cooked_file + "!");
+}
+
+bool CookedMesh::Open(const std::string& cooked_file)
+{
+	Close();
+
+	if (!m_File.Open(cooked_file) || m_File.GetSize() < sizeof(CookedMeshHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const uint8_t* data = m_File.GetData();
+
+	m_Header	= reinterpret_cast<const CookedMeshHeader*>(data);
+	m_Meshes	= reinterpret_cast<const CookedMeshEntry*>(data + sizeof(CookedMeshHeader));
+	m_Materials	= reinterpret_cast<const CookedMaterial*>(data + sizeof(CookedMeshHeader) + m_Header->MeshCount * sizeof(CookedMeshEntry));
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void CookedMesh::Close()
+{
+	m_File.Close();
+
+	m_Header	= nullptr;
+	m_Meshes	= nullptr;
+	m_Materials	= nullptr;
+}
+
+const Vertex* CookedMesh::GetVertices(const uint32_t i) const
+{
+	return reinterpret_cast<const Vertex*>(m_File.GetData() + m_Meshes[i].VertexOffset);
+}
+
+const uint32_t* CookedMesh::GetIndices(const uint32_t i) const
+{
+	return reinterpret_cast<const uint32_t*>(m_File.GetData() + m_Meshes[i].IndexOffset);
+}
+
+std::vector<std::string> CookedMesh::GetMaterials() const
+{
+	std::vector<std::string> texture_names(m_Header->MaterialCount);
+
+	for (uint32_t i = 0; i < m_Header->MaterialCount; ++i)
+	{
+		const char* name = m_Materials[i].Texture;
+		texture_names[i] = std::string(name, std::find(name, name + COOKED_TEXTURE_NAME_SIZE, '\0'));
+	}
+
+	return texture_names;
+}
+
+bool CookedMesh::Validate() const
+{
+	if (m_Header->Magic != COOKED_MESH_MAGIC || m_Header->Version != COOKED_MESH_VERSION || m_Header->VertexStride != sizeof(Vertex))
+		return false;
+
+	const uint64_t file_size	= m_File.GetSize();
+	const uint64_t tables_end	= sizeof(CookedMeshHeader) +
+		static_cast<uint64_t>(m_Header->MeshCount) * sizeof(CookedMeshEntry) +
+		static_cast<uint64_t>(m_Header->MaterialCount) * sizeof(CookedMaterial);
+
+	if (tables_end > file_size)
+		return false;
+
+	// Un file troncato o corrotto non deve far leggere fuori dal mapping
+	for (uint32_t i = 0; i < m_Header->MeshCount; ++i)
+	{
+		const CookedMeshEntry& entry = m_Meshes[i];
+
+		if (entry.VertexOffset % COOKED_BLOB_ALIGNMENT != 0 || entry.IndexOffset % COOKED_BLOB_ALIGNMENT != 0)
+			return false;
+
+		if (entry.VertexOffset + static_cast<uint64_t>(entry.VertexCount) * sizeof(Vertex) > file_size ||
+			entry.IndexOffset + static_cast<uint64_t>(entry.IndexCount) * sizeof(uint32_t) > file_size)
+			return false;
+
+		if (entry.MaterialIndex >= m_Header->MaterialCount)
+			return false;
+	}
+
+	return true;
+}
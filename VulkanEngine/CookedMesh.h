@@ -0,0 +1,80 @@
+#pragma once
+
+#include "pch.h"
+
+#include "MappedFile.h"
+
+#include <assimp/scene.h>
+
+// Binary mesh format written by MeshCooker. Every blob is stored exactly as it is uploaded,
+// so loading a model is a memory mapping plus a memcpy into the staging buffers.
+//
+//	CookedMeshHeader
+//	CookedMeshEntry  [MeshCount]
+//	CookedMaterial   [MaterialCount]
+//	vertex/index blobs (16 byte aligned, offsets from the beginning of the file)
+constexpr uint32_t COOKED_MESH_MAGIC		= 0x434D5244;	// "DRMC"
+constexpr uint32_t COOKED_MESH_VERSION		= 1;			// Increase whenever the layout (or Vertex) changes
+constexpr size_t   COOKED_TEXTURE_NAME_SIZE	= 128;
+
+struct CookedMeshHeader {
+	uint32_t	Magic;
+	uint32_t	Version;
+	uint32_t	VertexStride;		// sizeof(Vertex) of the cooker, a mismatch means a stale file
+	uint32_t	MeshCount;
+	uint32_t	MaterialCount;
+	glm::vec3	BoundsMin;
+	glm::vec3	BoundsMax;
+	uint32_t	Reserved;
+};
+
+struct CookedMeshEntry {
+	uint64_t	VertexOffset;
+	uint64_t	IndexOffset;
+	uint32_t	VertexCount;
+	uint32_t	IndexCount;
+	uint32_t	MaterialIndex;
+	uint32_t	Reserved;
+	glm::vec3	BoundsMin;
+	glm::vec3	BoundsMax;
+};
+
+struct CookedMaterial {
+	char Texture[COOKED_TEXTURE_NAME_SIZE];	// Nome del file in Textures/, stringa vuota se assente
+};
+
+static_assert(sizeof(CookedMeshHeader) == 48, "CookedMeshHeader layout changed, bump COOKED_MESH_VERSION");
+static_assert(sizeof(CookedMeshEntry) == 56, "CookedMeshEntry layout changed, bump COOKED_MESH_VERSION");
+
+class CookedMesh
+{
+public:
+	// Models/Vivi_Final.obj -> Models/Vivi_Final.obj.cooked
+	static std::string GetCookedPath(const std::string& source_file);
+
+	// Cooked file present, valid and not older than its source
+	static bool IsUpToDate(const std::string& source_file);
+
+	// Offline: import with Assimp and write the cooked file (used by MeshCooker)
+	static void Cook(const std::string& source_file, const std::string& cooked_file);
+
+	bool Open(const std::string& cooked_file);
+	void Close();
+
+	uint32_t GetMeshCount() const							{ return m_Header->MeshCount; }
+	const CookedMeshEntry& GetMesh(const uint32_t i) const	{ return m_Meshes[i]; }
+	const Vertex* GetVertices(const uint32_t i) const;
+	const uint32_t* GetIndices(const uint32_t i) const;
+	std::vector<std::string> GetMaterials() const;
+	glm::vec3 GetBoundsMin() const							{ return m_Header->BoundsMin; }
+	glm::vec3 GetBoundsMax() const							{ return m_Header->BoundsMax; }
+
+private:
+	MappedFile				m_File;
+	const CookedMeshHeader*	m_Header	= nullptr;
+	const CookedMeshEntry*	m_Meshes	= nullptr;
+	const CookedMaterial*	m_Materials	= nullptr;
+
+private:
+	bool Validate() const;
+};
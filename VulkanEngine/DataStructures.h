@@ -1,5 +1,4 @@
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include <vulkan/vulkan.h>
 
 #include "pch.h"
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -10,6 +9,12 @@ struct MainDevice {
 	VkPhysicalDevice PhysicalDevice;
 	VkDevice		 LogicalDevice;
 	VkDeviceSize	 MinUniformBufferOffset;
+	VkDeviceSize	 MinStorageBufferOffset;
+	bool			 MultiDrawIndirect;				// drawCount > 1 in vkCmdDrawIndexedIndirect
+	bool			 DrawIndirectFirstInstance;		// firstInstance != 0 in the indirect commands
+	PFN_vkCmdDrawIndexedIndirectCountKHR DrawIndexedIndirectCount;	// VK_KHR_draw_indirect_count, nullptr when not available
+	bool			 BindlessTextures;				// VK_EXT_descriptor_indexing: every texture in one partially bound array
+	uint32_t		 MaxBindlessTextures;			// Size of the bindless array, 0 when not available
 };
 
 struct VulkanRenderData {
@@ -36,6 +41,16 @@ struct VulkanRenderData {
 	VkRenderPass		render_pass;
 };
 
+// Range of a device memory block handed out by the MemoryAllocator
+struct Allocation {
+	VkDeviceMemory	Memory		= VK_NULL_HANDLE;	// Block the range belongs to (shared with other resources)
+	VkDeviceSize	Offset		= 0;
+	VkDeviceSize	Size		= 0;
+	uint32_t		MemoryType	= 0;
+	bool			Linear		= true;				// Buffers and optimal images live in separate blocks
+	void*			Mapped		= nullptr;			// Host pointer to the range, only for HOST_VISIBLE memory
+};
+
 struct ImageInfo {
 	uint32_t				width;
 	uint32_t				height;
@@ -43,6 +58,7 @@ struct ImageInfo {
 	VkImageTiling			tiling;
 	VkImageUsageFlags		usage;
 	VkMemoryPropertyFlags	properties;
+	uint32_t				mip_levels = 1;
 };
 
 struct BufferSettings {
@@ -53,9 +69,10 @@ struct BufferSettings {
 
 struct TextureObjects {
 	std::vector<VkImage>		 TextureImages;
-	std::vector<VkDeviceMemory>  TextureImageMemory;
+	std::vector<Allocation>		 TextureImageMemory;
 	std::vector<VkImageView>	 TextureImageViews;
-	std::vector<VkDescriptorSet> SamplerDescriptorSets;
+	std::vector<VkDescriptorSet> SamplerDescriptorSets;		// Un set per texture, VK_NULL_HANDLE con le texture bindless
+	VkDescriptorSet				 BindlessDescriptorSet = VK_NULL_HANDLE;	// Array di tutte le texture, l'elemento i  la texture i
 
 	VkSampler					 TextureSampler = {};
 
@@ -87,26 +104,45 @@ struct TextureObjects {
 struct ViewProjectionData {
 	glm::mat4 proj;
 	glm::mat4 view;
+	glm::mat4 inv_view_proj;	// Lighting pass: posizione world-space ricostruita dalla depth
+};
+
+// Percorso del lighting pass, scelto a runtime (GUI / benchmark)
+enum LightingMode : int {
+	LIGHTING_FULLSCREEN = 0,	// Fullscreen triangle, ogni pixel itera su tutte le luci
+	LIGHTING_TILED		= 1,	// Compute shader, luci assegnate a tile 16x16 dello schermo
+	LIGHTING_CLUSTERED	= 2,	// Fullscreen triangle, luci assegnate sulla CPU a cluster 3D (froxel) del frustum
+	LIGHTING_VOLUMES	= 3		// Una sfera per luce in additive blending, solo i pixel dentro il volume
 };
 
 struct SettingsData {
 	int render_target;
+	int lighting_mode;	// LightingMode, letto solo lato CPU
+};
+
+// Contatori del tiled lighting: azzerati dalla CPU nell'uniform ring, incrementati da tiled_lighting.comp
+// e riletti dopo la fence del frame
+struct TiledLightingStats {
+	uint32_t overflow_tiles;	// Tile con pi di TILED_MAX_LIGHTS_PER_TILE luci: quelle in eccesso non illuminano
+	uint32_t max_tile_lights;	// Luci della tile pi affollata, comprese quelle scartate
 };
 
 struct BufferImage {
 	VkImage			Image		= {};
 	VkFormat		Format		= {};
-	VkDeviceMemory  Memory		= {};
+	Allocation		Memory		= {};
 	VkImageView		ImageView	= {};
 	VkSampler		Sampler		= {};
+};
 
-	void DestroyAndFree(MainDevice &mainDevice)
-	{
-		vkDestroySampler(mainDevice.LogicalDevice, Sampler, nullptr);
-		vkDestroyImageView(mainDevice.LogicalDevice, ImageView, nullptr);
-		vkDestroyImage(mainDevice.LogicalDevice, Image, nullptr);
-		vkFreeMemory(mainDevice.LogicalDevice, Memory, nullptr);
-	}
+constexpr uint32_t HIZ_MAX_LEVELS = 16;
+
+// Piramide di depth (max di ogni blocco 2x2) per l'occlusion culling, sempre in layout GENERAL:
+// ogni mip e' scritta come storage image e letta (texelFetch) per costruire la successiva
+struct HiZPyramid {
+	BufferImage					Image;			// ImageView: tutte le mip, letta dal culling
+	std::vector<VkImageView>	MipViews;		// Una view per mip
+	std::vector<VkExtent2D>		MipExtents;		// Mip 0 = meta' della risoluzione del G-buffer
 };
 
 struct SubmissionSyncObjects {
@@ -120,11 +156,17 @@ struct QueueFamilyIndices {
 
 	uint32_t GraphicsFamily		= UINT_MAX;
 	uint32_t PresentationFamily = UINT_MAX;
+	uint32_t TransferFamily		= UINT_MAX;	// Transfer-only family if the device has one, the graphics family otherwise
 
 	bool isValid() const
 	{
 		return GraphicsFamily >= 0 && PresentationFamily >= 0;
 	}
+
+	bool HasDedicatedTransfer() const
+	{
+		return TransferFamily != GraphicsFamily;
+	}
 };
 
 struct Vertex
@@ -133,4 +175,20 @@ struct Vertex
 	glm::vec3 col;
 	glm::vec3 nrm; // normal
 	glm::vec2 tex;
-};
\ No newline at end of file
+};
+
+// Layout dei vertici nella GeometryArena, scelto prima di caricare le mesh (VulkanRenderer::SetVertexFormat)
+enum class VertexFormat {
+	Full,		// Vertex, 44 byte
+	Packed		// PackedVertex, 16 byte
+};
+
+// Quantized vertex, decoded by shader.vert (-DPACKED_VERTEX). No colour (the importers always write white)
+struct PackedVertex
+{
+	int16_t  pos[4];	// snorm relative to the AABB of the mesh (DrawInstance::PositionOffset/Scale), w unused: RGB16 is not a required vertex format
+	int16_t  nrm[2];	// Octahedral encoding, snorm
+	uint16_t tex[2];	// Half float
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must match the attributes of GraphicPipeline::SetVertexttributeDescriptions");
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Utilities.h"
 #include "DescriptorsHandler.h"
+#include "DrawList.h"
 
 Descriptors::Descriptors()
 {
@@ -10,23 +11,52 @@ Descriptors::Descriptors()
 	m_ViewProjectionLayout	= {};
 	m_TexturePool			= {};
 	m_TextureLayout			= {};
-
-	std::vector<VkDescriptorSet> m_DescriptorSets = {};
+	m_ViewProjectionSet		= VK_NULL_HANDLE;
+	m_LightSet				= VK_NULL_HANDLE;
+	m_SettingsSet			= VK_NULL_HANDLE;
+	m_ClusterSet			= VK_NULL_HANDLE;
+	m_BindlessTexturePool	= VK_NULL_HANDLE;
+	m_BindlessTextureLayout	= VK_NULL_HANDLE;
+	m_BindlessTextureCount	= 0;
+	m_BindlessTextureSet	= VK_NULL_HANDLE;
 }
 
-Descriptors::Descriptors(VkDevice *device)
+Descriptors::Descriptors(VkDevice *device) : Descriptors()
 {
 	m_Device = device;
 }
 
-void Descriptors::CreateDescriptorPools(size_t swapchain_images, size_t vp_ubo_size, size_t light_ubo_size, size_t settings_ubo_size)
+void Descriptors::CreateDescriptorPools(size_t swapchain_images)
 {
-	CreateViewProjectionPool(swapchain_images, vp_ubo_size);
+	CreateViewProjectionPool();
 	CreateTexturePool();
 	CreateImguiPool();
 	CreateInputAttachmentsPool(swapchain_images);
-	CreateLightPool(swapchain_images, light_ubo_size);
-	CreateSettingsPool(swapchain_images, settings_ubo_size);
+	CreateLightPool();
+	CreateSettingsPool();
+	CreateTiledLightingPool(swapchain_images);
+	CreateCompositePool(swapchain_images);
+	CreateClusterPool();
+	CreateObjectPool();
+	CreateHiZPool(swapchain_images);
+	CreateCullPool();
+}
+
+// Resize della swapchain: i set che leggono G-buffer, lighting e Hi-Z vanno riallocati per le nuove immagini
+// (anche il loro numero pu cambiare). Va chiamata a device idle, prima di ricreare i set
+void Descriptors::RecreateSwapChainPools(size_t swapchain_images)
+{
+	DestroyInputPool();
+	DestroyTiledLightingPool();
+	DestroyCompositePool();
+	DestroyHiZPool();
+	DestroyCullPool();
+
+	CreateInputAttachmentsPool(swapchain_images);
+	CreateTiledLightingPool(swapchain_images);
+	CreateCompositePool(swapchain_images);
+	CreateHiZPool(swapchain_images);
+	CreateCullPool();
 }
 
 void Descriptors::CreateSetLayouts()
@@ -36,15 +66,21 @@ void Descriptors::CreateSetLayouts()
 	CreateInputSetLayout();
 	CreateLightSetLayout();
 	CreateSettingsSetLayout();
+	CreateTiledLightingSetLayout();
+	CreateCompositeSetLayout();
+	CreateClusterSetLayout();
+	CreateObjectSetLayout();
+	CreateHiZSetLayout();
+	CreateCullSetLayout();
 }
 
 void Descriptors::CreateViewProjectionSetLayout()
 {
 	VkDescriptorSetLayoutBinding viewProjectionLayoutBinding = {};
 	viewProjectionLayoutBinding.binding				= 0;									
-	viewProjectionLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; 
+	viewProjectionLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; 
 	viewProjectionLayoutBinding.descriptorCount		= 1;								
-	viewProjectionLayoutBinding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT;		
+	viewProjectionLayoutBinding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;	// Fragment/Compute: ricostruzione della posizione nel lighting pass
 	viewProjectionLayoutBinding.pImmutableSamplers	= nullptr;						
 
 	std::vector<VkDescriptorSetLayoutBinding> layoutBindings = { viewProjectionLayoutBinding };
@@ -84,25 +120,25 @@ void Descriptors::CreateTextureSetLayout()
 
 void Descriptors::CreateInputSetLayout()
 {
-	VkDescriptorSetLayoutBinding positionInputLayoutBinding = {};
-	positionInputLayoutBinding.binding			= 0;
-	positionInputLayoutBinding.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	positionInputLayoutBinding.descriptorCount	= 1;
-	positionInputLayoutBinding.stageFlags		= VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorSetLayoutBinding depthInputLayoutBinding = {};
+	depthInputLayoutBinding.binding			= 0;
+	depthInputLayoutBinding.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	depthInputLayoutBinding.descriptorCount	= 1;
+	depthInputLayoutBinding.stageFlags		= VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;	// Il G-buffer  letto anche dal tiled lighting
 
 	VkDescriptorSetLayoutBinding colourInputLayoutBinding = {};
 	colourInputLayoutBinding.binding			= 1;
 	colourInputLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	colourInputLayoutBinding.descriptorCount	= 1;
-	colourInputLayoutBinding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	colourInputLayoutBinding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
 	VkDescriptorSetLayoutBinding normalInputLayoutBinding = {};
 	normalInputLayoutBinding.binding			= 2;
 	normalInputLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	normalInputLayoutBinding.descriptorCount	= 1;
-	normalInputLayoutBinding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	normalInputLayoutBinding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
-	std::vector<VkDescriptorSetLayoutBinding> inputBindings = { positionInputLayoutBinding, colourInputLayoutBinding, normalInputLayoutBinding };
+	std::vector<VkDescriptorSetLayoutBinding> inputBindings = { depthInputLayoutBinding, colourInputLayoutBinding, normalInputLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo inputLayoutCreateInfo = {};
 	inputLayoutCreateInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -120,9 +156,10 @@ void Descriptors::CreateInputSetLayout()
 
 void Descriptors::CreateLightSetLayout()
 {
+	// Light buffer del LightManager (header + LightData[count]), una slice per frame in flight
 	VkDescriptorSetLayoutBinding light_layout_binding = {};
 	light_layout_binding.binding			= 0;
-	light_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	light_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 	light_layout_binding.descriptorCount	= 1;
 	light_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;			
 	light_layout_binding.pImmutableSamplers = nullptr;
@@ -144,9 +181,9 @@ void Descriptors::CreateSettingsSetLayout()
 {
 	VkDescriptorSetLayoutBinding settings_layout_binding = {};
 	settings_layout_binding.binding				= 0;
-	settings_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	settings_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	settings_layout_binding.descriptorCount		= 1;
-	settings_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	settings_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 	settings_layout_binding.pImmutableSamplers	= nullptr;
 
 	std::vector<VkDescriptorSetLayoutBinding> layout_bindings = { settings_layout_binding };
@@ -162,50 +199,242 @@ void Descriptors::CreateSettingsSetLayout()
 		throw std::runtime_error("Failed to create the Settings Descriptor Set Layout");
 }
 
-void Descriptors::CreateViewProjectionDescriptorSets(
-	const std::vector<VkBuffer> & viewProjectionUBO,
-	size_t dataSize, size_t swapchain_size)
+void Descriptors::CreateTiledLightingSetLayout()
 {
-	m_DescriptorSets.resize(swapchain_size);
+	// Header (numero di luci) + array di LightData, nell'uniform ring ad un dynamic offset
+	VkDescriptorSetLayoutBinding lights_layout_binding = {};
+	lights_layout_binding.binding				= 0;
+	lights_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	lights_layout_binding.descriptorCount		= 1;
+	lights_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	lights_layout_binding.pImmutableSamplers	= nullptr;
+
+	// Colore finale scritto dal compute shader
+	VkDescriptorSetLayoutBinding output_layout_binding = {};
+	output_layout_binding.binding				= 1;
+	output_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	output_layout_binding.descriptorCount		= 1;
+	output_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	output_layout_binding.pImmutableSamplers	= nullptr;
+
+	// TiledLightingStats nell'uniform ring (dynamic offset): tile con troppe luci, riletto dalla CPU
+	VkDescriptorSetLayoutBinding stats_layout_binding = {};
+	stats_layout_binding.binding				= 2;
+	stats_layout_binding.descriptorType			= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	stats_layout_binding.descriptorCount		= 1;
+	stats_layout_binding.stageFlags				= VK_SHADER_STAGE_COMPUTE_BIT;
+	stats_layout_binding.pImmutableSamplers		= nullptr;
+
+	std::vector<VkDescriptorSetLayoutBinding> layout_bindings = { lights_layout_binding, output_layout_binding, stats_layout_binding };
 
-	std::vector<VkDescriptorSetLayout> setLayouts(swapchain_size, m_ViewProjectionLayout);
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= static_cast<uint32_t>(layout_bindings.size());
+	layout_info.pBindings		= layout_bindings.data();
 
-	VkDescriptorSetAllocateInfo allocate_info = {};
-	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocate_info.descriptorPool		= m_ViewProjectionPool;						// Pool per l'allocazione dei Descriptor Set
-	allocate_info.descriptorSetCount	= static_cast<uint32_t>(swapchain_size);	// Quanti Descriptor Set allocare
-	allocate_info.pSetLayouts			= setLayouts.data();						// Layout da utilizzare per allocare i set (1:1)
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_TiledLightingLayout);
 
-	VkResult res = vkAllocateDescriptorSets(*m_Device, &allocate_info, m_DescriptorSets.data());
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Tiled Lighting Descriptor Set Layout");
+}
+
+void Descriptors::CreateCompositeSetLayout()
+{
+	VkDescriptorSetLayoutBinding lighting_layout_binding = {};
+	lighting_layout_binding.binding				= 0;
+	lighting_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	lighting_layout_binding.descriptorCount		= 1;
+	lighting_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	lighting_layout_binding.pImmutableSamplers	= nullptr;
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= 1;
+	layout_info.pBindings		= &lighting_layout_binding;
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_CompositeLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Composite Descriptor Set Layout");
+}
+
+void Descriptors::CreateClusterSetLayout()
+{
+	// Stesso light buffer del tiled lighting (header + LightData), letto anche dal vertex shader dei light volume
+	VkDescriptorSetLayoutBinding lights_layout_binding = {};
+	lights_layout_binding.binding				= 0;
+	lights_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	lights_layout_binding.descriptorCount		= 1;
+	lights_layout_binding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	lights_layout_binding.pImmutableSamplers	= nullptr;
+
+	// ClusterGridHeader + ClusterRange[CLUSTER_COUNT] + indici delle luci
+	VkDescriptorSetLayoutBinding clusters_layout_binding = {};
+	clusters_layout_binding.binding				= 1;
+	clusters_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	clusters_layout_binding.descriptorCount		= 1;
+	clusters_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	clusters_layout_binding.pImmutableSamplers	= nullptr;
+
+	std::vector<VkDescriptorSetLayoutBinding> layout_bindings = { lights_layout_binding, clusters_layout_binding };
 
-	if (res != VK_SUCCESS)
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= static_cast<uint32_t>(layout_bindings.size());
+	layout_info.pBindings		= layout_bindings.data();
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_ClusterLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Cluster Descriptor Set Layout");
+}
+
+void Descriptors::CreateObjectSetLayout()
+{
+	VkDescriptorSetLayoutBinding objects_layout_binding = {};
+	objects_layout_binding.binding				= 0;
+	objects_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	objects_layout_binding.descriptorCount		= 1;
+	objects_layout_binding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;	// Compute: sfere in world space nel culling
+	objects_layout_binding.pImmutableSamplers	= nullptr;
+
+	// Istanze delle draw del DrawList (oggetto + texture), scritto in UpdateDrawInstanceBuffer. Il culling legge le istanze dal proprio set
+	VkDescriptorSetLayoutBinding instances_layout_binding = {};
+	instances_layout_binding.binding			= 1;
+	instances_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instances_layout_binding.descriptorCount	= 1;
+	instances_layout_binding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT;
+	instances_layout_binding.pImmutableSamplers	= nullptr;
+
+	std::vector<VkDescriptorSetLayoutBinding> layout_bindings = { objects_layout_binding, instances_layout_binding };
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= static_cast<uint32_t>(layout_bindings.size());
+	layout_info.pBindings		= layout_bindings.data();
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_ObjectLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Object Descriptor Set Layout");
+}
+
+void Descriptors::CreateHiZSetLayout()
+{
+	// Livello sorgente: la depth del G-buffer o la mip precedente della piramide
+	VkDescriptorSetLayoutBinding source_layout_binding = {};
+	source_layout_binding.binding				= 0;
+	source_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	source_layout_binding.descriptorCount		= 1;
+	source_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	source_layout_binding.pImmutableSamplers	= nullptr;
+
+	VkDescriptorSetLayoutBinding destination_layout_binding = {};
+	destination_layout_binding.binding				= 1;
+	destination_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	destination_layout_binding.descriptorCount		= 1;
+	destination_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	destination_layout_binding.pImmutableSamplers	= nullptr;
+
+	std::vector<VkDescriptorSetLayoutBinding> layout_bindings = { source_layout_binding, destination_layout_binding };
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= static_cast<uint32_t>(layout_bindings.size());
+	layout_info.pBindings		= layout_bindings.data();
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_HiZLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Hi-Z Descriptor Set Layout");
+}
+
+void Descriptors::CreateCullSetLayout()
+{
+	std::vector<VkDescriptorSetLayoutBinding> layout_bindings;
+
+	// 0: comandi del DrawList, 1: sfere, 2: comandi visibili, 3: contatori per batch,
+	// 6: istanze del DrawList, 7: istanze visibili per comando, 8: istanze visibili
+	for (uint32_t binding : CULL_BUFFER_BINDINGS)
 	{
-		throw std::runtime_error("Failed to allocate the descriptor sets for the View and Projection matrices!");
+		VkDescriptorSetLayoutBinding buffer_layout_binding = {};
+		buffer_layout_binding.binding				= binding;
+		buffer_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		buffer_layout_binding.descriptorCount		= 1;
+		buffer_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+		buffer_layout_binding.pImmutableSamplers	= nullptr;
+
+		layout_bindings.push_back(buffer_layout_binding);
 	}
 
-	for (size_t i = 0; i < swapchain_size; ++i)
-	{
-		VkDescriptorBufferInfo vpBufferInfo = {};
-		vpBufferInfo.buffer = viewProjectionUBO[i];		
-		vpBufferInfo.offset = 0;						
-		vpBufferInfo.range	= dataSize;
+	VkDescriptorSetLayoutBinding hiz_layout_binding = {};
+	hiz_layout_binding.binding				= 4;
+	hiz_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	hiz_layout_binding.descriptorCount		= 1;
+	hiz_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	hiz_layout_binding.pImmutableSamplers	= nullptr;
 
-		VkWriteDescriptorSet vpSetWrite = {};
-		vpSetWrite.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		vpSetWrite.dstSet			= m_DescriptorSets[i];
-		vpSetWrite.dstBinding		= 0;									// Vogliamo aggiornare quello che binda su 0
-		vpSetWrite.dstArrayElement	= 0;									// Se avessimo un array questo
-		vpSetWrite.descriptorType	= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;	// Indice nell'array da aggiornare
-		vpSetWrite.descriptorCount	= 1;									// Numero di descriptor da aggiornare
-		vpSetWrite.pBufferInfo		= &vpBufferInfo;						// Informazioni a riguardo dei dati del buffer da bindare
+	VkDescriptorSetLayoutBinding cull_data_layout_binding = {};
+	cull_data_layout_binding.binding			= 5;
+	cull_data_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	cull_data_layout_binding.descriptorCount	= 1;
+	cull_data_layout_binding.stageFlags			= VK_SHADER_STAGE_COMPUTE_BIT;
+	cull_data_layout_binding.pImmutableSamplers	= nullptr;
 
-		std::vector<VkWriteDescriptorSet> setWrites = { vpSetWrite };
+	layout_bindings.push_back(hiz_layout_binding);
+	layout_bindings.push_back(cull_data_layout_binding);
 
-		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
-	}
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount	= static_cast<uint32_t>(layout_bindings.size());
+	layout_info.pBindings		= layout_bindings.data();
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_CullLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Cull Descriptor Set Layout");
+}
+
+// Texture bindless: gli elementi non scritti non vengono mai letti (partially bound), quelli nuovi si scrivono
+// anche con i command buffer del G-buffer in volo (update after bind)
+void Descriptors::CreateBindlessTextureSetLayout(uint32_t texture_count)
+{
+	m_BindlessTextureCount = texture_count;
+
+	VkDescriptorSetLayoutBinding textures_layout_binding = {};
+	textures_layout_binding.binding				= 0;
+	textures_layout_binding.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textures_layout_binding.descriptorCount		= texture_count;
+	textures_layout_binding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
+	textures_layout_binding.pImmutableSamplers	= nullptr;
+
+	const VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info = {};
+	binding_flags_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	binding_flags_info.bindingCount		= 1;
+	binding_flags_info.pBindingFlags	= &binding_flags;
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.pNext			= &binding_flags_info;
+	layout_info.flags			= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layout_info.bindingCount	= 1;
+	layout_info.pBindings		= &textures_layout_binding;
+
+	VkResult result = vkCreateDescriptorSetLayout(*m_Device, &layout_info, nullptr, &m_BindlessTextureLayout);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the Bindless Texture Descriptor Set Layout");
+}
+
+// Un solo set per tutti i frame: il buffer  l'uniform ring, l'offset del frame corrente arriva col bind (dynamic offset)
+void Descriptors::CreateViewProjectionDescriptorSet(const VkBuffer& uniform_ring, size_t data_size)
+{
+	m_ViewProjectionSet = AllocateUniformSet(m_ViewProjectionPool, m_ViewProjectionLayout, uniform_ring, data_size);
 }
 
-void Descriptors::CreateInputAttachmentsDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& position_buffer,
+void Descriptors::CreateInputAttachmentsDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& depth_buffer,
 	const std::vector<BufferImage>& color_buffer, const std::vector<BufferImage>& normal_buffer)
 {
 	m_InputDescriptorSets.resize(swapchain_size);
@@ -226,10 +455,11 @@ void Descriptors::CreateInputAttachmentsDescriptorSets(size_t swapchain_size, co
 
 	for (size_t i = 0; i < swapchain_size; i++)
 	{
-		VkDescriptorImageInfo positionImageInfo = {};
-		positionImageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		positionImageInfo.imageView		= position_buffer[i].ImageView;
-		positionImageInfo.sampler		= position_buffer[i].Sampler;
+		// La posizione non  pi salvata: il lighting pass la ricostruisce dalla depth
+		VkDescriptorImageInfo depthImageInfo = {};
+		depthImageInfo.imageLayout		= VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthImageInfo.imageView		= depth_buffer[i].ImageView;
+		depthImageInfo.sampler			= depth_buffer[i].Sampler;
 
 		VkDescriptorImageInfo colourImageInfo = {};
 		colourImageInfo.imageLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -241,14 +471,14 @@ void Descriptors::CreateInputAttachmentsDescriptorSets(size_t swapchain_size, co
 		normalImageInfo.imageView		= normal_buffer[i].ImageView;
 		normalImageInfo.sampler			= normal_buffer[i].Sampler;
 
-		VkWriteDescriptorSet positionWrite = {};
-		positionWrite.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		positionWrite.dstSet			= m_InputDescriptorSets[i];
-		positionWrite.dstBinding		= 0;
-		positionWrite.dstArrayElement	= 0;
-		positionWrite.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		positionWrite.descriptorCount	= 1;
-		positionWrite.pImageInfo		= &positionImageInfo;
+		VkWriteDescriptorSet depthWrite = {};
+		depthWrite.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		depthWrite.dstSet				= m_InputDescriptorSets[i];
+		depthWrite.dstBinding			= 0;
+		depthWrite.dstArrayElement		= 0;
+		depthWrite.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		depthWrite.descriptorCount		= 1;
+		depthWrite.pImageInfo			= &depthImageInfo;
 
 		VkWriteDescriptorSet colourWrite = {};
 		colourWrite.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -268,94 +498,504 @@ void Descriptors::CreateInputAttachmentsDescriptorSets(size_t swapchain_size, co
 		normalWrite.descriptorCount		= 1;
 		normalWrite.pImageInfo			= &normalImageInfo;
 
-		std::vector<VkWriteDescriptorSet> setWrites = { positionWrite, colourWrite, normalWrite };
+		std::vector<VkWriteDescriptorSet> setWrites = { depthWrite, colourWrite, normalWrite };
 
 		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
 	}
 }
 
-void Descriptors::CreateLightDescriptorSets(const std::vector<VkBuffer>& ubo_light, size_t data_size, size_t swapchain_images)
+void Descriptors::CreateLightDescriptorSet(const VkBuffer& light_buffer, size_t lights_size)
 {
-	m_LightDescriptorSets.resize(swapchain_images);
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_LightPool;
+	allocate_info.descriptorSetCount	= 1;
+	allocate_info.pSetLayouts			= &m_LightLayout;
 
-	std::vector<VkDescriptorSetLayout> desc_set_layouts(swapchain_images, m_LightLayout);
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, &m_LightSet);
 
-	VkDescriptorSetAllocateInfo light_allocate_info = {};
-	light_allocate_info.sType				= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	light_allocate_info.descriptorPool		= m_LightPool;
-	light_allocate_info.descriptorSetCount	= static_cast<uint32_t>(swapchain_images);
-	light_allocate_info.pSetLayouts			= desc_set_layouts.data();
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate the Light Descriptor Set!");
+	}
+
+	VkDescriptorBufferInfo lights_info = {};
+	lights_info.buffer	= light_buffer;
+	lights_info.offset	= 0;			// Dynamic offset: slice del frame corrente
+	lights_info.range	= lights_size;
+
+	VkWriteDescriptorSet set_write = {};
+	set_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	set_write.dstSet			= m_LightSet;
+	set_write.dstBinding		= 0;
+	set_write.dstArrayElement	= 0;
+	set_write.descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	set_write.descriptorCount	= 1;
+	set_write.pBufferInfo		= &lights_info;
+
+	vkUpdateDescriptorSets(*m_Device, 1, &set_write, 0, nullptr);
+}
+
+void Descriptors::CreateSettingsDescriptorSet(const VkBuffer& uniform_ring, size_t data_size)
+{
+	m_SettingsSet = AllocateUniformSet(m_SettingsPool, m_SettingsLayout, uniform_ring, data_size);
+}
+
+void Descriptors::CreateTiledLightingDescriptorSets(size_t swapchain_size, const VkBuffer& light_buffer, size_t lights_size,
+	const VkBuffer& uniform_ring, const std::vector<BufferImage>& lighting_buffer)
+{
+	m_TiledLightingSets.resize(swapchain_size);
 
-	VkResult result = vkAllocateDescriptorSets(*m_Device, &light_allocate_info, m_LightDescriptorSets.data());
+	std::vector<VkDescriptorSetLayout> set_layouts(swapchain_size, m_TiledLightingLayout);
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_TiledLightingPool;
+	allocate_info.descriptorSetCount	= static_cast<uint32_t>(swapchain_size);
+	allocate_info.pSetLayouts			= set_layouts.data();
+
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, m_TiledLightingSets.data());
 
 	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to allocate Light Attachment Descriptor Sets!");
+		throw std::runtime_error("Failed to allocate Tiled Lighting Descriptor Sets!");
 	}
 
-	for (size_t i = 0; i < swapchain_images; i++)
+	for (size_t i = 0; i < swapchain_size; i++)
 	{
-		VkDescriptorBufferInfo light_buffer_info = {};
-		light_buffer_info.buffer = ubo_light[i];		
-		light_buffer_info.offset = 0;				
-		light_buffer_info.range	 = data_size;
+		VkDescriptorBufferInfo lights_info = {};
+		lights_info.buffer	= light_buffer;
+		lights_info.offset	= 0;			// Dynamic offset, come per gli uniform buffer
+		lights_info.range	= lights_size;
+
+		VkDescriptorImageInfo output_info = {};
+		output_info.imageLayout	= VK_IMAGE_LAYOUT_GENERAL;
+		output_info.imageView	= lighting_buffer[i].ImageView;
+		output_info.sampler		= VK_NULL_HANDLE;
+
+		VkDescriptorBufferInfo stats_info = {};
+		stats_info.buffer	= uniform_ring;
+		stats_info.offset	= 0;
+		stats_info.range	= sizeof(TiledLightingStats);
+
+		VkWriteDescriptorSet lights_write = {};
+		lights_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		lights_write.dstSet				= m_TiledLightingSets[i];
+		lights_write.dstBinding			= 0;
+		lights_write.dstArrayElement	= 0;
+		lights_write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		lights_write.descriptorCount	= 1;
+		lights_write.pBufferInfo		= &lights_info;
+
+		VkWriteDescriptorSet output_write = {};
+		output_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		output_write.dstSet				= m_TiledLightingSets[i];
+		output_write.dstBinding			= 1;
+		output_write.dstArrayElement	= 0;
+		output_write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		output_write.descriptorCount	= 1;
+		output_write.pImageInfo			= &output_info;
+
+		VkWriteDescriptorSet stats_write = {};
+		stats_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		stats_write.dstSet				= m_TiledLightingSets[i];
+		stats_write.dstBinding			= 2;
+		stats_write.dstArrayElement		= 0;
+		stats_write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		stats_write.descriptorCount		= 1;
+		stats_write.pBufferInfo			= &stats_info;
+
+		std::vector<VkWriteDescriptorSet> set_writes = { lights_write, output_write, stats_write };
+
+		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
+	}
+}
 
-		VkWriteDescriptorSet light_set_write = {};
-		light_set_write.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		light_set_write.dstSet			= m_LightDescriptorSets[i];
-		light_set_write.dstBinding		= 0;									
-		light_set_write.dstArrayElement	= 0;									
-		light_set_write.descriptorType	= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		light_set_write.descriptorCount	= 1;									
-		light_set_write.pBufferInfo		= &light_buffer_info;					
+void Descriptors::CreateCompositeDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& lighting_buffer)
+{
+	m_CompositeSets.resize(swapchain_size);
 
-		std::vector<VkWriteDescriptorSet> set_writes = { light_set_write };
+	std::vector<VkDescriptorSetLayout> set_layouts(swapchain_size, m_CompositeLayout);
 
-		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_CompositePool;
+	allocate_info.descriptorSetCount	= static_cast<uint32_t>(swapchain_size);
+	allocate_info.pSetLayouts			= set_layouts.data();
+
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, m_CompositeSets.data());
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate Composite Descriptor Sets!");
+	}
+
+	for (size_t i = 0; i < swapchain_size; i++)
+	{
+		VkDescriptorImageInfo lighting_info = {};
+		lighting_info.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		lighting_info.imageView		= lighting_buffer[i].ImageView;
+		lighting_info.sampler		= lighting_buffer[i].Sampler;
+
+		VkWriteDescriptorSet set_write = {};
+		set_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		set_write.dstSet			= m_CompositeSets[i];
+		set_write.dstBinding		= 0;
+		set_write.dstArrayElement	= 0;
+		set_write.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		set_write.descriptorCount	= 1;
+		set_write.pImageInfo		= &lighting_info;
+
+		vkUpdateDescriptorSets(*m_Device, 1, &set_write, 0, nullptr);
+	}
+}
+
+// Un solo set: luci nel light buffer e cluster nell'uniform ring, gli offset del frame arrivano col bind
+void Descriptors::CreateClusterDescriptorSet(const VkBuffer& light_buffer, size_t lights_size, const VkBuffer& uniform_ring, size_t clusters_size)
+{
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_ClusterPool;
+	allocate_info.descriptorSetCount	= 1;
+	allocate_info.pSetLayouts			= &m_ClusterLayout;
+
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, &m_ClusterSet);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate the Cluster Descriptor Set!");
+	}
+
+	VkDescriptorBufferInfo lights_info = {};
+	lights_info.buffer	= light_buffer;
+	lights_info.offset	= 0;
+	lights_info.range	= lights_size;
+
+	VkDescriptorBufferInfo clusters_info = {};
+	clusters_info.buffer	= uniform_ring;
+	clusters_info.offset	= 0;
+	clusters_info.range		= clusters_size;
+
+	VkWriteDescriptorSet lights_write = {};
+	lights_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	lights_write.dstSet				= m_ClusterSet;
+	lights_write.dstBinding			= 0;
+	lights_write.dstArrayElement	= 0;
+	lights_write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	lights_write.descriptorCount	= 1;
+	lights_write.pBufferInfo		= &lights_info;
+
+	VkWriteDescriptorSet clusters_write = lights_write;
+	clusters_write.dstBinding		= 1;
+	clusters_write.pBufferInfo		= &clusters_info;
+
+	std::vector<VkWriteDescriptorSet> set_writes = { lights_write, clusters_write };
+
+	vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
+}
+
+// Object buffer (model + normal matrix per object ID), una slice per frame in flight: il range  una slice
+void Descriptors::CreateObjectDescriptorSet(const VkBuffer& object_buffer, size_t objects_size)
+{
+	m_ObjectSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (auto& object_set : m_ObjectSets)
+		object_set = AllocateUniformSet(m_ObjectPool, m_ObjectLayout, object_buffer, objects_size, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+}
+
+// Un solo set per tutta la sessione, il TextureLoader scrive l'elemento di ogni texture creata
+void Descriptors::CreateBindlessTextureDescriptorSet()
+{
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount	= m_BindlessTextureCount;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags			= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	pool_info.maxSets		= 1;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes	= &pool_size;
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_BindlessTexturePool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Bindless Texture Descriptor Pool!");
+	}
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_BindlessTexturePool;
+	allocate_info.descriptorSetCount	= 1;
+	allocate_info.pSetLayouts			= &m_BindlessTextureLayout;
+
+	result = vkAllocateDescriptorSets(*m_Device, &allocate_info, &m_BindlessTextureSet);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate the Bindless Texture Descriptor Set!");
 	}
 }
 
-void Descriptors::CreateSettingsDescriptorSets(const std::vector<VkBuffer>& ubo_settings, size_t data_size, size_t swapchain_images)
+void Descriptors::CreateHiZDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& depth_buffer, const HiZPyramid& pyramid)
 {
-	m_SettingsDescriptorSets.resize(swapchain_images);
+	const size_t mip_count = pyramid.MipViews.size();
+
+	m_HiZSets.resize(swapchain_size + mip_count - 1);
 
-	std::vector<VkDescriptorSetLayout> desc_set_layouts(swapchain_images, m_SettingsLayout);
+	std::vector<VkDescriptorSetLayout> set_layouts(m_HiZSets.size(), m_HiZLayout);
 
-	VkDescriptorSetAllocateInfo settings_allocate_info = {};
-	settings_allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	settings_allocate_info.descriptorPool			= m_SettingsPool;
-	settings_allocate_info.descriptorSetCount		= static_cast<uint32_t>(swapchain_images);
-	settings_allocate_info.pSetLayouts				= desc_set_layouts.data();
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_HiZPool;
+	allocate_info.descriptorSetCount	= static_cast<uint32_t>(m_HiZSets.size());
+	allocate_info.pSetLayouts			= set_layouts.data();
 
-	VkResult result = vkAllocateDescriptorSets(*m_Device, &settings_allocate_info, m_SettingsDescriptorSets.data());
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, m_HiZSets.data());
 
 	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to allocate Settings Attachment Descriptor Sets!");
+		throw std::runtime_error("Failed to allocate Hi-Z Descriptor Sets!");
+	}
+
+	for (size_t i = 0; i < m_HiZSets.size(); i++)
+	{
+		const bool from_depth = i < swapchain_size;
+
+		// La depth resta nel layout finale del render pass offscreen, la piramide sempre in GENERAL
+		VkDescriptorImageInfo source_info = {};
+		source_info.imageLayout	= from_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+		source_info.imageView	= from_depth ? depth_buffer[i].ImageView : pyramid.MipViews[i - swapchain_size];
+		source_info.sampler		= from_depth ? depth_buffer[i].Sampler : pyramid.Image.Sampler;
+
+		VkDescriptorImageInfo destination_info = {};
+		destination_info.imageLayout	= VK_IMAGE_LAYOUT_GENERAL;
+		destination_info.imageView		= from_depth ? pyramid.MipViews[0] : pyramid.MipViews[i - swapchain_size + 1];
+		destination_info.sampler		= VK_NULL_HANDLE;
+
+		VkWriteDescriptorSet source_write = {};
+		source_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		source_write.dstSet				= m_HiZSets[i];
+		source_write.dstBinding			= 0;
+		source_write.dstArrayElement	= 0;
+		source_write.descriptorType		= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		source_write.descriptorCount	= 1;
+		source_write.pImageInfo			= &source_info;
+
+		VkWriteDescriptorSet destination_write = {};
+		destination_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		destination_write.dstSet			= m_HiZSets[i];
+		destination_write.dstBinding		= 1;
+		destination_write.dstArrayElement	= 0;
+		destination_write.descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		destination_write.descriptorCount	= 1;
+		destination_write.pImageInfo		= &destination_info;
+
+		std::vector<VkWriteDescriptorSet> set_writes = { source_write, destination_write };
+
+		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
 	}
+}
+
+// I buffer del DrawList cambiano con la scena: qui si scrivono solo Hi-Z e CullData, il resto in UpdateCullBuffers
+void Descriptors::CreateCullDescriptorSet(const VkBuffer& uniform_ring, const HiZPyramid& pyramid)
+{
+	std::vector<VkDescriptorSetLayout> set_layouts(MAX_FRAMES_IN_FLIGHT, m_CullLayout);
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= m_CullPool;
+	allocate_info.descriptorSetCount	= static_cast<uint32_t>(set_layouts.size());
+	allocate_info.pSetLayouts			= set_layouts.data();
 
-	for (size_t i = 0; i < swapchain_images; i++)
+	m_CullSets.resize(set_layouts.size());
+
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, m_CullSets.data());
+
+	if (result != VK_SUCCESS)
 	{
-		VkDescriptorBufferInfo settings_buffer_info = {};
-		settings_buffer_info.buffer = ubo_settings[i];
-		settings_buffer_info.offset = 0;
-		settings_buffer_info.range	= data_size;
+		throw std::runtime_error("Failed to allocate the Cull Descriptor Sets!");
+	}
 
-		VkWriteDescriptorSet settings_set_write = {};
-		settings_set_write.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		settings_set_write.dstSet			= m_SettingsDescriptorSets[i];
-		settings_set_write.dstBinding		= 0;
-		settings_set_write.dstArrayElement	= 0;
-		settings_set_write.descriptorType	= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		settings_set_write.descriptorCount	= 1;
-		settings_set_write.pBufferInfo		= &settings_buffer_info;
+	VkDescriptorImageInfo hiz_info = {};
+	hiz_info.imageLayout	= VK_IMAGE_LAYOUT_GENERAL;
+	hiz_info.imageView		= pyramid.Image.ImageView;
+	hiz_info.sampler		= pyramid.Image.Sampler;
+
+	VkDescriptorBufferInfo cull_data_info = {};
+	cull_data_info.buffer	= uniform_ring;
+	cull_data_info.offset	= 0;
+	cull_data_info.range	= sizeof(CullData);
+
+	VkWriteDescriptorSet hiz_write = {};
+	hiz_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	hiz_write.dstBinding		= 4;
+	hiz_write.dstArrayElement	= 0;
+	hiz_write.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	hiz_write.descriptorCount	= 1;
+	hiz_write.pImageInfo		= &hiz_info;
+
+	VkWriteDescriptorSet cull_data_write = {};
+	cull_data_write.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	cull_data_write.dstBinding		= 5;
+	cull_data_write.dstArrayElement	= 0;
+	cull_data_write.descriptorType	= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	cull_data_write.descriptorCount	= 1;
+	cull_data_write.pBufferInfo		= &cull_data_info;
+
+	for (VkDescriptorSet cull_set : m_CullSets)
+	{
+		hiz_write.dstSet		= cull_set;
+		cull_data_write.dstSet	= cull_set;
 
-		std::vector<VkWriteDescriptorSet> set_writes = { settings_set_write };
+		std::vector<VkWriteDescriptorSet> set_writes = { hiz_write, cull_data_write };
 
 		vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
 	}
 }
 
+// Il DrawList  stato ricostruito: i binding dei buffer del set di 'frame' (la sua fence  gi SIGNALED) puntano ai nuovi buffer
+void Descriptors::UpdateCullBuffers(size_t frame, const VkBuffer& commands, const VkBuffer& cull_inputs, const VkBuffer& culled_commands, const VkBuffer& counts,
+	const VkBuffer& draw_instances, const VkBuffer& instance_counts, const VkBuffer& culled_instances)
+{
+	const VkBuffer buffers[] = { commands, cull_inputs, culled_commands, counts, draw_instances, instance_counts, culled_instances };
+	constexpr uint32_t buffer_count = static_cast<uint32_t>(CULL_BUFFER_BINDINGS.size());
+
+	VkDescriptorBufferInfo buffer_infos[buffer_count] = {};
+	VkWriteDescriptorSet set_writes[buffer_count] = {};
+
+	for (uint32_t i = 0; i < buffer_count; ++i)
+	{
+		buffer_infos[i].buffer	= buffers[i];
+		buffer_infos[i].offset	= 0;
+		buffer_infos[i].range	= VK_WHOLE_SIZE;
+
+		set_writes[i].sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		set_writes[i].dstSet			= m_CullSets[frame];
+		set_writes[i].dstBinding		= CULL_BUFFER_BINDINGS[i];
+		set_writes[i].dstArrayElement	= 0;
+		set_writes[i].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		set_writes[i].descriptorCount	= 1;
+		set_writes[i].pBufferInfo		= &buffer_infos[i];
+	}
+
+	vkUpdateDescriptorSets(*m_Device, buffer_count, set_writes, 0, nullptr);
+}
+
+// Il DrawList  stato ricostruito: il binding 1 dell'object set di 'frame' punta alle nuove istanze delle draw
+void Descriptors::UpdateDrawInstanceBuffer(size_t frame, const VkBuffer& draw_instances)
+{
+	VkDescriptorBufferInfo instances_info = {};
+	instances_info.buffer	= draw_instances;
+	instances_info.offset	= 0;
+	instances_info.range	= VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet instances_write = {};
+	instances_write.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	instances_write.dstSet			= m_ObjectSets[frame];
+	instances_write.dstBinding		= 1;
+	instances_write.dstArrayElement	= 0;
+	instances_write.descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instances_write.descriptorCount	= 1;
+	instances_write.pBufferInfo		= &instances_info;
+
+	vkUpdateDescriptorSets(*m_Device, 1, &instances_write, 0, nullptr);
+}
+
+// L'object buffer  cresciuto (a device idle): il binding 0 di ogni object set punta al nuovo buffer
+void Descriptors::UpdateObjectBufferDescriptor(const VkBuffer& object_buffer, size_t objects_size)
+{
+	VkDescriptorBufferInfo objects_info = {};
+	objects_info.buffer	= object_buffer;
+	objects_info.offset	= 0;
+	objects_info.range	= objects_size;
+
+	VkWriteDescriptorSet objects_write = {};
+	objects_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	objects_write.dstBinding		= 0;
+	objects_write.dstArrayElement	= 0;
+	objects_write.descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	objects_write.descriptorCount	= 1;
+	objects_write.pBufferInfo		= &objects_info;
+
+	for (VkDescriptorSet object_set : m_ObjectSets)
+	{
+		objects_write.dstSet = object_set;
+		vkUpdateDescriptorSets(*m_Device, 1, &objects_write, 0, nullptr);
+	}
+}
+
+// Il LightManager ha ricreato il light buffer (pi luci): il binding 0 di ogni set che lo legge punta al nuovo buffer
+void Descriptors::UpdateLightBufferDescriptors(const VkBuffer& light_buffer, size_t lights_size)
+{
+	VkDescriptorBufferInfo lights_info = {};
+	lights_info.buffer	= light_buffer;
+	lights_info.offset	= 0;
+	lights_info.range	= lights_size;
+
+	VkWriteDescriptorSet lights_write = {};
+	lights_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	lights_write.dstBinding			= 0;
+	lights_write.dstArrayElement	= 0;
+	lights_write.descriptorType		= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	lights_write.descriptorCount	= 1;
+	lights_write.pBufferInfo		= &lights_info;
+
+	std::vector<VkWriteDescriptorSet> set_writes;
+
+	lights_write.dstSet = m_LightSet;
+	set_writes.push_back(lights_write);
+
+	lights_write.dstSet = m_ClusterSet;
+	set_writes.push_back(lights_write);
+
+	for (const auto& tiled_set : m_TiledLightingSets)
+	{
+		lights_write.dstSet = tiled_set;
+		set_writes.push_back(lights_write);
+	}
+
+	vkUpdateDescriptorSets(*m_Device, static_cast<uint32_t>(set_writes.size()), set_writes.data(), 0, nullptr);
+}
+
+VkDescriptorSet Descriptors::AllocateUniformSet(const VkDescriptorPool& pool, const VkDescriptorSetLayout& layout, const VkBuffer& buffer, size_t data_size,
+	VkDescriptorType type)
+{
+	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool		= pool;
+	allocate_info.descriptorSetCount	= 1;
+	allocate_info.pSetLayouts			= &layout;
+
+	VkResult result = vkAllocateDescriptorSets(*m_Device, &allocate_info, &descriptor_set);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate a Uniform Descriptor Set!");
+	}
+
+	VkDescriptorBufferInfo buffer_info = {};
+	buffer_info.buffer	= buffer;
+	buffer_info.offset	= 0;				// L'offset vero  il dynamic offset passato a vkCmdBindDescriptorSets
+	buffer_info.range	= data_size;
+
+	VkWriteDescriptorSet set_write = {};
+	set_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	set_write.dstSet			= descriptor_set;
+	set_write.dstBinding		= 0;
+	set_write.dstArrayElement	= 0;
+	set_write.descriptorType	= type;
+	set_write.descriptorCount	= 1;
+	set_write.pBufferInfo		= &buffer_info;
+
+	vkUpdateDescriptorSets(*m_Device, 1, &set_write, 0, nullptr);
+
+	return descriptor_set;
+}
+
 VkDescriptorSetLayout& Descriptors::GetViewProjectionSetLayout()
 {
 	return m_ViewProjectionLayout;
@@ -381,6 +1021,41 @@ VkDescriptorSetLayout& Descriptors::GetSettingsSetLayout()
 	return m_SettingsLayout;
 }
 
+VkDescriptorSetLayout& Descriptors::GetTiledLightingSetLayout()
+{
+	return m_TiledLightingLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetCompositeSetLayout()
+{
+	return m_CompositeLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetClusterSetLayout()
+{
+	return m_ClusterLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetObjectSetLayout()
+{
+	return m_ObjectLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetHiZSetLayout()
+{
+	return m_HiZLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetCullSetLayout()
+{
+	return m_CullLayout;
+}
+
+VkDescriptorSetLayout& Descriptors::GetBindlessTextureSetLayout()
+{
+	return m_BindlessTextureLayout;
+}
+
 VkDescriptorPool& Descriptors::GetVpPool()
 {
 	return m_ViewProjectionPool;
@@ -411,9 +1086,9 @@ VkDescriptorPool& Descriptors::GetSettingsPool()
 	return m_SettingsPool;
 }
 
-std::vector<VkDescriptorSet>& Descriptors::GetDescriptorSets()
+VkDescriptorSet& Descriptors::GetViewProjectionDescriptorSet()
 {
-	return m_DescriptorSets;
+	return m_ViewProjectionSet;
 }
 
 std::vector<VkDescriptorSet>& Descriptors::GetInputDescriptorSets()
@@ -421,14 +1096,49 @@ std::vector<VkDescriptorSet>& Descriptors::GetInputDescriptorSets()
 	return m_InputDescriptorSets;
 }
 
-std::vector<VkDescriptorSet>& Descriptors::GetLightDescriptorSets()
+VkDescriptorSet& Descriptors::GetLightDescriptorSet()
+{
+	return m_LightSet;
+}
+
+VkDescriptorSet& Descriptors::GetSettingsDescriptorSet()
+{
+	return m_SettingsSet;
+}
+
+std::vector<VkDescriptorSet>& Descriptors::GetTiledLightingDescriptorSets()
+{
+	return m_TiledLightingSets;
+}
+
+std::vector<VkDescriptorSet>& Descriptors::GetCompositeDescriptorSets()
+{
+	return m_CompositeSets;
+}
+
+VkDescriptorSet& Descriptors::GetClusterDescriptorSet()
+{
+	return m_ClusterSet;
+}
+
+VkDescriptorSet& Descriptors::GetObjectDescriptorSet(size_t frame)
+{
+	return m_ObjectSets[frame];
+}
+
+std::vector<VkDescriptorSet>& Descriptors::GetHiZDescriptorSets()
+{
+	return m_HiZSets;
+}
+
+VkDescriptorSet& Descriptors::GetCullDescriptorSet(size_t frame)
 {
-	return m_LightDescriptorSets;
+	return m_CullSets[frame];
 }
 
-std::vector<VkDescriptorSet>& Descriptors::GetSettingsDescriptorSets()
+VkDescriptorSet& Descriptors::GetBindlessTextureSet()
 {
-	return m_SettingsDescriptorSets;
+	return m_BindlessTextureSet;
 }
 
 void Descriptors::DestroyTexturePool()
@@ -466,31 +1176,44 @@ void Descriptors::DestroySettingsLayout()
 	vkDestroyDescriptorSetLayout(*m_Device, m_SettingsLayout, nullptr);
 }
 
-void Descriptors::CreateViewProjectionPool(size_t numOfSwapImgs, size_t UBOsize)
+void Descriptors::DestroyTiledLightingLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_TiledLightingLayout, nullptr);
+}
+
+void Descriptors::DestroyCompositeLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_CompositeLayout, nullptr);
+}
+
+void Descriptors::DestroyClusterLayout()
 {
-	VkDescriptorPoolSize vpPoolSize = {};
-	vpPoolSize.type				= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;			   // Che tipo di descriptor contiene (non  un descriptor set ma sono quelli presenti negli shaders)
-	vpPoolSize.descriptorCount	= static_cast<uint32_t> (UBOsize); // Quanti descriptor
+	vkDestroyDescriptorSetLayout(*m_Device, m_ClusterLayout, nullptr);
+}
 
-	// MODEL (DYNAMIC UBO)
-	/*VkDescriptorPoolSize modelPoolSize = {};
-	modelPoolSize.type			  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	modelPoolSize.descriptorCount = static_cast<uint32_t>(m_modelDynamicUBO.size()); */
+void Descriptors::DestroyObjectLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_ObjectLayout, nullptr);
+}
 
-	std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize };
+void Descriptors::DestroyHiZLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_HiZLayout, nullptr);
+}
 
-	VkDescriptorPoolCreateInfo poolCreateInfo = {};
-	poolCreateInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolCreateInfo.maxSets			= static_cast<uint32_t>(numOfSwapImgs); // un descriptor set per ogni commandbuffer/swapimage
-	poolCreateInfo.poolSizeCount	= static_cast<uint32_t>(descriptorPoolSizes.size());											  // Quante pool
-	poolCreateInfo.pPoolSizes		= descriptorPoolSizes.data();		// Array di pool size
+void Descriptors::DestroyCullLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_CullLayout, nullptr);
+}
 
-	VkResult result = vkCreateDescriptorPool(*m_Device, &poolCreateInfo, nullptr, &m_ViewProjectionPool);
+void Descriptors::DestroyBindlessTextureLayout()
+{
+	vkDestroyDescriptorSetLayout(*m_Device, m_BindlessTextureLayout, nullptr);
+}
 
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create a Descriptor Pool!");
-	}
+void Descriptors::CreateViewProjectionPool()
+{
+	CreateUniformPool(m_ViewProjectionPool);
 }
 
 void Descriptors::CreateTexturePool()
@@ -574,19 +1297,17 @@ void Descriptors::CreateInputAttachmentsPool(size_t numOfSwapImgs)
 	}
 }
 
-void Descriptors::CreateLightPool(size_t swapchain_images, size_t ubo_size)
+void Descriptors::CreateLightPool()
 {
-	VkDescriptorPoolSize light_pool_size = {};
-	light_pool_size.type			= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	light_pool_size.descriptorCount = static_cast<uint32_t> (ubo_size); 
-
-	std::vector<VkDescriptorPoolSize> pool_sizes = { light_pool_size };
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	pool_size.descriptorCount	= 1;
 
 	VkDescriptorPoolCreateInfo pool_info = {};
 	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	pool_info.maxSets		= static_cast<uint32_t>(swapchain_images);
-	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());											  
-	pool_info.pPoolSizes	= pool_sizes.data();		
+	pool_info.maxSets		= 1;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes	= &pool_size;
 
 	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_LightPool);
 
@@ -594,28 +1315,183 @@ void Descriptors::CreateLightPool(size_t swapchain_images, size_t ubo_size)
 	{
 		throw std::runtime_error("Failed to create the Light Descriptor Pool!");
 	}
+}
 
+void Descriptors::CreateSettingsPool()
+{
+	CreateUniformPool(m_SettingsPool);
 }
 
-void Descriptors::CreateSettingsPool(size_t swapchain_images, size_t ubo_size)
+void Descriptors::CreateTiledLightingPool(size_t swapchain_images)
 {
-	VkDescriptorPoolSize settings_pool_size = {};
-	settings_pool_size.type				= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	settings_pool_size.descriptorCount	= static_cast<uint32_t> (ubo_size);
+	// Luci e contatori: due dynamic storage buffer per set
+	VkDescriptorPoolSize lights_pool_size = {};
+	lights_pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	lights_pool_size.descriptorCount	= static_cast<uint32_t>(swapchain_images) * 2;
+
+	VkDescriptorPoolSize output_pool_size = {};
+	output_pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	output_pool_size.descriptorCount	= static_cast<uint32_t>(swapchain_images);
+
+	std::vector<VkDescriptorPoolSize> pool_sizes = { lights_pool_size, output_pool_size };
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= static_cast<uint32_t>(swapchain_images);
+	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+	pool_info.pPoolSizes	= pool_sizes.data();
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_TiledLightingPool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Tiled Lighting Descriptor Pool!");
+	}
+}
 
-	std::vector<VkDescriptorPoolSize> pool_sizes = { settings_pool_size };
+void Descriptors::CreateCompositePool(size_t swapchain_images)
+{
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount	= static_cast<uint32_t>(swapchain_images);
 
 	VkDescriptorPoolCreateInfo pool_info = {};
 	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	pool_info.maxSets		= static_cast<uint32_t>(swapchain_images);
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes	= &pool_size;
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_CompositePool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Composite Descriptor Pool!");
+	}
+}
+
+void Descriptors::CreateClusterPool()
+{
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	pool_size.descriptorCount	= 2;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= 1;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes	= &pool_size;
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_ClusterPool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Cluster Descriptor Pool!");
+	}
+}
+
+void Descriptors::CreateObjectPool()
+{
+	VkDescriptorPoolSize objects_pool_size = {};
+	objects_pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	objects_pool_size.descriptorCount	= MAX_FRAMES_IN_FLIGHT;
+
+	VkDescriptorPoolSize instances_pool_size = {};
+	instances_pool_size.type			= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instances_pool_size.descriptorCount	= MAX_FRAMES_IN_FLIGHT;
+
+	std::vector<VkDescriptorPoolSize> pool_sizes = { objects_pool_size, instances_pool_size };
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= MAX_FRAMES_IN_FLIGHT;
+	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+	pool_info.pPoolSizes	= pool_sizes.data();
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_ObjectPool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Object Descriptor Pool!");
+	}
+}
+
+// Un set per immagine della swapchain (mip 0) + uno per ogni mip successiva
+void Descriptors::CreateHiZPool(size_t swapchain_images)
+{
+	const uint32_t set_count = static_cast<uint32_t>(swapchain_images) + HIZ_MAX_LEVELS;
+
+	VkDescriptorPoolSize source_pool_size = {};
+	source_pool_size.type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	source_pool_size.descriptorCount	= set_count;
+
+	VkDescriptorPoolSize destination_pool_size = {};
+	destination_pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	destination_pool_size.descriptorCount	= set_count;
+
+	std::vector<VkDescriptorPoolSize> pool_sizes = { source_pool_size, destination_pool_size };
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= set_count;
 	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
 	pool_info.pPoolSizes	= pool_sizes.data();
 
-	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_SettingsPool);
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_HiZPool);
 
 	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to create the Settings Descriptor Pool!");
+		throw std::runtime_error("Failed to create the Hi-Z Descriptor Pool!");
+	}
+}
+
+void Descriptors::CreateCullPool()
+{
+	VkDescriptorPoolSize buffers_pool_size = {};
+	buffers_pool_size.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	buffers_pool_size.descriptorCount	= static_cast<uint32_t>(CULL_BUFFER_BINDINGS.size()) * MAX_FRAMES_IN_FLIGHT;
+
+	VkDescriptorPoolSize hiz_pool_size = {};
+	hiz_pool_size.type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	hiz_pool_size.descriptorCount	= MAX_FRAMES_IN_FLIGHT;
+
+	VkDescriptorPoolSize cull_data_pool_size = {};
+	cull_data_pool_size.type			= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	cull_data_pool_size.descriptorCount	= MAX_FRAMES_IN_FLIGHT;
+
+	std::vector<VkDescriptorPoolSize> pool_sizes = { buffers_pool_size, hiz_pool_size, cull_data_pool_size };
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= MAX_FRAMES_IN_FLIGHT;
+	pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+	pool_info.pPoolSizes	= pool_sizes.data();
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &m_CullPool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the Cull Descriptor Pool!");
+	}
+}
+
+// Pool per un singolo set con un dynamic uniform (o storage) buffer
+void Descriptors::CreateUniformPool(VkDescriptorPool& pool, VkDescriptorType type)
+{
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type				= type;
+	pool_size.descriptorCount	= 1;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets		= 1;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes	= &pool_size;
+
+	VkResult result = vkCreateDescriptorPool(*m_Device, &pool_info, nullptr, &pool);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Uniform Descriptor Pool!");
 	}
 }
 
@@ -638,3 +1514,38 @@ void Descriptors::DestroySettingsPool()
 {
 	vkDestroyDescriptorPool(*m_Device, m_SettingsPool, nullptr);
 }
+
+void Descriptors::DestroyTiledLightingPool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_TiledLightingPool, nullptr);
+}
+
+void Descriptors::DestroyCompositePool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_CompositePool, nullptr);
+}
+
+void Descriptors::DestroyClusterPool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_ClusterPool, nullptr);
+}
+
+void Descriptors::DestroyObjectPool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_ObjectPool, nullptr);
+}
+
+void Descriptors::DestroyHiZPool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_HiZPool, nullptr);
+}
+
+void Descriptors::DestroyCullPool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_CullPool, nullptr);
+}
+
+void Descriptors::DestroyBindlessTexturePool()
+{
+	vkDestroyDescriptorPool(*m_Device, m_BindlessTexturePool, nullptr);
+}
@@ -2,26 +2,50 @@
 
 #include "pch.h"
 
+// Buffer del set del culling, nell'ordine dei parametri di UpdateCullBuffers (4 e' la Hi-Z, 5 il CullData)
+constexpr std::array<uint32_t, 7> CULL_BUFFER_BINDINGS = { 0, 1, 2, 3, 6, 7, 8 };
+
 class Descriptors
 {
 public:
 	Descriptors();
 	Descriptors(VkDevice* device);
 
-	void CreateDescriptorPools(size_t swapchain_images, size_t vp_ubo_size, size_t light_ubo_size, size_t settings_ubo_size);
+	void CreateDescriptorPools(size_t swapchain_images);
+	void RecreateSwapChainPools(size_t swapchain_images);
 	void CreateSetLayouts();
 
-	void CreateViewProjectionDescriptorSets(const std::vector<VkBuffer>& view_projection_ubo, size_t data_size, size_t swapchain_images);
-	void CreateInputAttachmentsDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& position_buffer, 
+	void CreateViewProjectionDescriptorSet(const VkBuffer& uniform_ring, size_t data_size);
+	void CreateInputAttachmentsDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& depth_buffer, 
 		const std::vector<BufferImage>& color_buffer, const std::vector<BufferImage>& normal_buffer);
-	void CreateLightDescriptorSets(const std::vector<VkBuffer>& ubo_light, size_t data_size, size_t swapchain_images);
-	void CreateSettingsDescriptorSets(const std::vector<VkBuffer>& ubo_settings, size_t data_size, size_t swapchain_images);
+	void CreateLightDescriptorSet(const VkBuffer& light_buffer, size_t lights_size);
+	void CreateSettingsDescriptorSet(const VkBuffer& uniform_ring, size_t data_size);
+	void CreateTiledLightingDescriptorSets(size_t swapchain_size, const VkBuffer& light_buffer, size_t lights_size, const VkBuffer& uniform_ring, const std::vector<BufferImage>& lighting_buffer);
+	void CreateCompositeDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& lighting_buffer);
+	void CreateClusterDescriptorSet(const VkBuffer& light_buffer, size_t lights_size, const VkBuffer& uniform_ring, size_t clusters_size);
+	void CreateObjectDescriptorSet(const VkBuffer& object_buffer, size_t objects_size);
+	void CreateBindlessTextureSetLayout(uint32_t texture_count);
+	void CreateBindlessTextureDescriptorSet();
+	void CreateHiZDescriptorSets(size_t swapchain_size, const std::vector<BufferImage>& depth_buffer, const HiZPyramid& pyramid);
+	void CreateCullDescriptorSet(const VkBuffer& uniform_ring, const HiZPyramid& pyramid);
+	void UpdateCullBuffers(size_t frame, const VkBuffer& commands, const VkBuffer& cull_inputs, const VkBuffer& culled_commands, const VkBuffer& counts,
+		const VkBuffer& draw_instances, const VkBuffer& instance_counts, const VkBuffer& culled_instances);
+	void UpdateDrawInstanceBuffer(size_t frame, const VkBuffer& draw_instances);
+	void UpdateObjectBufferDescriptor(const VkBuffer& object_buffer, size_t objects_size);
+	void UpdateLightBufferDescriptors(const VkBuffer& light_buffer, size_t lights_size);
 
 	VkDescriptorSetLayout& GetViewProjectionSetLayout();
 	VkDescriptorSetLayout& GetTextureSetLayout();
 	VkDescriptorSetLayout& GetInputSetLayout();
 	VkDescriptorSetLayout& GetLightSetLayout();
 	VkDescriptorSetLayout& GetSettingsSetLayout();
+	VkDescriptorSetLayout& GetTiledLightingSetLayout();
+	VkDescriptorSetLayout& GetCompositeSetLayout();
+	VkDescriptorSetLayout& GetClusterSetLayout();
+	VkDescriptorSetLayout& GetObjectSetLayout();
+	VkDescriptorSetLayout& GetHiZSetLayout();
+	VkDescriptorSetLayout& GetCullSetLayout();
+	VkDescriptorSetLayout& GetBindlessTextureSetLayout();
 	
 	VkDescriptorPool& GetVpPool();
 	VkDescriptorPool& GetImguiDescriptorPool();
@@ -30,10 +54,17 @@ public:
 	VkDescriptorPool& GetLightPool();
 	VkDescriptorPool& GetSettingsPool();
 
-	std::vector<VkDescriptorSet>& GetDescriptorSets();
+	VkDescriptorSet& GetViewProjectionDescriptorSet();
 	std::vector<VkDescriptorSet>& GetInputDescriptorSets();
-	std::vector<VkDescriptorSet>& GetLightDescriptorSets();
-	std::vector<VkDescriptorSet>& GetSettingsDescriptorSets();
+	VkDescriptorSet& GetLightDescriptorSet();
+	VkDescriptorSet& GetSettingsDescriptorSet();
+	std::vector<VkDescriptorSet>& GetTiledLightingDescriptorSets();
+	std::vector<VkDescriptorSet>& GetCompositeDescriptorSets();
+	VkDescriptorSet& GetClusterDescriptorSet();
+	VkDescriptorSet& GetObjectDescriptorSet(size_t frame);
+	std::vector<VkDescriptorSet>& GetHiZDescriptorSets();
+	VkDescriptorSet& GetCullDescriptorSet(size_t frame);
+	VkDescriptorSet& GetBindlessTextureSet();
 
 	void DestroyTexturePool();
 	void DestroyViewProjectionPool();
@@ -41,26 +72,56 @@ public:
 	void DestroyInputPool();
 	void DestroyLightPool();
 	void DestroySettingsPool();
+	void DestroyTiledLightingPool();
+	void DestroyCompositePool();
+	void DestroyClusterPool();
+	void DestroyObjectPool();
+	void DestroyHiZPool();
+	void DestroyCullPool();
+	void DestroyBindlessTexturePool();
 
 	void DestroyTextureLayout();
 	void DestroyViewProjectionLayout();
 	void DestroyInputAttachmentsLayout();
 	void DestroyLightLayout();
 	void DestroySettingsLayout();
+	void DestroyTiledLightingLayout();
+	void DestroyCompositeLayout();
+	void DestroyClusterLayout();
+	void DestroyObjectLayout();
+	void DestroyHiZLayout();
+	void DestroyCullLayout();
+	void DestroyBindlessTextureLayout();
 	
 private:
-	void CreateViewProjectionPool(size_t swapchain_images, size_t ubo_size);
+	void CreateViewProjectionPool();
 	void CreateTexturePool();
 	void CreateImguiPool();
 	void CreateInputAttachmentsPool(size_t swapchain_images);
-	void CreateLightPool(size_t swapchain_images, size_t ubo_size);
-	void CreateSettingsPool(size_t swapchain_images, size_t ubo_size);
+	void CreateLightPool();
+	void CreateSettingsPool();
+	void CreateTiledLightingPool(size_t swapchain_images);
+	void CreateCompositePool(size_t swapchain_images);
+	void CreateClusterPool();
+	void CreateObjectPool();
+	void CreateHiZPool(size_t swapchain_images);
+	void CreateCullPool();
+	void CreateUniformPool(VkDescriptorPool& pool, VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 
 	void CreateViewProjectionSetLayout();
 	void CreateTextureSetLayout();
 	void CreateInputSetLayout();
 	void CreateLightSetLayout();
 	void CreateSettingsSetLayout();
+	void CreateTiledLightingSetLayout();
+	void CreateCompositeSetLayout();
+	void CreateClusterSetLayout();
+	void CreateObjectSetLayout();
+	void CreateHiZSetLayout();
+	void CreateCullSetLayout();
+
+	VkDescriptorSet AllocateUniformSet(const VkDescriptorPool& pool, const VkDescriptorSetLayout& layout, const VkBuffer& buffer, size_t data_size,
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 
 private:
 	VkDevice *m_Device;
@@ -71,15 +132,54 @@ private:
 	VkDescriptorPool	m_ImguiDescriptorPool;
 	VkDescriptorPool	m_LightPool;
 	VkDescriptorPool	m_SettingsPool;
+	VkDescriptorPool	m_TiledLightingPool;
+	VkDescriptorPool	m_CompositePool;
+	VkDescriptorPool	m_ClusterPool;
+	VkDescriptorPool	m_ObjectPool;
+	VkDescriptorPool	m_HiZPool;
+	VkDescriptorPool	m_CullPool;
+	VkDescriptorPool	m_BindlessTexturePool;
 
 	VkDescriptorSetLayout m_ViewProjectionLayout;
 	VkDescriptorSetLayout m_TextureLayout;
 	VkDescriptorSetLayout m_InputLayout;
 	VkDescriptorSetLayout m_LightLayout;
 	VkDescriptorSetLayout m_SettingsLayout;
+	VkDescriptorSetLayout m_TiledLightingLayout;
+	VkDescriptorSetLayout m_CompositeLayout;
+	VkDescriptorSetLayout m_ClusterLayout;
+	VkDescriptorSetLayout m_ObjectLayout;
+	VkDescriptorSetLayout m_HiZLayout;
+	VkDescriptorSetLayout m_CullLayout;
+	VkDescriptorSetLayout m_BindlessTextureLayout;
+	uint32_t			  m_BindlessTextureCount;
 
-	std::vector<VkDescriptorSet> m_DescriptorSets;
+	// View-Projection e settings sono dynamic uniform buffer, le luci un dynamic storage buffer: un set per tutti i frame
+	VkDescriptorSet				 m_ViewProjectionSet;
 	std::vector<VkDescriptorSet> m_InputDescriptorSets;
-	std::vector<VkDescriptorSet> m_LightDescriptorSets;
-	std::vector<VkDescriptorSet> m_SettingsDescriptorSets;
+	VkDescriptorSet				 m_LightSet;
+	VkDescriptorSet				 m_SettingsSet;
+
+	// Tiled lighting: lista luci e contatori (dynamic storage buffer) + immagine di output, una per immagine della swapchain
+	std::vector<VkDescriptorSet> m_TiledLightingSets;
+	std::vector<VkDescriptorSet> m_CompositeSets;
+
+	// Clustered lighting: luci (light buffer) + griglia dei cluster (uniform ring), entrambi dynamic storage buffer.
+	// I light volume usano lo stesso set, solo il binding delle luci
+	VkDescriptorSet				 m_ClusterSet;
+
+	// Model e normal matrix di ogni oggetto (dynamic storage buffer, una slice per frame) e istanze delle draw
+	// (oggetto + texture), indicizzate con gl_InstanceIndex. Un set per frame in flight: il binding delle istanze
+	// cambia con il DrawList, e un set non si riscrive mentre un frame in volo lo usa
+	std::vector<VkDescriptorSet> m_ObjectSets;
+
+	// Hi-Z: [0, immagini) depth del G-buffer -> mip 0, poi un set per ogni mip successiva (mip - 1 -> mip)
+	std::vector<VkDescriptorSet> m_HiZSets;
+
+	// Culling: comandi indirect, sfere, comandi visibili, contatori per batch, Hi-Z, CullData (uniform ring) e istanze.
+	// Un set per frame in flight, come l'object set
+	std::vector<VkDescriptorSet> m_CullSets;
+
+	// Texture bindless: un array di combined image sampler parzialmente riempito, l'elemento i e' la texture con texID i
+	VkDescriptorSet				 m_BindlessTextureSet;
 };
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "pch.h"
+
+#include "DrawList.h"
+
+#include <glm/gtc/matrix_access.hpp>
+
+DrawList::DrawList()
+{
+	m_MainDevice	= nullptr;
+	m_Buffer		= VK_NULL_HANDLE;
+	m_Memory		= {};
+	m_CullInputBuffer	= VK_NULL_HANDLE;
+	m_CullInputMemory	= {};
+	m_CulledBuffer		= VK_NULL_HANDLE;
+	m_CulledMemory		= {};
+	m_CountBuffer		= VK_NULL_HANDLE;
+	m_CountMemory		= {};
+	m_DrawInstanceBuffer	= VK_NULL_HANDLE;
+	m_DrawInstanceMemory	= {};
+	m_InstanceCountBuffer	= VK_NULL_HANDLE;
+	m_InstanceCountMemory	= {};
+	m_CulledInstanceBuffer	= VK_NULL_HANDLE;
+	m_CulledInstanceMemory	= {};
+	m_Built			= false;
+	m_SceneVersion	= 0;
+	m_OrderVersion	= 0;
+	m_BoundsVersion	= UINT64_MAX;
+}
+
+DrawList::DrawList(MainDevice* main_device) : DrawList()
+{
+	m_MainDevice = main_device;
+}
+
+void DrawList::Build(std::vector<MeshModel>& models, uint64_t scene_version, UploadBatch& upload_batch, uint64_t frame)
+{
+	// Placements of the same asset point to the same Mesh: they end up in the same batch.
+	// One instanced command per mesh covers every instance of a model. Here firstInstance is still the
+	// index of the model: it becomes the first DrawInstance once the commands are sorted
+	std::vector<Mesh*> meshes;
+	std::unordered_map<Mesh*, std::vector<VkDrawIndexedIndirectCommand>> commands_per_mesh;
+
+	for (size_t j = 0; j < models.size(); ++j)
+	{
+		for (size_t k = 0; k < models[j].GetMeshCount(); ++k)
+		{
+			Mesh* mesh = models[j].GetMesh(k);
+			auto& mesh_commands = commands_per_mesh[mesh];
+
+			if (mesh_commands.empty())
+				meshes.push_back(mesh);
+
+			VkDrawIndexedIndirectCommand command = {};
+			command.indexCount		= static_cast<uint32_t>(mesh->getIndexCount());
+			command.instanceCount	= models[j].GetInstanceCount();
+			command.firstIndex		= mesh->getFirstIndex();		// Range of the mesh in the GeometryArena
+			command.vertexOffset	= static_cast<int32_t>(mesh->getFirstVertex());
+			command.firstInstance	= static_cast<uint32_t>(j);
+
+			mesh_commands.push_back(command);
+		}
+	}
+
+	m_Batches.clear();
+	m_Commands.clear();
+	m_CullInputs.clear();
+	m_DrawInstances.clear();
+
+	for (Mesh* mesh : meshes)
+	{
+		DrawBatch batch;
+		batch.Geometry		= mesh;
+		batch.FirstCommand	= static_cast<uint32_t>(m_Commands.size());
+		batch.CommandCount	= static_cast<uint32_t>(commands_per_mesh[mesh].size());
+
+		for (VkDrawIndexedIndirectCommand command : commands_per_mesh[mesh])
+		{
+			const uint32_t first_draw_instance = static_cast<uint32_t>(m_DrawInstances.size());
+			const MeshModel& model = models[command.firstInstance];
+
+			DrawInstance draw_instance = {};
+			draw_instance.Texture			= static_cast<uint32_t>(mesh->getTexID());
+			draw_instance.Command			= static_cast<uint32_t>(m_Commands.size());
+			draw_instance.PositionOffset	= mesh->getPositionOffset();
+			draw_instance.PositionScale		= mesh->getPositionScale();
+
+			for (uint32_t i = 0; i < command.instanceCount; ++i)
+			{
+				draw_instance.Object = model.GetObjectID(i);
+				m_DrawInstances.push_back(draw_instance);
+			}
+
+			command.firstInstance = first_draw_instance;
+			m_Commands.push_back(command);
+
+			CullInput cull_input = {};
+			cull_input.BoundingSphere	= mesh->getBoundingSphere();
+			cull_input.Batch			= static_cast<uint32_t>(m_Batches.size());
+			cull_input.BatchFirst		= batch.FirstCommand;
+
+			m_CullInputs.push_back(cull_input);
+		}
+
+		m_Batches.push_back(batch);
+	}
+
+	// The frames in flight may still read the old buffers: they are destroyed by DestroyRetiredBuffers
+	if (m_Built)
+		RetireBuffers(frame);
+
+	m_Built			= true;
+	m_SceneVersion	= scene_version;
+
+	// Ordine di costruzione finche' SortBatches non ordina i nuovi batch, con i bound dei nuovi batch
+	m_BatchOrder.resize(m_Batches.size());
+	m_BoundsVersion = UINT64_MAX;
+
+	for (uint32_t b = 0; b < m_BatchOrder.size(); ++b)
+		m_BatchOrder[b] = b;
+
+	++m_OrderVersion;
+
+	if (m_Commands.empty())
+		return;
+
+	const VkDeviceSize buffer_size = m_Commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+
+	UploadBuffer(upload_batch, m_Commands.data(), buffer_size,
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &m_Buffer, &m_Memory);
+	UploadBuffer(upload_batch, m_CullInputs.data(), m_CullInputs.size() * sizeof(CullInput),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &m_CullInputBuffer, &m_CullInputMemory);
+	UploadBuffer(upload_batch, m_DrawInstances.data(), m_DrawInstances.size() * sizeof(DrawInstance),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &m_DrawInstanceBuffer, &m_DrawInstanceMemory);
+
+	// Scritti solo dalla GPU
+	BufferSettings culled_settings;
+	culled_settings.size		= buffer_size;
+	culled_settings.usage		= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	culled_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	Utility::CreateBuffer(culled_settings, &m_CulledBuffer, &m_CulledMemory);
+
+	BufferSettings count_settings;
+	count_settings.size			= m_Batches.size() * sizeof(uint32_t);
+	count_settings.usage		= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	count_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	Utility::CreateBuffer(count_settings, &m_CountBuffer, &m_CountMemory);
+
+	count_settings.size			= m_Commands.size() * sizeof(uint32_t);
+	count_settings.usage		= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	Utility::CreateBuffer(count_settings, &m_InstanceCountBuffer, &m_InstanceCountMemory);
+
+	culled_settings.size		= m_DrawInstances.size() * sizeof(DrawInstance);
+	culled_settings.usage		= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	Utility::CreateBuffer(culled_settings, &m_CulledInstanceBuffer, &m_CulledInstanceMemory);
+}
+
+bool DrawList::SortBatches(const glm::mat4& view, float near_plane, float far_plane, const ObjectBuffer& objects)
+{
+	// Le istanze si spostano di rado, la camera ogni frame: per frame resta una trasformazione per batch
+	if (m_BoundsVersion != objects.GetVersion())
+	{
+		UpdateBatchBounds(objects);
+		m_BoundsVersion = objects.GetVersion();
+	}
+
+	m_SortEntries.resize(m_Batches.size());
+
+	for (uint32_t b = 0; b < m_Batches.size(); ++b)
+	{
+		const DrawBatch& batch	= m_Batches[b];
+		const glm::vec4& bound	= m_BatchBounds[b];
+
+		// Profondita' (lungo la direzione di vista) del punto piu' vicino del bound del batch
+		const float nearest = -(view * glm::vec4(glm::vec3(bound), 1.0f)).z - bound.w;
+
+		// Bindless: il cambio di texture non costa nulla, conta solo la profondita'
+		const uint32_t texture = m_MainDevice->BindlessTextures ? 0 : static_cast<uint32_t>(batch.Geometry->getTexID());
+
+		m_SortEntries[b].Key	= MakeSortKey(0, texture, QuantizeDepth(nearest, near_plane, far_plane));		// Il G-buffer ha una sola pipeline
+		m_SortEntries[b].Batch	= b;
+	}
+
+	RadixSort(m_SortEntries, m_SortScratch);
+
+	bool changed = false;
+
+	for (uint32_t i = 0; i < m_SortEntries.size(); ++i)
+	{
+		if (m_BatchOrder[i] != m_SortEntries[i].Batch)
+		{
+			m_BatchOrder[i] = m_SortEntries[i].Batch;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		++m_OrderVersion;
+
+	return changed;
+}
+
+// Sfera attorno alle sfere in world space di tutte le istanze: centro nel mezzo del loro AABB
+void DrawList::UpdateBatchBounds(const ObjectBuffer& objects)
+{
+	m_BatchBounds.resize(m_Batches.size());
+
+	for (uint32_t b = 0; b < m_Batches.size(); ++b)
+	{
+		const DrawBatch& batch	= m_Batches[b];
+		const glm::vec4 sphere	= batch.Geometry->getBoundingSphere();
+
+		glm::vec3 bounds_min(std::numeric_limits<float>::max());
+		glm::vec3 bounds_max(-std::numeric_limits<float>::max());
+
+		m_InstanceBounds.clear();
+
+		for (uint32_t c = batch.FirstCommand; c < batch.FirstCommand + batch.CommandCount; ++c)
+		{
+			for (uint32_t i = 0; i < m_Commands[c].instanceCount; ++i)
+			{
+				const glm::mat4& model	= objects.Get(m_DrawInstances[m_Commands[c].firstInstance + i].Object).Model;
+				const float scale		= std::max(glm::length(glm::vec3(model[0])),
+					std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+				const glm::vec3 center	= glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+
+				m_InstanceBounds.push_back(glm::vec4(center, sphere.w * scale));
+
+				bounds_min = glm::min(bounds_min, center);
+				bounds_max = glm::max(bounds_max, center);
+			}
+		}
+
+		// Un modello senza istanze: il batch non disegna nulla, la sua posizione nella coda non conta
+		if (m_InstanceBounds.empty())
+		{
+			m_BatchBounds[b] = glm::vec4(0.0f);
+			continue;
+		}
+
+		const glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+		float radius = 0.0f;
+
+		for (const glm::vec4& instance : m_InstanceBounds)
+			radius = std::max(radius, glm::length(glm::vec3(instance) - center) + instance.w);
+
+		m_BatchBounds[b] = glm::vec4(center, radius);
+	}
+}
+
+uint64_t DrawList::MakeSortKey(uint32_t pipeline, uint32_t texture, uint32_t depth_bucket)
+{
+	return (static_cast<uint64_t>(pipeline) << SORT_KEY_PIPELINE_SHIFT) |
+		((static_cast<uint64_t>(texture) & SORT_KEY_TEXTURE_MASK) << SORT_KEY_TEXTURE_SHIFT) |
+		static_cast<uint64_t>(depth_bucket);
+}
+
+// Bucket logaritmici tra near e far plane, come la precisione del depth buffer: ogni bucket copre la stessa frazione
+// della distanza. La geometria che interseca la near plane (o dietro la camera) finisce in testa con il bucket 0
+uint32_t DrawList::QuantizeDepth(float view_depth, float near_plane, float far_plane)
+{
+	constexpr uint32_t max_bucket = (1u << SORT_KEY_DEPTH_BITS) - 1;
+
+	if (view_depth <= near_plane)
+		return 0;
+
+	const float t = std::log(view_depth / near_plane) / std::log(far_plane / near_plane);
+
+	return static_cast<uint32_t>(std::min(t, 1.0f) * static_cast<float>(max_bucket));
+}
+
+// LSD radix sort a byte per passata, stabile: a parita' di chiave i batch restano nell'ordine di costruzione.
+// Le passate in cui tutte le chiavi hanno lo stesso byte (pipeline, texture con bindless) vengono saltate
+void DrawList::RadixSort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch)
+{
+	if (entries.empty())
+		return;
+
+	scratch.resize(entries.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::array<uint32_t, 256> offsets = {};
+
+		for (const DrawSortEntry& entry : entries)
+			++offsets[(entry.Key >> shift) & 0xFF];
+
+		if (offsets[(entries[0].Key >> shift) & 0xFF] == entries.size())
+			continue;
+
+		uint32_t offset = 0;
+
+		for (uint32_t& bucket : offsets)
+		{
+			const uint32_t count = bucket;
+			bucket = offset;
+			offset += count;
+		}
+
+		for (const DrawSortEntry& entry : entries)
+			scratch[offsets[(entry.Key >> shift) & 0xFF]++] = entry;
+
+		entries.swap(scratch);
+	}
+}
+
+void DrawList::UploadBuffer(UploadBatch& upload_batch, const void* data, VkDeviceSize buffer_size, VkBufferUsageFlags usage, VkBuffer* buffer, Allocation* memory)
+{
+	BufferSettings buffer_settings;
+	buffer_settings.size		= buffer_size;
+	buffer_settings.usage		= usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	buffer_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	Utility::CreateBuffer(buffer_settings, buffer, memory);
+
+	// Letti dalle draw indirect, dal vertex shader e dal culling: il submit del batch precede quello del frame
+	upload_batch.CopyToBuffer(data, buffer_size, *buffer, 0,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+}
+
+void DrawList::RetireBuffers(uint64_t frame)
+{
+	if (m_Buffer == VK_NULL_HANDLE)
+		return;
+
+	m_RetiredBuffers.push_back({ m_Buffer, m_Memory, frame });
+	m_RetiredBuffers.push_back({ m_CullInputBuffer, m_CullInputMemory, frame });
+	m_RetiredBuffers.push_back({ m_CulledBuffer, m_CulledMemory, frame });
+	m_RetiredBuffers.push_back({ m_CountBuffer, m_CountMemory, frame });
+	m_RetiredBuffers.push_back({ m_DrawInstanceBuffer, m_DrawInstanceMemory, frame });
+	m_RetiredBuffers.push_back({ m_InstanceCountBuffer, m_InstanceCountMemory, frame });
+	m_RetiredBuffers.push_back({ m_CulledInstanceBuffer, m_CulledInstanceMemory, frame });
+
+	m_Buffer			= VK_NULL_HANDLE;
+	m_CullInputBuffer	= VK_NULL_HANDLE;
+	m_CulledBuffer		= VK_NULL_HANDLE;
+	m_CountBuffer		= VK_NULL_HANDLE;
+	m_DrawInstanceBuffer	= VK_NULL_HANDLE;
+	m_InstanceCountBuffer	= VK_NULL_HANDLE;
+	m_CulledInstanceBuffer	= VK_NULL_HANDLE;
+}
+
+// Chiamata dopo l'attesa della fence del frame: i frame fino a 'frame - MAX_FRAMES_IN_FLIGHT' sono terminati,
+// e con loro ogni submit che poteva leggere un buffer sostituito in quel frame o prima
+void DrawList::DestroyRetiredBuffers(uint64_t frame)
+{
+	auto retired = std::remove_if(m_RetiredBuffers.begin(), m_RetiredBuffers.end(), [frame](RetiredBuffer& retired_buffer) {
+		if (retired_buffer.Frame + MAX_FRAMES_IN_FLIGHT > frame)
+			return false;
+
+		Utility::DestroyBuffer(retired_buffer.Buffer, retired_buffer.Memory);
+		return true;
+	});
+
+	m_RetiredBuffers.erase(retired, m_RetiredBuffers.end());
+}
+
+// Piani di Gribb-Hartmann della View-Projection (depth 0..1), normalizzati: il test della sfera usa distanze vere
+void DrawList::FillCullData(CullData& cull_data, const glm::mat4& view_proj, const glm::mat4& prev_view_proj, const VkExtent2D& hiz_size, bool hiz_valid) const
+{
+	const glm::vec4 row_x = glm::row(view_proj, 0);
+	const glm::vec4 row_y = glm::row(view_proj, 1);
+	const glm::vec4 row_z = glm::row(view_proj, 2);
+	const glm::vec4 row_w = glm::row(view_proj, 3);
+
+	cull_data.frustum_planes[0] = row_w + row_x;	// Left
+	cull_data.frustum_planes[1] = row_w - row_x;	// Right
+	cull_data.frustum_planes[2] = row_w + row_y;	// Bottom
+	cull_data.frustum_planes[3] = row_w - row_y;	// Top
+	cull_data.frustum_planes[4] = row_z;			// Near
+	cull_data.frustum_planes[5] = row_w - row_z;	// Far
+
+	for (auto& plane : cull_data.frustum_planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	cull_data.prev_view_proj	= prev_view_proj;
+	cull_data.hiz_size			= glm::vec2(static_cast<float>(hiz_size.width), static_cast<float>(hiz_size.height));
+	cull_data.command_count		= static_cast<uint32_t>(m_Commands.size());
+	cull_data.instance_count	= static_cast<uint32_t>(m_DrawInstances.size());
+	cull_data.flags				= 0;
+
+	if (hiz_valid)
+		cull_data.flags |= CULL_OCCLUSION;
+
+	if (m_MainDevice->DrawIndexedIndirectCount)
+		cull_data.flags |= CULL_COMPACT;
+}
+
+void DrawList::DestroyBuffer()
+{
+	// Cleanup, a device idle: anche i buffer ritirati non sono piu' in uso
+	for (auto& retired_buffer : m_RetiredBuffers)
+		Utility::DestroyBuffer(retired_buffer.Buffer, retired_buffer.Memory);
+
+	m_RetiredBuffers.clear();
+
+	if (m_Buffer == VK_NULL_HANDLE)
+		return;
+
+	Utility::DestroyBuffer(m_Buffer, m_Memory);
+	Utility::DestroyBuffer(m_CullInputBuffer, m_CullInputMemory);
+	Utility::DestroyBuffer(m_CulledBuffer, m_CulledMemory);
+	Utility::DestroyBuffer(m_CountBuffer, m_CountMemory);
+	Utility::DestroyBuffer(m_DrawInstanceBuffer, m_DrawInstanceMemory);
+	Utility::DestroyBuffer(m_InstanceCountBuffer, m_InstanceCountMemory);
+	Utility::DestroyBuffer(m_CulledInstanceBuffer, m_CulledInstanceMemory);
+
+	m_Buffer			= VK_NULL_HANDLE;
+	m_CullInputBuffer	= VK_NULL_HANDLE;
+	m_CulledBuffer		= VK_NULL_HANDLE;
+	m_CountBuffer		= VK_NULL_HANDLE;
+	m_DrawInstanceBuffer	= VK_NULL_HANDLE;
+	m_InstanceCountBuffer	= VK_NULL_HANDLE;
+	m_CulledInstanceBuffer	= VK_NULL_HANDLE;
+}
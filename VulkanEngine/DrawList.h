@@ -0,0 +1,167 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Mesh.h"
+#include "MeshModel.h"
+#include "ObjectBuffer.h"
+#include "UploadBatch.h"
+
+// Consecutive indirect commands that share vertex buffer, index buffer and texture:
+// every model placing the same Mesh, issued by a single vkCmdDrawIndexedIndirect
+struct DrawBatch {
+	Mesh*		Geometry;
+	uint32_t	FirstCommand;
+	uint32_t	CommandCount;
+};
+
+// CullData::flags
+constexpr uint32_t CULL_OCCLUSION	= 1;	// The Hi-Z pyramid holds the depth of a previous frame
+constexpr uint32_t CULL_COMPACT		= 2;	// Visible commands are packed per batch, the draw count is read from the count buffer
+
+// Per-frame constants of the culling compute shader, pushed in the uniform ring (std140)
+struct CullData {
+	glm::mat4	prev_view_proj;		// View-projection used to render the depth the Hi-Z was built from
+	glm::vec4	frustum_planes[6];	// Current view-projection, normalised, inside when dot(n, p) + d >= 0
+	glm::vec2	hiz_size;			// Size of mip 0 of the Hi-Z pyramid
+	uint32_t	command_count;
+	uint32_t	flags;
+	uint32_t	instance_count;
+};
+
+// One element per instance of every indirect command, read through gl_InstanceIndex (firstInstance + i) by the
+// vertex shader and one per thread by the culling shader (std430)
+struct DrawInstance {
+	uint32_t	Object;				// Object ID: model and normal matrix in the object buffer
+	uint32_t	Texture;			// Element of the bindless texture array (texID of the mesh)
+	uint32_t	Command;			// Indirect command of the instance: its bounding sphere and visible instance counter
+	uint32_t	Padding;
+	glm::vec4	PositionOffset;		// Dequantization of the packed positions (VertexFormat::Packed), AABB of the mesh
+	glm::vec4	PositionScale;
+};
+
+// One element per indirect command, read by the culling shader (std430)
+struct CullInput {
+	glm::vec4	BoundingSphere;		// Object space, the model matrices come from the object buffer through the draw instances
+	uint32_t	Batch;
+	uint32_t	BatchFirst;			// FirstCommand of the batch: the compacted commands are written from here
+	uint32_t	Padding[2];
+};
+
+static_assert(sizeof(CullData) == 180, "CullData must match the std140 block of cull.comp");
+static_assert(sizeof(CullInput) == 32, "CullInput must match the std430 struct of cull.comp");
+static_assert(sizeof(DrawInstance) == 48, "DrawInstance must match the std430 struct of shader.vert and cull.comp");
+
+// Render queue order of the batches, lowest key first:
+// [63..56] pipeline | [55..32] texture (0 with bindless textures) | [11..0] log view depth of the nearest point of the batch bound
+constexpr uint32_t SORT_KEY_PIPELINE_SHIFT	= 56;
+constexpr uint32_t SORT_KEY_TEXTURE_SHIFT	= 32;
+constexpr uint64_t SORT_KEY_TEXTURE_MASK	= 0xFFFFFF;
+constexpr uint32_t SORT_KEY_DEPTH_BITS		= 12;
+
+struct DrawSortEntry {
+	uint64_t	Key;
+	uint32_t	Batch;
+};
+
+// Draw commands of the G-buffer pass, built once per scene into a device local INDIRECT_BUFFER.
+// One instanced VkDrawIndexedIndirectCommand per (model, mesh): instanceCount is the number of
+// instances of the model and firstInstance the first of its DrawInstance records, so the vertex
+// shader reads object and texture index of each instance with gl_InstanceIndex. Every frame the batches
+// are radix sorted by pipeline, texture and front-to-back depth: consecutive batches share their texture set
+// (nothing to bind with bindless textures) and the nearest geometry fills the depth buffer first. The depth comes
+// from one world space sphere per batch, rebuilt only when an object moves, and is quantized into log buckets
+// so that small camera motions do not reorder batches that are almost at the same distance.
+// The recorded command buffers follow the order, they change only when the order does (GetOrderVersion).
+// The CPU copy of the commands is kept for the direct draw fallback (no multiDrawIndirect / drawIndirectFirstInstance).
+// A rebuild records its copies into the caller's UploadBatch and never waits on the GPU: the buffers it replaces
+// stay alive until the frames in flight that may still read them have signaled their fence.
+// With GPU culling the commands are only read by the culling shader: a first pass tests every instance
+// and packs the visible ones at the start of the range of their command (culled instance buffer, read by
+// the vertex shader in place of the draw instances), a second pass writes the commands with their visible
+// instance count in the culled buffer (and their number per batch in the count buffer) for the G-buffer pass.
+class DrawList
+{
+public:
+	DrawList();
+	DrawList(MainDevice* main_device);
+
+	void Build(std::vector<MeshModel>& models, uint64_t scene_version, UploadBatch& upload_batch, uint64_t frame);
+	void DestroyRetiredBuffers(uint64_t frame);	// Buffers replaced at least MAX_FRAMES_IN_FLIGHT frames before 'frame'
+	bool SortBatches(const glm::mat4& view, float near_plane, float far_plane, const ObjectBuffer& objects);	// True if the order of the batches changed
+	void FillCullData(CullData& cull_data, const glm::mat4& view_proj, const glm::mat4& prev_view_proj, const VkExtent2D& hiz_size, bool hiz_valid) const;
+	void DestroyBuffer();
+
+	bool IsUpToDate(uint64_t scene_version) const		{ return m_Built && m_SceneVersion == scene_version; }
+	uint64_t GetSceneVersion() const					{ return m_SceneVersion; }
+	// Il culling scrive comandi con firstInstance != 0: serve drawIndirectFirstInstance
+	bool IsCullingEnabled() const						{ return m_Buffer != VK_NULL_HANDLE && m_MainDevice->DrawIndirectFirstInstance; }
+
+	const std::vector<DrawBatch>& GetBatches() const						{ return m_Batches; }
+	const std::vector<uint32_t>& GetBatchOrder() const						{ return m_BatchOrder; }
+	uint64_t GetOrderVersion() const										{ return m_OrderVersion; }
+	const std::vector<VkDrawIndexedIndirectCommand>& GetCommands() const	{ return m_Commands; }
+	VkBuffer GetBuffer() const												{ return m_Buffer; }
+	VkBuffer GetCullInputBuffer() const										{ return m_CullInputBuffer; }
+	VkBuffer GetCulledBuffer() const										{ return m_CulledBuffer; }
+	VkBuffer GetCountBuffer() const											{ return m_CountBuffer; }
+	VkBuffer GetDrawInstanceBuffer() const									{ return m_DrawInstanceBuffer; }
+	VkBuffer GetInstanceCountBuffer() const									{ return m_InstanceCountBuffer; }
+	VkBuffer GetCulledInstanceBuffer() const								{ return m_CulledInstanceBuffer; }
+	// Istanze lette dal vertex shader del G-buffer: quelle compattate dal culling, se c'e'
+	VkBuffer GetVisibleInstanceBuffer() const								{ return IsCullingEnabled() ? m_CulledInstanceBuffer : m_DrawInstanceBuffer; }
+	uint32_t GetCommandCount() const										{ return static_cast<uint32_t>(m_Commands.size()); }
+	uint32_t GetInstanceCount() const										{ return static_cast<uint32_t>(m_DrawInstances.size()); }
+
+private:
+	// Buffer di una build precedente, ancora letto dai frame in flight che l'hanno registrato
+	struct RetiredBuffer {
+		VkBuffer	Buffer;
+		Allocation	Memory;
+		uint64_t	Frame;		// Frame in cui e' stato sostituito
+	};
+
+	MainDevice		*m_MainDevice;
+
+	VkBuffer		m_Buffer;
+	Allocation		m_Memory;
+	VkBuffer		m_CullInputBuffer;
+	Allocation		m_CullInputMemory;
+	VkBuffer		m_CulledBuffer;
+	Allocation		m_CulledMemory;
+	VkBuffer		m_CountBuffer;		// Un uint per batch, azzerato prima di ogni dispatch del culling
+	Allocation		m_CountMemory;
+	VkBuffer		m_DrawInstanceBuffer;
+	Allocation		m_DrawInstanceMemory;
+	VkBuffer		m_InstanceCountBuffer;	// Un uint per comando, azzerato prima di ogni dispatch del culling
+	Allocation		m_InstanceCountMemory;
+	VkBuffer		m_CulledInstanceBuffer;
+	Allocation		m_CulledInstanceMemory;
+
+	bool			m_Built;
+	uint64_t		m_SceneVersion;
+	uint64_t		m_OrderVersion;		// Cambia ogni volta che cambia m_BatchOrder
+
+	std::vector<DrawBatch>						m_Batches;
+	std::vector<VkDrawIndexedIndirectCommand>	m_Commands;
+	std::vector<CullInput>						m_CullInputs;
+	std::vector<DrawInstance>					m_DrawInstances;
+
+	std::vector<uint32_t>						m_BatchOrder;		// Indici dei batch nell'ordine di registrazione
+	std::vector<glm::vec4>						m_BatchBounds;		// Sfera in world space attorno a tutte le istanze del batch
+	std::vector<glm::vec4>						m_InstanceBounds;	// Scratch di UpdateBatchBounds
+	uint64_t									m_BoundsVersion;	// ObjectBuffer::GetVersion di m_BatchBounds, UINT64_MAX dopo una build
+	std::vector<DrawSortEntry>					m_SortEntries;
+	std::vector<DrawSortEntry>					m_SortScratch;
+
+	std::vector<RetiredBuffer>					m_RetiredBuffers;
+
+private:
+	static uint64_t MakeSortKey(uint32_t pipeline, uint32_t texture, uint32_t depth_bucket);
+	static uint32_t QuantizeDepth(float view_depth, float near_plane, float far_plane);
+	static void RadixSort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch);
+
+	void UploadBuffer(UploadBatch& upload_batch, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer* buffer, Allocation* memory);
+	void RetireBuffers(uint64_t frame);
+	void UpdateBatchBounds(const ObjectBuffer& objects);
+};
@@ -0,0 +1,132 @@
+#include "pch.h"
+
+#include "FrameSlicedBuffer.h"
+
+FrameSlicedBuffer::FrameSlicedBuffer()
+{
+	m_MainDevice		= nullptr;
+	m_HeaderSize		= 0;
+	m_ElementSize		= 0;
+	m_Buffer			= VK_NULL_HANDLE;
+	m_Memory			= {};
+	m_Capacity			= 0;
+	m_SliceSize			= 0;
+	m_SliceBegin		= 0;
+	m_Slot				= 0;
+	m_LastUploadSize	= 0;
+}
+
+FrameSlicedBuffer::FrameSlicedBuffer(MainDevice* main_device, VkDeviceSize header_size, VkDeviceSize element_size, const std::string& name) : FrameSlicedBuffer()
+{
+	m_MainDevice	= main_device;
+	m_HeaderSize	= header_size;
+	m_ElementSize	= element_size;
+	m_Name			= name;
+}
+
+void FrameSlicedBuffer::CreateBuffer(uint32_t capacity)
+{
+	Grow(capacity);
+}
+
+void FrameSlicedBuffer::Grow(uint32_t capacity)
+{
+	m_Capacity = capacity;
+
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(m_MainDevice->MinStorageBufferOffset, 1);
+	const VkDeviceSize data_size = m_HeaderSize + static_cast<VkDeviceSize>(m_Capacity) * m_ElementSize;
+
+	m_SliceSize = (data_size + alignment - 1) & ~(alignment - 1);
+
+	BufferSettings buffer_settings;
+	buffer_settings.size		= m_SliceSize * MAX_FRAMES_IN_FLIGHT;
+	buffer_settings.usage		= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	buffer_settings.properties	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	Utility::CreateBuffer(buffer_settings, &m_Buffer, &m_Memory);
+
+	if (!m_Memory.Mapped)
+		throw std::runtime_error("The " + m_Name + " buffer is not host visible!");
+
+	// A new buffer has no valid slice
+	MarkAllDirty();
+}
+
+bool FrameSlicedBuffer::BeginFrame(uint32_t frame, uint32_t count)
+{
+	bool recreated = false;
+
+	// Every slice of the buffer may be in use by the frames in flight: growing needs an idle device,
+	// it happens only when the element count goes past a power of two of the initial capacity
+	if (count > m_Capacity)
+	{
+		vkDeviceWaitIdle(m_MainDevice->LogicalDevice);
+
+		Utility::DestroyBuffer(m_Buffer, m_Memory);
+
+		uint32_t capacity = std::max(m_Capacity, 1u);
+		while (capacity < count)
+			capacity *= 2;
+
+		Grow(capacity);
+		recreated = true;
+	}
+
+	m_Slot				= frame % MAX_FRAMES_IN_FLIGHT;
+	m_SliceBegin		= m_SliceSize * m_Slot;
+	m_LastUploadSize	= 0;
+
+	return recreated;
+}
+
+void FrameSlicedBuffer::WriteHeader(const void* header)
+{
+	memcpy(static_cast<char*>(m_Memory.Mapped) + m_SliceBegin, header, static_cast<size_t>(m_HeaderSize));
+
+	m_LastUploadSize += m_HeaderSize;
+}
+
+void FrameSlicedBuffer::UploadDirty(const void* elements, uint32_t count)
+{
+	DirtyRange& dirty	= m_DirtyRanges[m_Slot];
+	const uint32_t end	= std::min(dirty.end, count);
+
+	if (dirty.begin < end)
+	{
+		const size_t offset = static_cast<size_t>(dirty.begin) * static_cast<size_t>(m_ElementSize);
+		const size_t size	= static_cast<size_t>(end - dirty.begin) * static_cast<size_t>(m_ElementSize);
+
+		memcpy(static_cast<char*>(m_Memory.Mapped) + m_SliceBegin + m_HeaderSize + offset, static_cast<const char*>(elements) + offset, size);
+		m_LastUploadSize += size;
+	}
+
+	dirty = DirtyRange();
+}
+
+void FrameSlicedBuffer::DestroyBuffer()
+{
+	if (m_Buffer == VK_NULL_HANDLE)
+		return;
+
+	Utility::DestroyBuffer(m_Buffer, m_Memory);
+	m_Buffer = VK_NULL_HANDLE;
+}
+
+// A single range per slice: scattered updates copy the elements in between too, still one memcpy
+void FrameSlicedBuffer::MarkDirty(uint32_t index)
+{
+	for (auto& dirty : m_DirtyRanges)
+	{
+		dirty.begin = std::min(dirty.begin, index);
+		dirty.end	= std::max(dirty.end, index + 1);
+	}
+}
+
+void FrameSlicedBuffer::MarkAllDirty()
+{
+	for (auto& dirty : m_DirtyRanges)
+	{
+		dirty.begin = 0;
+		dirty.end	= m_Capacity;
+	}
+}
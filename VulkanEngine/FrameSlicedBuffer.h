@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utilities.h"
+
+// Host visible storage buffer with one slice per frame in flight, bound with a dynamic offset like the uniform ring.
+// Each slice holds an optional header followed by an array of elements, the elements stay on the CPU with their owner
+// (LightManager, ObjectBuffer). A slice is written only after the fence of its frame, and only the elements changed
+// since the last time that slice was written are copied. When the elements no longer fit, the buffer grows.
+class FrameSlicedBuffer
+{
+public:
+	FrameSlicedBuffer();
+	FrameSlicedBuffer(MainDevice* main_device, VkDeviceSize header_size, VkDeviceSize element_size, const std::string& name);
+
+	void CreateBuffer(uint32_t capacity);
+	bool BeginFrame(uint32_t frame, uint32_t count);			// Selects the slice of the frame, true if the buffer was recreated
+	void WriteHeader(const void* header);
+	void UploadDirty(const void* elements, uint32_t count);		// Copies the dirty elements of the frame slice
+	void DestroyBuffer();
+
+	void MarkDirty(uint32_t index);
+
+	VkBuffer& GetBuffer()							{ return m_Buffer; }
+	VkDeviceSize GetSliceSize() const				{ return m_SliceSize; }		// Range of the descriptors
+	uint32_t GetFrameOffset() const					{ return static_cast<uint32_t>(m_SliceBegin); }
+	VkDeviceSize GetLastUploadSize() const			{ return m_LastUploadSize; }
+
+private:
+	struct DirtyRange {
+		uint32_t begin	= UINT32_MAX;
+		uint32_t end	= 0;
+	};
+
+	void MarkAllDirty();
+	void Grow(uint32_t capacity);
+
+private:
+	MainDevice		*m_MainDevice;
+	std::string		m_Name;
+
+	VkDeviceSize	m_HeaderSize;
+	VkDeviceSize	m_ElementSize;
+
+	VkBuffer		m_Buffer;
+	Allocation		m_Memory;
+	uint32_t		m_Capacity;			// Elements per slice
+	VkDeviceSize	m_SliceSize;
+	VkDeviceSize	m_SliceBegin;
+	uint32_t		m_Slot;
+	VkDeviceSize	m_LastUploadSize;
+
+	std::array<DirtyRange, MAX_FRAMES_IN_FLIGHT> m_DirtyRanges;	// Elements not yet copied in each slice
+};
@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include "GPUProfiler.h"
+
+GPUProfiler::GPUProfiler()
+{
+	m_MainDevice		= nullptr;
+	m_QueryPool			= VK_NULL_HANDLE;
+	m_TimestampPeriod	= 1.0f;
+	m_TimestampMask		= ~0ULL;
+	m_CurrentFrame		= 0;
+	m_FrameNumbers		= {};
+	m_Recorded			= {};
+}
+
+GPUProfiler::GPUProfiler(MainDevice* main_device) : GPUProfiler()
+{
+	m_MainDevice = main_device;
+}
+
+void GPUProfiler::CreateQueryPool(uint32_t queue_family)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_MainDevice->PhysicalDevice, &properties);
+
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_MainDevice->PhysicalDevice, &queue_family_count, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_MainDevice->PhysicalDevice, &queue_family_count, queue_families.data());
+
+	const uint32_t valid_bits = queue_families[queue_family].timestampValidBits;
+
+	// La queue non supporta i timestamp: il profiler resta disabilitato
+	if (valid_bits == 0)
+		return;
+
+	m_TimestampPeriod	= properties.limits.timestampPeriod;
+	m_TimestampMask		= valid_bits >= 64 ? ~0ULL : ((1ULL << valid_bits) - 1);
+
+	VkQueryPoolCreateInfo query_pool_info = {};
+	query_pool_info.sType		= VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_info.queryType	= VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_info.queryCount	= QUERY_COUNT * MAX_FRAMES_IN_FLIGHT;
+
+	VkResult result = vkCreateQueryPool(m_MainDevice->LogicalDevice, &query_pool_info, nullptr, &m_QueryPool);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the timestamp Query Pool!");
+}
+
+void GPUProfiler::BeginFrame(uint32_t frame, uint64_t frame_number)
+{
+	if (!IsSupported())
+		return;
+
+	// Called after the frame fence has been waited: whatever this slot recorded
+	// MAX_FRAMES_IN_FLIGHT frames ago is complete and can be read without stalling.
+	if (m_Recorded[frame])
+		ReadResults(frame);
+
+	m_CurrentFrame			= frame;
+	m_FrameNumbers[frame]	= frame_number;
+	m_Recorded[frame]		= false;
+}
+
+void GPUProfiler::ResetQueries(const VkCommandBuffer& command_buffer)
+{
+	if (!IsSupported())
+		return;
+
+	vkCmdResetQueryPool(command_buffer, m_QueryPool, m_CurrentFrame * QUERY_COUNT, QUERY_COUNT);
+	m_Recorded[m_CurrentFrame] = true;
+}
+
+void GPUProfiler::MarkRecorded()
+{
+	if (!IsSupported())
+		return;
+
+	m_Recorded[m_CurrentFrame] = true;
+}
+
+void GPUProfiler::WriteTimestamp(const VkCommandBuffer& command_buffer, GPUQuery query, VkPipelineStageFlagBits stage)
+{
+	if (!IsSupported())
+		return;
+
+	vkCmdWriteTimestamp(command_buffer, stage, m_QueryPool, m_CurrentFrame * QUERY_COUNT + query);
+}
+
+void GPUProfiler::ReadResults(uint32_t frame)
+{
+	std::array<uint64_t, QUERY_COUNT> timestamps = {};
+
+	// No WAIT bit: if the results are not there yet the previous values are kept
+	VkResult result = vkGetQueryPoolResults(m_MainDevice->LogicalDevice, m_QueryPool,
+		frame * QUERY_COUNT, QUERY_COUNT,
+		sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+		return;
+
+	m_Timings.frame_number	= m_FrameNumbers[frame];
+	m_Timings.frame_ms		= ElapsedMs(timestamps, QUERY_FRAME_BEGIN, QUERY_FRAME_END);
+	m_Timings.gbuffer_ms	= ElapsedMs(timestamps, QUERY_GBUFFER_BEGIN, QUERY_GBUFFER_END);
+	m_Timings.lighting_ms	= ElapsedMs(timestamps, QUERY_LIGHTING_BEGIN, QUERY_LIGHTING_END);
+	m_Timings.imgui_ms		= ElapsedMs(timestamps, QUERY_IMGUI_BEGIN, QUERY_IMGUI_END);
+	m_Timings.valid			= true;
+}
+
+float GPUProfiler::ElapsedMs(const std::array<uint64_t, QUERY_COUNT>& timestamps, GPUQuery begin, GPUQuery end) const
+{
+	const uint64_t ticks = (timestamps[end] - timestamps[begin]) & m_TimestampMask;
+
+	return static_cast<float>(static_cast<double>(ticks) * m_TimestampPeriod / 1000000.0);
+}
+
+void GPUProfiler::DestroyQueryPool()
+{
+	if (IsSupported())
+		vkDestroyQueryPool(m_MainDevice->LogicalDevice, m_QueryPool, nullptr);
+
+	m_QueryPool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utilities.h"
+
+// Timestamps written in every frame, each frame in flight owns a slice of the query pool
+enum GPUQuery : uint32_t {
+	QUERY_FRAME_BEGIN = 0,
+	QUERY_GBUFFER_BEGIN,
+	QUERY_GBUFFER_END,
+	QUERY_LIGHTING_BEGIN,
+	QUERY_LIGHTING_END,
+	QUERY_IMGUI_BEGIN,
+	QUERY_IMGUI_END,
+	QUERY_FRAME_END,
+	QUERY_COUNT
+};
+
+struct GPUTimings {
+	uint64_t	frame_number = 0;		// Frame the timings belong to (they are read back a few frames late)
+	float		frame_ms	 = 0.0f;
+	float		gbuffer_ms	 = 0.0f;		// Offscreen render pass (geometry into the G-buffer)
+	float		lighting_ms	 = 0.0f;		// Deferred lighting: fullscreen draw, or tiled dispatch + composite
+	float		imgui_ms	 = 0.0f;		// GUI draw data, zero when there is no GUI
+	bool		valid		 = false;
+};
+
+class GPUProfiler
+{
+public:
+	GPUProfiler();
+	GPUProfiler(MainDevice* main_device);
+
+	void CreateQueryPool(uint32_t queue_family);
+	void BeginFrame(uint32_t frame, uint64_t frame_number);
+	void ResetQueries(const VkCommandBuffer& command_buffer);
+	void MarkRecorded();	// The queries of the frame come from a command buffer submitted again without recording
+	void WriteTimestamp(const VkCommandBuffer& command_buffer, GPUQuery query, VkPipelineStageFlagBits stage);
+	void DestroyQueryPool();
+
+	bool IsSupported() const				{ return m_QueryPool != VK_NULL_HANDLE; }
+	const GPUTimings& GetTimings() const	{ return m_Timings; }
+
+private:
+	MainDevice	*m_MainDevice;
+	VkQueryPool	m_QueryPool;
+
+	float		m_TimestampPeriod;		// Nanoseconds per tick
+	uint64_t	m_TimestampMask;		// Only the valid bits of the queue family are meaningful
+
+	uint32_t	m_CurrentFrame;
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT>	m_FrameNumbers;
+	std::array<bool, MAX_FRAMES_IN_FLIGHT>		m_Recorded;
+
+	GPUTimings	m_Timings;
+
+	void ReadResults(uint32_t frame);
+	float ElapsedMs(const std::array<uint64_t, QUERY_COUNT>& timestamps, GPUQuery begin, GPUQuery end) const;
+};
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "GUI.h"
+#include "ComputePipeline.h"
 
 GUI* GUI::s_Instance = nullptr;
 
@@ -58,7 +59,7 @@ void GUI::Render()
 	ImGui::NewFrame();
 
 	ImGuiWindowFlags window_flags{ ImGuiWindowFlags_NoResize };
-	ImGui::SetNextWindowSize(ImVec2(350.f, 480.f), 0);
+	ImGui::SetNextWindowSize(ImVec2(350.f, 605.f), 0);
 	ImGui::SetNextWindowPos(ImVec2(50.f, 50.f), ImGuiCond_FirstUseEver);
 	
 	ImGui::Begin("Settings", NULL, window_flags);
@@ -80,6 +81,10 @@ void GUI::Render()
 		break;
 	}
 
+	// Fullscreen: ogni pixel itera su tutte le luci, Tiled: compute shader con culling per tile,
+	// Clustered: ogni pixel legge solo le luci del proprio froxel (assegnate sulla CPU), Light volumes: una sfera per luce
+	ImGui::Combo("Lighting", &m_SettingsData->lighting_mode, "Fullscreen\0Tiled (compute)\0Clustered\0Light volumes\0");
+
 	ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "The lights are enabled only \nwhen using deferred rendering");
 
 	ImGui::SliderFloat("Lights Movement Speed", m_LightsSpeed, 0.0f, 10.0f);
@@ -96,6 +101,36 @@ void GUI::Render()
 	m_LightCol->g = m_Col[1];
 	m_LightCol->b = m_Col[2];
 
+	if (m_GPUTimings)
+	{
+		ImGui::Separator();
+		ImGui::Text("GPU Timings");
+
+		if (m_GPUTimings->valid)
+		{
+			ImGui::Text("G-Buffer  %.3f ms", m_GPUTimings->gbuffer_ms);
+			ImGui::Text("Lighting  %.3f ms", m_GPUTimings->lighting_ms);
+			ImGui::Text("ImGui     %.3f ms", m_GPUTimings->imgui_ms);
+			ImGui::Text("Frame     %.3f ms", m_GPUTimings->frame_ms);
+		}
+		else
+		{
+			ImGui::Text("Not available");
+		}
+	}
+
+	// The light list of a tile is in shared memory: the lights past its size are dropped, not shaded
+	if (m_TiledStats && m_SettingsData->lighting_mode == LIGHTING_TILED)
+	{
+		ImGui::Separator();
+		ImGui::Text("Tiled Lighting");
+		ImGui::Text("Max lights/tile  %u", m_TiledStats->max_tile_lights);
+
+		if (m_TiledStats->overflow_tiles > 0)
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%u tiles over %u lights, lighting incomplete",
+				m_TiledStats->overflow_tiles, TILED_MAX_LIGHTS_PER_TILE);
+	}
+
 	ImGui::End();
 	ImGui::Render();
 }
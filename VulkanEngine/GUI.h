@@ -1,5 +1,7 @@
 #pragma once
 
+#include "GPUProfiler.h"
+
 class GUI
 {
 public:
@@ -22,6 +24,16 @@ public:
 		m_LightCol = light_col;
 	}
 
+	void SetGPUTimings(const GPUTimings* gpu_timings)
+	{
+		m_GPUTimings = gpu_timings;
+	}
+
+	void SetTiledLightingStats(const TiledLightingStats* tiled_stats)
+	{
+		m_TiledStats = tiled_stats;
+	}
+
 	void Init();
 	void LoadFontsToGPU();
 	void Render();
@@ -41,6 +53,9 @@ private:
 	glm::vec3* m_LightCol;
 	float m_Col[3];
 
+	const GPUTimings* m_GPUTimings = nullptr;
+	const TiledLightingStats* m_TiledStats = nullptr;
+
 	VulkanRenderData m_Data;
 	ImGui_ImplVulkan_InitInfo init_info = {};
 };
@@ -0,0 +1,204 @@
+#include "pch.h"
+
+#include "GeometryArena.h"
+
+GeometryArena* GeometryArena::s_Instance = nullptr;
+
+GeometryArena* GeometryArena::GetInstance()
+{
+	if (s_Instance == 0)
+		s_Instance = new GeometryArena();
+
+	return s_Instance;
+}
+
+void GeometryArena::Init(MainDevice* main_device, const VertexFormat vertex_format)
+{
+	m_MainDevice	= main_device;
+	m_VertexFormat	= vertex_format;
+	m_VertexStride	= vertex_format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+GeometryRange GeometryArena::Allocate(const uint32_t vertex_count, const uint32_t index_count)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	GeometryRange range;
+	range.VertexCount	= vertex_count;
+	range.IndexCount	= index_count;
+
+	// Vertices and indices of a mesh must be in the same block, a single bind covers the draw
+	for (uint32_t b = 0; b < m_Blocks.size() && range.Block == UINT32_MAX; ++b)
+	{
+		GeometryBlock& block = m_Blocks[b];
+
+		if (!AllocateRange(block.FreeVertices, vertex_count, &range.FirstVertex))
+			continue;
+
+		if (!AllocateRange(block.FreeIndices, index_count, &range.FirstIndex))
+		{
+			FreeRange(block.FreeVertices, range.FirstVertex, vertex_count);
+			continue;
+		}
+
+		range.Block = b;
+	}
+
+	if (range.Block == UINT32_MAX)
+	{
+		CreateBlock(std::max(GEOMETRY_BLOCK_VERTICES, vertex_count), std::max(GEOMETRY_BLOCK_INDICES, index_count));
+
+		GeometryBlock& block = m_Blocks.back();
+
+		if (!AllocateRange(block.FreeVertices, vertex_count, &range.FirstVertex) ||
+			!AllocateRange(block.FreeIndices, index_count, &range.FirstIndex))
+			throw std::runtime_error("Failed to sub-allocate a mesh from a new geometry block!");
+
+		range.Block = static_cast<uint32_t>(m_Blocks.size() - 1);
+	}
+
+	++m_Blocks[range.Block].MeshCount;
+
+	return range;
+}
+
+void GeometryArena::Free(GeometryRange& range)
+{
+	if (range.Block == UINT32_MAX)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	GeometryBlock& block = m_Blocks[range.Block];
+
+	FreeRange(block.FreeVertices, range.FirstVertex, range.VertexCount);
+	FreeRange(block.FreeIndices, range.FirstIndex, range.IndexCount);
+	--block.MeshCount;
+
+	range = {};
+}
+
+void GeometryArena::Destroy()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (auto& block : m_Blocks)
+	{
+		if (block.MeshCount > 0)
+			std::cerr << "GeometryArena: " << block.MeshCount << " mesh(es) still alive at shutdown" << std::endl;
+
+		Utility::DestroyBuffer(block.VertexBuffer, block.VertexMemory);
+		Utility::DestroyBuffer(block.IndexBuffer, block.IndexMemory);
+	}
+
+	m_Blocks.clear();
+}
+
+void GeometryArena::DumpStatistics(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto free_count = [](const std::map<uint32_t, uint32_t>& free_ranges) {
+		uint32_t count = 0;
+
+		for (const auto& free_range : free_ranges)
+			count += free_range.second;
+
+		return count;
+	};
+
+	out << "Geometry arena" << std::endl;
+
+	for (size_t b = 0; b < m_Blocks.size(); ++b)
+	{
+		const GeometryBlock& block = m_Blocks[b];
+
+		out << "  block " << b
+			<< " | meshes " << block.MeshCount
+			<< " | vertices " << block.VertexCapacity - free_count(block.FreeVertices) << " / " << block.VertexCapacity
+			<< " | indices " << block.IndexCapacity - free_count(block.FreeIndices) << " / " << block.IndexCapacity << std::endl;
+	}
+}
+
+void GeometryArena::CreateBlock(const uint32_t vertex_capacity, const uint32_t index_capacity)
+{
+	GeometryBlock block;
+	block.VertexCapacity	= vertex_capacity;
+	block.IndexCapacity		= index_capacity;
+
+	// Only written by the staging copies of the UploadBatch, read by the input assembly
+	BufferSettings buffer_settings;
+	buffer_settings.size		= m_VertexStride * static_cast<VkDeviceSize>(vertex_capacity);
+	buffer_settings.usage		= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	buffer_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	Utility::CreateBuffer(buffer_settings, &block.VertexBuffer, &block.VertexMemory);
+
+	buffer_settings.size		= sizeof(uint32_t) * static_cast<VkDeviceSize>(index_capacity);
+	buffer_settings.usage		= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+	Utility::CreateBuffer(buffer_settings, &block.IndexBuffer, &block.IndexMemory);
+
+	block.FreeVertices[0]	= vertex_capacity;
+	block.FreeIndices[0]	= index_capacity;
+
+	m_Blocks.push_back(std::move(block));
+}
+
+bool GeometryArena::AllocateRange(std::map<uint32_t, uint32_t>& free_ranges, const uint32_t count, uint32_t* first)
+{
+	// Empty meshes take no room
+	if (count == 0)
+	{
+		*first = 0;
+		return true;
+	}
+
+	for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+	{
+		if (it->second < count)
+			continue;
+
+		*first = it->first;
+
+		const uint32_t remaining = it->second - count;
+		free_ranges.erase(it);
+
+		if (remaining > 0)
+			free_ranges[*first + count] = remaining;
+
+		return true;
+	}
+
+	return false;
+}
+
+void GeometryArena::FreeRange(std::map<uint32_t, uint32_t>& free_ranges, uint32_t first, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	// Merge with the free range that follows...
+	auto next = free_ranges.lower_bound(first);
+
+	if (next != free_ranges.end() && next->first == first + count)
+	{
+		count += next->second;
+		next = free_ranges.erase(next);
+	}
+
+	// ...and with the one that precedes
+	if (next != free_ranges.begin())
+	{
+		auto prev = std::prev(next);
+
+		if (prev->first + prev->second == first)
+		{
+			first	 = prev->first;
+			count	+= prev->second;
+			free_ranges.erase(prev);
+		}
+	}
+
+	free_ranges[first] = count;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utilities.h"
+
+// Meshes bigger than a block get a block of their own
+constexpr uint32_t GEOMETRY_BLOCK_VERTICES	= 1u << 20;
+constexpr uint32_t GEOMETRY_BLOCK_INDICES	= 1u << 22;
+
+// Vertices and indices of a mesh inside the arena: the draws use FirstVertex as vertexOffset and FirstIndex as firstIndex
+struct GeometryRange {
+	uint32_t	Block		= UINT32_MAX;
+	uint32_t	FirstVertex	= 0;
+	uint32_t	VertexCount	= 0;
+	uint32_t	FirstIndex	= 0;
+	uint32_t	IndexCount	= 0;
+};
+
+// Every mesh lives in one device local vertex buffer and one index buffer, split with a first-fit
+// free list (in vertices and indices, so the offsets go straight into the draw commands). The draws
+// of the G-buffer bind the buffers once instead of once per mesh. When a block is full a new pair of
+// buffers is created, the ranges already handed out never move, so recorded draws stay valid.
+class GeometryArena
+{
+public:
+	static GeometryArena* GetInstance();
+
+	void Init(MainDevice* main_device, const VertexFormat vertex_format);
+	GeometryRange Allocate(const uint32_t vertex_count, const uint32_t index_count);
+	void Free(GeometryRange& range);
+	void Destroy();
+
+	VkBuffer GetVertexBuffer(const uint32_t block) const	{ return m_Blocks[block].VertexBuffer; }
+	VkBuffer GetIndexBuffer(const uint32_t block) const		{ return m_Blocks[block].IndexBuffer; }
+	VertexFormat GetVertexFormat() const					{ return m_VertexFormat; }
+	VkDeviceSize GetVertexStride() const					{ return m_VertexStride; }
+
+	void DumpStatistics(std::ostream& out) const;
+
+private:
+	GeometryArena() = default;
+	static GeometryArena* s_Instance;
+
+	struct GeometryBlock {
+		VkBuffer		VertexBuffer	= VK_NULL_HANDLE;
+		Allocation		VertexMemory	= {};
+		VkBuffer		IndexBuffer		= VK_NULL_HANDLE;
+		Allocation		IndexMemory		= {};
+		uint32_t		VertexCapacity	= 0;
+		uint32_t		IndexCapacity	= 0;
+		uint32_t		MeshCount		= 0;
+
+		std::map<uint32_t, uint32_t> FreeVertices;	// first -> count, adjacent ranges are merged on Free
+		std::map<uint32_t, uint32_t> FreeIndices;
+	};
+
+	MainDevice*		m_MainDevice	= nullptr;
+	VertexFormat	m_VertexFormat	= VertexFormat::Full;
+	VkDeviceSize	m_VertexStride	= 0;
+
+	std::vector<GeometryBlock> m_Blocks;	// Never erased: the block index is stored in the ranges
+	mutable std::mutex m_Mutex;
+
+private:
+	void CreateBlock(const uint32_t vertex_capacity, const uint32_t index_capacity);
+
+	static bool AllocateRange(std::map<uint32_t, uint32_t>& free_ranges, const uint32_t count, uint32_t* first);
+	static void FreeRange(std::map<uint32_t, uint32_t>& free_ranges, uint32_t first, uint32_t count);
+};
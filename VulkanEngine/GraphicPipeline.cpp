@@ -19,51 +19,17 @@ GraphicPipeline::GraphicPipeline(MainDevice* main_device, SwapChain* swap_chain,
 void GraphicPipeline::CreateGraphicPipeline()
 {
 	//CreateShaderStages();
-	m_ShaderStages[0] = CreateVertexShaderStage("./Shaders/vert.spv");
-	m_ShaderStages[1] = CreateFragmentShaderStage("./Shaders/frag.spv");
-
-	// How the data for a single vertex (including info such as position, colour, texture coords, normals, etc) is as a whole
-	VkVertexInputBindingDescription bindingDescription = {};
-	bindingDescription.binding		= 0;									// Can bind multiple streams of data, this defines which one
-	bindingDescription.stride		= sizeof(Vertex);						// Size of a single vertex object
-	bindingDescription.inputRate	= VK_VERTEX_INPUT_RATE_VERTEX;		// How to move between data after each vertex.
-																	// VK_VERTEX_INPUT_RATE_INDEX		: Move on to the next vertex
-																	// VK_VERTEX_INPUT_RATE_INSTANCE	: Move to a vertex for the next instance
-
-	// How the data for an attribute is defined within a vertex
-	std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions;
-
-	// Position Attribute
-	attributeDescriptions[0].binding	= 0;							// Which binding the data is at (should be same as above)
-	attributeDescriptions[0].location	= 0;							// Location in shader where data will be read from
-	attributeDescriptions[0].format		= VK_FORMAT_R32G32B32_SFLOAT;	// Format the data will take (also helps define size of data)
-	attributeDescriptions[0].offset		= offsetof(Vertex, pos);		// Where this attribute is defined in the data for a single vertex
-
-	// Colour Attribute
-	attributeDescriptions[1].binding	= 0;
-	attributeDescriptions[1].location	= 1;
-	attributeDescriptions[1].format		= VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[1].offset		= offsetof(Vertex, col);
-
-	// Normal Attribute
-	attributeDescriptions[2].binding	= 0;
-	attributeDescriptions[2].location	= 2;
-	attributeDescriptions[2].format		= VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[2].offset		= offsetof(Vertex, nrm);
-
-	// Texture Attribute
-	attributeDescriptions[3].binding	= 0;
-	attributeDescriptions[3].location	= 3;
-	attributeDescriptions[3].format		= VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[3].offset		= offsetof(Vertex, tex);
+	// Vertici compressi: packed_vert.spv legge PackedVertex e lo decomprime
+	const bool packed_vertices = GeometryArena::GetInstance()->GetVertexFormat() == VertexFormat::Packed;
+	m_ShaderStages[0] = CreateVertexShaderStage(packed_vertices ? "./Shaders/packed_vert.spv" : "./Shaders/vert.spv");
+	// Texture bindless: il set 1  l'array di tutte le texture, indicizzato con la texture della draw instance
+	m_ShaderStages[1] = CreateFragmentShaderStage(m_MainDevice->BindlessTextures ? "./Shaders/bindless_frag.spv" : "./Shaders/frag.spv");
 
 	// -- VERTEX INPUT --
-	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-	vertexInputCreateInfo.sType								= VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputCreateInfo.vertexBindingDescriptionCount		= 1;
-	vertexInputCreateInfo.pVertexBindingDescriptions		= &bindingDescription;											// List of Vertex Binding Descriptions (data spacing/stride information)
-	vertexInputCreateInfo.vertexAttributeDescriptionCount	= static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputCreateInfo.pVertexAttributeDescriptions		= attributeDescriptions.data();								// List of Vertex Attribute Descriptions (data format and where to bind to/from)
+	// Binding e attributi seguono il layout dei vertici della GeometryArena (Vertex o PackedVertex).
+	// Copia locale: le pipeline successive la svuotano (nessun vertex buffer)
+	CreateVertexInputStage();
+	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = m_VertexInputStage;
 
 	// -- INPUT ASSEMBLY --
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -133,9 +99,9 @@ void GraphicPipeline::CreateGraphicPipeline()
 	colourState.alphaBlendOp		= VK_BLEND_OP_ADD;
 	// Summarised: (1 * new alpha) + (0 * old alpha) = new alpha
 
-	std::array<VkPipelineColorBlendAttachmentState, 3> colourStates
+	// Albedo + normal attachments of the G-buffer
+	std::array<VkPipelineColorBlendAttachmentState, 2> colourStates
 	{
-		colourState,
 		colourState,
 		colourState
 	};
@@ -147,18 +113,21 @@ void GraphicPipeline::CreateGraphicPipeline()
 	colour_blending.pAttachments		= colourStates.data();
 
 	// -- PIPELINE LAYOUT --
-	std::array<VkDescriptorSetLayout, 2> desc_set_layouts =
+	// Model matrix nel set 2 (letta con gl_InstanceIndex) invece che in push constant:
+	// i command buffer del G-buffer restano validi quando i modelli si spostano
+	std::array<VkDescriptorSetLayout, 3> desc_set_layouts =
 	{
 		m_ViewProjectionSetLayout,
 		m_TextureSetLayout,
+		m_ObjectSetLayout,
 	};
 
 	VkPipelineLayoutCreateInfo fst_pipeline_layout = {};
 	fst_pipeline_layout.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	fst_pipeline_layout.setLayoutCount			= static_cast<uint32_t>(desc_set_layouts.size());
 	fst_pipeline_layout.pSetLayouts				= desc_set_layouts.data();
-	fst_pipeline_layout.pushConstantRangeCount	= 1;
-	fst_pipeline_layout.pPushConstantRanges		= &m_PushCostantRange;
+	fst_pipeline_layout.pushConstantRangeCount	= 0;
+	fst_pipeline_layout.pPushConstantRanges		= nullptr;
 
 	VkResult result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &fst_pipeline_layout, nullptr, &m_FirstPipelineLayout);
 
@@ -221,11 +190,13 @@ void GraphicPipeline::CreateGraphicPipeline()
 
 	depth_stencil_info.depthWriteEnable						= VK_FALSE;
 
-	std::array<VkDescriptorSetLayout, 3> snd_pipeline_desc_set_layouts =
+	// La View-Projection serve anche qui per ricostruire la posizione dalla depth
+	std::array<VkDescriptorSetLayout, 4> snd_pipeline_desc_set_layouts =
 	{
 		m_InputSetLayout,
 		m_LightSetLayout,
-		m_SettingsSetLayout
+		m_SettingsSetLayout,
+		m_ViewProjectionSetLayout
 	};
 
 	// Create new pipeline layout
@@ -255,6 +226,162 @@ void GraphicPipeline::CreateGraphicPipeline()
 	}
 
 	DestroyShaderModules();
+
+	// -CLUSTERED PIPELINE-
+	// Stato del second pipeline, le luci arrivano dal cluster set al posto dell'UBO
+	m_ShaderStages[0] = CreateVertexShaderStage("./Shaders/second_vert.spv");
+	m_ShaderStages[1] = CreateFragmentShaderStage("./Shaders/clustered_frag.spv");
+
+	std::array<VkDescriptorSetLayout, 4> clustered_desc_set_layouts =
+	{
+		m_InputSetLayout,
+		m_ClusterSetLayout,
+		m_SettingsSetLayout,
+		m_ViewProjectionSetLayout
+	};
+
+	VkPipelineLayoutCreateInfo clustered_pipeline_layout = {};
+	clustered_pipeline_layout.sType						= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	clustered_pipeline_layout.setLayoutCount			= static_cast<uint32_t>(clustered_desc_set_layouts.size());
+	clustered_pipeline_layout.pSetLayouts				= clustered_desc_set_layouts.data();
+	clustered_pipeline_layout.pushConstantRangeCount	= 0;
+	clustered_pipeline_layout.pPushConstantRanges		= nullptr;
+
+	result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &clustered_pipeline_layout, nullptr, &m_ClusteredPipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Layout!");
+	}
+
+	pipeline_info.pStages		= m_ShaderStages;
+	pipeline_info.layout		= m_ClusteredPipelineLayout;
+
+	result = vkCreateGraphicsPipelines(m_MainDevice->LogicalDevice, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_ClusteredPipeline);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Graphics Pipeline!");
+	}
+
+	DestroyShaderModules();
+
+	// -DEPTH PRIME PIPELINE-
+	// Fullscreen triangle che copia la depth del G-buffer nel depth attachment del lighting pass,
+	// i light volume la usano per il depth test. Nessun colore scritto.
+	m_ShaderStages[0] = CreateVertexShaderStage("./Shaders/second_vert.spv");
+	m_ShaderStages[1] = CreateFragmentShaderStage("./Shaders/depth_prime_frag.spv");
+
+	colourState.colorWriteMask								= 0;
+	depth_stencil_info.depthWriteEnable						= VK_TRUE;
+	depth_stencil_info.depthCompareOp						= VK_COMPARE_OP_ALWAYS;
+
+	VkPipelineLayoutCreateInfo depth_prime_pipeline_layout = {};
+	depth_prime_pipeline_layout.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	depth_prime_pipeline_layout.setLayoutCount			= 1;
+	depth_prime_pipeline_layout.pSetLayouts				= &m_InputSetLayout;
+	depth_prime_pipeline_layout.pushConstantRangeCount	= 0;
+	depth_prime_pipeline_layout.pPushConstantRanges		= nullptr;
+
+	result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &depth_prime_pipeline_layout, nullptr, &m_DepthPrimePipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Layout!");
+	}
+
+	pipeline_info.pStages		= m_ShaderStages;
+	pipeline_info.layout		= m_DepthPrimePipelineLayout;
+
+	result = vkCreateGraphicsPipelines(m_MainDevice->LogicalDevice, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_DepthPrimePipeline);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Graphics Pipeline!");
+	}
+
+	DestroyShaderModules();
+
+	// -LIGHT VOLUME PIPELINE-
+	// Una sfera istanziata per luce: si disegnano le back face (cull front, come il fullscreen triangle) e passano
+	// solo dove la superficie del G-buffer sta davanti al retro del volume. Il contributo delle luci si somma.
+	m_ShaderStages[0] = CreateVertexShaderStage("./Shaders/light_volume_vert.spv");
+	m_ShaderStages[1] = CreateFragmentShaderStage("./Shaders/light_volume_frag.spv");
+
+	colourState.colorWriteMask								= VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+															  VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colourState.blendEnable									= VK_TRUE;
+	colourState.srcColorBlendFactor							= VK_BLEND_FACTOR_ONE;
+	colourState.dstColorBlendFactor							= VK_BLEND_FACTOR_ONE;
+	colourState.colorBlendOp								= VK_BLEND_OP_ADD;
+
+	depth_stencil_info.depthWriteEnable						= VK_FALSE;
+	depth_stencil_info.depthCompareOp						= VK_COMPARE_OP_GREATER_OR_EQUAL;
+
+	std::array<VkDescriptorSetLayout, 4> light_volume_desc_set_layouts =
+	{
+		m_InputSetLayout,
+		m_ClusterSetLayout,
+		m_SettingsSetLayout,
+		m_ViewProjectionSetLayout
+	};
+
+	VkPipelineLayoutCreateInfo light_volume_pipeline_layout = {};
+	light_volume_pipeline_layout.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	light_volume_pipeline_layout.setLayoutCount			= static_cast<uint32_t>(light_volume_desc_set_layouts.size());
+	light_volume_pipeline_layout.pSetLayouts			= light_volume_desc_set_layouts.data();
+	light_volume_pipeline_layout.pushConstantRangeCount	= 0;
+	light_volume_pipeline_layout.pPushConstantRanges	= nullptr;
+
+	result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &light_volume_pipeline_layout, nullptr, &m_LightVolumePipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Layout!");
+	}
+
+	pipeline_info.pStages		= m_ShaderStages;
+	pipeline_info.layout		= m_LightVolumePipelineLayout;
+
+	result = vkCreateGraphicsPipelines(m_MainDevice->LogicalDevice, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_LightVolumePipeline);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Graphics Pipeline!");
+	}
+
+	DestroyShaderModules();
+
+	// -COMPOSITE PIPELINE-
+	// Stesso fullscreen triangle, legge l'immagine illuminata dal compute shader del tiled lighting
+	m_ShaderStages[0] = CreateVertexShaderStage("./Shaders/second_vert.spv");
+	m_ShaderStages[1] = CreateFragmentShaderStage("./Shaders/composite_frag.spv");
+
+	colourState.blendEnable									= VK_FALSE;
+	depth_stencil_info.depthTestEnable						= VK_FALSE;
+	depth_stencil_info.depthCompareOp						= VK_COMPARE_OP_LESS;
+
+	VkPipelineLayoutCreateInfo composite_pipeline_layout = {};
+	composite_pipeline_layout.sType						= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	composite_pipeline_layout.setLayoutCount			= 1;
+	composite_pipeline_layout.pSetLayouts				= &m_CompositeSetLayout;
+	composite_pipeline_layout.pushConstantRangeCount	= 0;
+	composite_pipeline_layout.pPushConstantRanges		= nullptr;
+
+	result = vkCreatePipelineLayout(m_MainDevice->LogicalDevice, &composite_pipeline_layout, nullptr, &m_CompositePipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Layout!");
+	}
+
+	pipeline_info.pStages		= m_ShaderStages;
+	pipeline_info.layout		= m_CompositePipelineLayout;
+
+	result = vkCreateGraphicsPipelines(m_MainDevice->LogicalDevice, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_CompositePipeline);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Graphics Pipeline!");
+	}
+
+	DestroyShaderModules();
 }
 
 VkShaderModule GraphicPipeline::CreateShaderModules(const char* path)
@@ -287,17 +414,39 @@ void GraphicPipeline::SetDescriptorSetLayouts(
 
 	m_SecondPipeline			= 0;
 	m_SecondPipelineLayout		= 0;
+
+	m_CompositePipeline			= 0;
+	m_CompositePipelineLayout	= 0;
+
+	m_ClusteredPipeline			= 0;
+	m_ClusteredPipelineLayout	= 0;
+
+	m_DepthPrimePipeline		= 0;
+	m_DepthPrimePipelineLayout	= 0;
+
+	m_LightVolumePipeline		= 0;
+	m_LightVolumePipelineLayout	= 0;
+}
+
+void GraphicPipeline::SetCompositeSetLayout(VkDescriptorSetLayout& composite_set_layout)
+{
+	m_CompositeSetLayout = composite_set_layout;
 }
 
-void GraphicPipeline::SetPushCostantRange(VkPushConstantRange& pushCostantRange)
+void GraphicPipeline::SetClusterSetLayout(VkDescriptorSetLayout& cluster_set_layout)
 {
-	m_PushCostantRange = pushCostantRange;
+	m_ClusterSetLayout = cluster_set_layout;
+}
+
+void GraphicPipeline::SetObjectSetLayout(VkDescriptorSetLayout& object_set_layout)
+{
+	m_ObjectSetLayout = object_set_layout;
 }
 
 void GraphicPipeline::SetVertexStageBindingDescription()
 {
 	m_VertexStageBindingDescription.binding   = 0;							// Indice di Binding (possono essere presenti molteplici stream di binding)
-	m_VertexStageBindingDescription.stride	  = sizeof(Vertex);				// Scostamento tra gli elementi in input forniti dal Vertex
+	m_VertexStageBindingDescription.stride	  = static_cast<uint32_t>(GeometryArena::GetInstance()->GetVertexStride());	// Scostamento tra gli elementi in input (sizeof(Vertex) o sizeof(PackedVertex))
 	m_VertexStageBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // Rateo con cui i vertex attributes sono presi dai buffers TODO
 																// VK_VERTEX_INPUT_RATE_VERTEX	 : Si sposta al prossimo vertice
 																// VK_VERTEX_INPUT_RATE_INSTANCE : Si sposta al prossimo vertice per la prossima istanza
@@ -305,24 +454,29 @@ void GraphicPipeline::SetVertexStageBindingDescription()
 
 void GraphicPipeline::SetVertexttributeDescriptions()
 {
-	// Attribute Descriptions, come interpretare il Vertex Input su un dato binding stream
-	// Attribute for the Vertex Position
-	m_VertexStageAttributeDescriptions[0].binding  = 0;						    // Stream di binding al quale si riferisce
-	m_VertexStageAttributeDescriptions[0].location = 0;						    // Locazione del binding nel Vertex Shader
-	m_VertexStageAttributeDescriptions[0].format   = VK_FORMAT_R32G32B32_SFLOAT; // Formato e dimensione dell'attributo (32-bit per ogni canale di signed floating point)
-	m_VertexStageAttributeDescriptions[0].offset   = offsetof(Vertex, pos);		// Offset della posizione all'interno della struct 'Vertex'
-
-	// Attribute for the Vertex Color
-	m_VertexStageAttributeDescriptions[1].binding  = 0;						    // Stream di binding al quale si riferisce
-	m_VertexStageAttributeDescriptions[1].location = 1;						    // Locazione del binding nel Vertex Shader
-	m_VertexStageAttributeDescriptions[1].format   = VK_FORMAT_R32G32B32_SFLOAT; // Formato e dimensione dell'attributo (32-bit per ogni canale di signed floating point)
-	m_VertexStageAttributeDescriptions[1].offset   = offsetof(Vertex, col);		// Offset del colore all'interno della struct 'Vertex'
-
-	// Attrribute for the textures
-	m_VertexStageAttributeDescriptions[2].binding  = 0;						    // Stream di binding al quale si riferisce
-	m_VertexStageAttributeDescriptions[2].location = 2;						    // Locazione del binding nel Vertex Shader
-	m_VertexStageAttributeDescriptions[2].format   = VK_FORMAT_R32G32_SFLOAT;		// Formato e dimensione dell'attributo (32-bit per ogni canale di signed floating point)
-	m_VertexStageAttributeDescriptions[2].offset   = offsetof(Vertex, tex);		// Offset del colore all'interno della struct 'Vertex'
+	// Attribute Descriptions, come interpretare il Vertex Input su un dato binding stream.
+	// Le location sono quelle di shader.vert: 0 posizione, 1 colore, 2 normale, 3 texture
+	if (GeometryArena::GetInstance()->GetVertexFormat() == VertexFormat::Packed)
+	{
+		// PackedVertex: nessun colore, i formati SNORM/SFLOAT a 16 bit vengono convertiti in float dall'input assembly
+		m_VertexStageAttributeDescriptions =
+		{
+			{ 0, 0, VK_FORMAT_R16G16B16A16_SNORM,	static_cast<uint32_t>(offsetof(PackedVertex, pos)) },	// Posizione relativa all'AABB della mesh
+			{ 2, 0, VK_FORMAT_R16G16_SNORM,			static_cast<uint32_t>(offsetof(PackedVertex, nrm)) },	// Normale ottaedrica
+			{ 3, 0, VK_FORMAT_R16G16_SFLOAT,		static_cast<uint32_t>(offsetof(PackedVertex, tex)) },	// UV half float
+		};
+
+		return;
+	}
+
+	// { location, binding, formato, offset all'interno della struct 'Vertex' }
+	m_VertexStageAttributeDescriptions =
+	{
+		{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT,	static_cast<uint32_t>(offsetof(Vertex, pos)) },
+		{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT,	static_cast<uint32_t>(offsetof(Vertex, col)) },
+		{ 2, 0, VK_FORMAT_R32G32B32_SFLOAT,	static_cast<uint32_t>(offsetof(Vertex, nrm)) },
+		{ 3, 0, VK_FORMAT_R32G32_SFLOAT,	static_cast<uint32_t>(offsetof(Vertex, tex)) },
+	};
 }
 
 void GraphicPipeline::SetViewport()
@@ -487,4 +641,16 @@ void GraphicPipeline::DestroyPipeline()
 
 	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_SecondPipeline, nullptr);
 	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_SecondPipelineLayout, nullptr);
+
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_CompositePipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_CompositePipelineLayout, nullptr);
+
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_ClusteredPipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_ClusteredPipelineLayout, nullptr);
+
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_DepthPrimePipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_DepthPrimePipelineLayout, nullptr);
+
+	vkDestroyPipeline(m_MainDevice->LogicalDevice, m_LightVolumePipeline, nullptr);
+	vkDestroyPipelineLayout(m_MainDevice->LogicalDevice, m_LightVolumePipelineLayout, nullptr);
 }
\ No newline at end of file
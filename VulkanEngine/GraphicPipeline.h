@@ -12,9 +12,17 @@ public:
 
 	VkPipeline&		GetPipeline()   { return m_FirstPipeline; }
 	VkPipeline&		GetSecondPipeline() { return m_SecondPipeline; }
+	VkPipeline&		GetCompositePipeline() { return m_CompositePipeline; }
+	VkPipeline&		GetClusteredPipeline() { return m_ClusteredPipeline; }
+	VkPipeline&		GetDepthPrimePipeline() { return m_DepthPrimePipeline; }
+	VkPipeline&		GetLightVolumePipeline() { return m_LightVolumePipeline; }
 
 	VkPipelineLayout& GetLayout()		{ return m_FirstPipelineLayout; }
 	VkPipelineLayout& GetSecondLayout()	{ return m_SecondPipelineLayout; }
+	VkPipelineLayout& GetCompositeLayout() { return m_CompositePipelineLayout; }
+	VkPipelineLayout& GetClusteredLayout() { return m_ClusteredPipelineLayout; }
+	VkPipelineLayout& GetDepthPrimeLayout() { return m_DepthPrimePipelineLayout; }
+	VkPipelineLayout& GetLightVolumeLayout() { return m_LightVolumePipelineLayout; }
 
 	VkShaderModule CreateShaderModules(const char* path);
 	VkPipelineShaderStageCreateInfo CreateVertexShaderStage(const char* vert_str);
@@ -23,7 +31,9 @@ public:
 	void SetDescriptorSetLayouts(
 		VkDescriptorSetLayout& descriptorSetLayout, VkDescriptorSetLayout& textureObjects,
 		VkDescriptorSetLayout& inputSetLayout, VkDescriptorSetLayout& light_set_layout, VkDescriptorSetLayout& settings_set_layout);
-	void SetPushCostantRange(VkPushConstantRange& pushCostantRange);
+	void SetCompositeSetLayout(VkDescriptorSetLayout& composite_set_layout);
+	void SetClusterSetLayout(VkDescriptorSetLayout& cluster_set_layout);
+	void SetObjectSetLayout(VkDescriptorSetLayout& object_set_layout);
 	void SetVertexStageBindingDescription();
 	void SetVertexttributeDescriptions();
 	void SetViewport();
@@ -52,15 +62,24 @@ private:
 	VkDescriptorSetLayout	m_InputSetLayout;
 	VkDescriptorSetLayout	m_LightSetLayout;
 	VkDescriptorSetLayout	m_SettingsSetLayout;
-
-	VkPushConstantRange		m_PushCostantRange;
+	VkDescriptorSetLayout	m_CompositeSetLayout;
+	VkDescriptorSetLayout	m_ClusterSetLayout;
+	VkDescriptorSetLayout	m_ObjectSetLayout;
 
 private:
 	VkPipeline		m_FirstPipeline;
 	VkPipeline		m_SecondPipeline;
+	VkPipeline		m_CompositePipeline;	// Copia a schermo il risultato del tiled lighting (compute)
+	VkPipeline		m_ClusteredPipeline;	// Lighting pass che legge solo le luci del cluster del pixel
+	VkPipeline		m_DepthPrimePipeline;	// Copia la depth del G-buffer nel depth attachment del lighting pass
+	VkPipeline		m_LightVolumePipeline;	// Sfere delle luci, additive blending
 
 	VkPipelineLayout  m_FirstPipelineLayout;
 	VkPipelineLayout  m_SecondPipelineLayout;
+	VkPipelineLayout  m_CompositePipelineLayout;
+	VkPipelineLayout  m_ClusteredPipelineLayout;
+	VkPipelineLayout  m_DepthPrimePipelineLayout;
+	VkPipelineLayout  m_LightVolumePipelineLayout;
 		
 	VkPipelineShaderStageCreateInfo		   m_ShaderStages[2]	  = {};
 	VkPipelineVertexInputStateCreateInfo   m_VertexInputStage	  = {};
@@ -76,7 +95,7 @@ private:
 	VkShaderModule m_FragmentShaderModule;									
 
 	VkVertexInputBindingDescription					 m_VertexStageBindingDescription = {};				
-	std::array<VkVertexInputAttributeDescription, 3> m_VertexStageAttributeDescriptions;
+	std::vector<VkVertexInputAttributeDescription>	 m_VertexStageAttributeDescriptions;	// Follow the VertexFormat of the GeometryArena
 
 	VkRect2D   m_Scissor  = {};
 	VkViewport m_Viewport = {};
@@ -28,4 +28,161 @@ Light::~Light()
 
 void Light::SetLightPosition(glm::vec3 lightPosition) noexcept { m_LightData.m_LightPosition = lightPosition; }
 
-void Light::SetLightRadius(float lightRadius) noexcept { m_LightData.m_Radius = lightRadius; }
\ No newline at end of file
+void Light::SetLightRadius(float lightRadius) noexcept { m_LightData.m_Radius = lightRadius; }
+
+float Light::ComputeRange(float radius) noexcept
+{
+	// radius / (d^2 + 1) = LIGHT_CUTOFF
+	return std::sqrt(std::max(radius / LIGHT_CUTOFF - 1.0f, 0.0f));
+}
+
+LightClusters::LightClusters()
+{
+	m_Header = {};
+	m_Ranges.resize(CLUSTER_COUNT);
+	m_Cursors.resize(CLUSTER_COUNT);
+}
+
+void LightClusters::Build(const std::vector<LightData>& lights, const glm::mat4& view, const glm::mat4& projection,
+	float near_plane, float far_plane)
+{
+	const float log_ratio = std::log(far_plane / near_plane);
+
+	m_Header.near_plane		= near_plane;
+	m_Header.far_plane		= far_plane;
+	m_Header.slice_scale	= static_cast<float>(CLUSTER_DIM_Z) / log_ratio;
+	m_Header.slice_bias		= -static_cast<float>(CLUSTER_DIM_Z) * std::log(near_plane) / log_ratio;
+
+	m_Boxes.clear();
+	m_BoxLights.clear();
+	std::fill(m_Cursors.begin(), m_Cursors.end(), 0u);
+
+	// 1) Cluster box of every light, the cursors count the lights of each cluster
+	for (uint32_t i = 0; i < static_cast<uint32_t>(lights.size()); ++i)
+	{
+		ClusterBox box;
+
+		if (!ComputeClusterBox(lights[i], view, projection, box))
+			continue;
+
+		m_Boxes.push_back(box);
+		m_BoxLights.push_back(i);
+
+		for (uint32_t z = box.min_z; z <= box.max_z; ++z)
+			for (uint32_t y = box.min_y; y <= box.max_y; ++y)
+				for (uint32_t x = box.min_x; x <= box.max_x; ++x)
+					++m_Cursors[(z * CLUSTER_DIM_Y + y) * CLUSTER_DIM_X + x];
+	}
+
+	// 2) Prefix sum, the cursors become the next free slot of each list
+	uint32_t total = 0;
+
+	for (uint32_t c = 0; c < CLUSTER_COUNT; ++c)
+	{
+		m_Ranges[c].offset	= total;
+		m_Ranges[c].count	= std::min(m_Cursors[c], MAX_CLUSTER_LIGHT_INDICES - total);
+		m_Cursors[c]		= total;
+		total			   += m_Ranges[c].count;
+	}
+
+	m_Header.index_count = total;
+	m_LightIndices.resize(total);
+
+	// 3) Fill, the lights keep their order inside every list
+	for (size_t b = 0; b < m_Boxes.size(); ++b)
+	{
+		const ClusterBox& box = m_Boxes[b];
+
+		for (uint32_t z = box.min_z; z <= box.max_z; ++z)
+			for (uint32_t y = box.min_y; y <= box.max_y; ++y)
+				for (uint32_t x = box.min_x; x <= box.max_x; ++x)
+				{
+					const uint32_t c = (z * CLUSTER_DIM_Y + y) * CLUSTER_DIM_X + x;
+
+					if (m_Cursors[c] < m_Ranges[c].offset + m_Ranges[c].count)
+						m_LightIndices[m_Cursors[c]++] = m_BoxLights[b];
+				}
+	}
+}
+
+bool LightClusters::ComputeClusterBox(const LightData& light, const glm::mat4& view, const glm::mat4& projection, ClusterBox& box) const
+{
+	const float range = Light::ComputeRange(light.m_Radius);
+
+	if (range <= 0.0f)
+		return false;
+
+	// The view space looks down -Z, the depth is positive in front of the camera
+	const glm::vec3 center	= glm::vec3(view * glm::vec4(light.m_LightPosition, 1.0f));
+	const float depth		= -center.z;
+
+	const float min_depth = std::max(depth - range, m_Header.near_plane);
+	const float max_depth = std::min(depth + range, m_Header.far_plane);
+
+	if (min_depth > max_depth)
+		return false;
+
+	// Symmetric perspective: ndc = P[i][i] * coord / depth, the extremes of the sphere AABB are on its corners
+	auto project_range = [min_depth, max_depth](float scale, float lo, float hi, float& ndc_min, float& ndc_max)
+	{
+		const float a = scale * lo / min_depth;
+		const float b = scale * lo / max_depth;
+		const float c = scale * hi / min_depth;
+		const float d = scale * hi / max_depth;
+
+		ndc_min = std::min(std::min(a, b), std::min(c, d));
+		ndc_max = std::max(std::max(a, b), std::max(c, d));
+	};
+
+	float ndc_min_x, ndc_max_x, ndc_min_y, ndc_max_y;
+	project_range(projection[0][0], center.x - range, center.x + range, ndc_min_x, ndc_max_x);
+	project_range(projection[1][1], center.y - range, center.y + range, ndc_min_y, ndc_max_y);
+
+	if (ndc_max_x < -1.0f || ndc_min_x > 1.0f || ndc_max_y < -1.0f || ndc_min_y > 1.0f)
+		return false;
+
+	// NDC -> tile, same mapping of the fullscreen triangle UVs used by the shader
+	auto to_tile = [](float ndc, uint32_t dim)
+	{
+		const float t = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(dim));
+		return static_cast<uint32_t>(std::min(std::max(t, 0.0f), static_cast<float>(dim - 1)));
+	};
+
+	box.min_x = to_tile(ndc_min_x, CLUSTER_DIM_X);
+	box.max_x = to_tile(ndc_max_x, CLUSTER_DIM_X);
+	box.min_y = to_tile(ndc_min_y, CLUSTER_DIM_Y);
+	box.max_y = to_tile(ndc_max_y, CLUSTER_DIM_Y);
+	box.min_z = DepthSlice(min_depth);
+	box.max_z = DepthSlice(max_depth);
+
+	return true;
+}
+
+uint32_t LightClusters::DepthSlice(float view_depth) const
+{
+	const float slice = std::floor(std::log(view_depth) * m_Header.slice_scale + m_Header.slice_bias);
+	return static_cast<uint32_t>(std::min(std::max(slice, 0.0f), static_cast<float>(CLUSTER_DIM_Z - 1)));
+}
+
+void LightClusters::WriteTo(void* destination) const
+{
+	char* data = static_cast<char*>(destination);
+
+	memcpy(data, &m_Header, sizeof(ClusterGridHeader));
+	data += sizeof(ClusterGridHeader);
+
+	memcpy(data, m_Ranges.data(), CLUSTER_COUNT * sizeof(ClusterRange));
+	data += CLUSTER_COUNT * sizeof(ClusterRange);
+
+	memcpy(data, m_LightIndices.data(), m_LightIndices.size() * sizeof(uint32_t));
+}
+
+VkDeviceSize LightClusters::GetByteSize() const
+{
+	return sizeof(ClusterGridHeader) + CLUSTER_COUNT * sizeof(ClusterRange) + m_LightIndices.size() * sizeof(uint32_t);
+}
+
+VkDeviceSize LightClusters::MaxByteSize()
+{
+	return sizeof(ClusterGridHeader) + CLUSTER_COUNT * sizeof(ClusterRange) + MAX_CLUSTER_LIGHT_INDICES * sizeof(uint32_t);
+}
@@ -9,6 +9,12 @@ struct LightData {
 	float m_Radius = 1.0f;
 };
 
+// Intestazione del light buffer (LightManager): in std430 l'array di LightData parte dopo 16 byte
+struct LightBufferHeader {
+	uint32_t count = 0;
+	uint32_t padding[3] = {};
+};
+
 class Light
 {
 public:
@@ -20,6 +26,79 @@ public:
 	void SetLightRadius(float radius) noexcept;
 	LightData GetUBOData() const { return m_LightData; }
 
+	static float ComputeRange(float radius) noexcept;	// Distance where radius / (d^2 + 1) drops below LIGHT_CUTOFF
+
 private:
 	LightData m_LightData;
+};
+
+// Attenuation below which a light no longer contributes (tiled, clustered and light volumes)
+constexpr float LIGHT_CUTOFF = 1.0f / 256.0f;
+
+// Light volume sphere, generated from gl_VertexIndex in light_volume.vert (same #defines)
+constexpr uint32_t LIGHT_VOLUME_SEGMENTS	 = 12;
+constexpr uint32_t LIGHT_VOLUME_RINGS		 = 8;
+constexpr uint32_t LIGHT_VOLUME_VERTEX_COUNT = LIGHT_VOLUME_SEGMENTS * LIGHT_VOLUME_RINGS * 6;	// Two triangles per quad
+
+// Cluster grid: uniform tiles on the screen, exponential slices in depth.
+// The dimensions must match the #defines of clustered_shader.frag
+constexpr uint32_t CLUSTER_DIM_X		 = 16;
+constexpr uint32_t CLUSTER_DIM_Y		 = 9;
+constexpr uint32_t CLUSTER_DIM_Z		 = 24;
+constexpr uint32_t CLUSTER_COUNT		 = CLUSTER_DIM_X * CLUSTER_DIM_Y * CLUSTER_DIM_Z;
+constexpr uint32_t MAX_CLUSTER_LIGHT_INDICES = 128 * 1024;	// Indices past this limit are dropped
+
+// Cluster buffer header (std430), followed by CLUSTER_COUNT ClusterRange and by the light indices
+struct ClusterGridHeader {
+	uint32_t	dim_x		= CLUSTER_DIM_X;
+	uint32_t	dim_y		= CLUSTER_DIM_Y;
+	uint32_t	dim_z		= CLUSTER_DIM_Z;
+	uint32_t	index_count = 0;
+	float		near_plane	= 0.1f;
+	float		far_plane	= 100.0f;
+	float		slice_scale = 0.0f;		// slice = log(view_depth) * slice_scale + slice_bias
+	float		slice_bias	= 0.0f;
+};
+
+struct ClusterRange {
+	uint32_t	offset	= 0;	// First index of the cluster list
+	uint32_t	count	= 0;
+};
+
+// CPU assignment of the lights to the clusters (froxels). It has no Vulkan dependency, so it can be
+// benchmarked on its own. Every light is a sphere of Light::ComputeRange() radius: its view-space AABB
+// is projected on the grid and the light goes in every cluster of the box (conservative). Two passes,
+// count + prefix sum and fill, the lists of all the clusters share one contiguous index array.
+class LightClusters
+{
+public:
+	LightClusters();
+
+	void Build(const std::vector<LightData>& lights, const glm::mat4& view, const glm::mat4& projection,
+		float near_plane, float far_plane);
+
+	void WriteTo(void* destination) const;		// Header + ranges + indices, in the cluster buffer layout
+	VkDeviceSize GetByteSize() const;
+
+	const ClusterGridHeader& GetHeader() const				{ return m_Header; }
+	const std::vector<ClusterRange>& GetRanges() const		{ return m_Ranges; }
+	const std::vector<uint32_t>& GetLightIndices() const	{ return m_LightIndices; }
+
+	static VkDeviceSize MaxByteSize();
+
+private:
+	struct ClusterBox {
+		uint32_t min_x, max_x, min_y, max_y, min_z, max_z;
+	};
+
+	bool ComputeClusterBox(const LightData& light, const glm::mat4& view, const glm::mat4& projection, ClusterBox& box) const;
+	uint32_t DepthSlice(float view_depth) const;
+
+	ClusterGridHeader			m_Header;
+	std::vector<ClusterRange>	m_Ranges;
+	std::vector<uint32_t>		m_LightIndices;
+
+	std::vector<ClusterBox>		m_Boxes;		// Scratch, one box per visible light
+	std::vector<uint32_t>		m_BoxLights;
+	std::vector<uint32_t>		m_Cursors;
 };
\ No newline at end of file
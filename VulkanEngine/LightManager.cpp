@@ -0,0 +1,126 @@
+#include "pch.h"
+
+#include "LightManager.h"
+
+LightManager::LightManager()
+{
+}
+
+LightManager::LightManager(MainDevice* main_device)
+{
+	m_Storage = FrameSlicedBuffer(main_device, sizeof(LightBufferHeader), sizeof(LightData), "light");
+}
+
+void LightManager::CreateBuffer()
+{
+	m_Storage.CreateBuffer(std::max(LIGHT_BUFFER_INITIAL_CAPACITY, GetCount()));
+}
+
+bool LightManager::BeginFrame(uint32_t frame)
+{
+	const bool recreated = m_Storage.BeginFrame(frame, GetCount());
+
+	// The count is always rewritten, removals shrink the list without touching the lights left
+	LightBufferHeader header;
+	header.count = GetCount();
+
+	m_Storage.WriteHeader(&header);
+	m_Storage.UploadDirty(m_Lights.data(), GetCount());
+
+	return recreated;
+}
+
+void LightManager::DestroyBuffer()
+{
+	m_Storage.DestroyBuffer();
+}
+
+LightHandle LightManager::Add(const LightData& light)
+{
+	LightHandle handle;
+
+	if (!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<LightHandle>(m_HandleToIndex.size());
+		m_HandleToIndex.push_back(UINT32_MAX);
+	}
+
+	m_HandleToIndex[handle] = GetCount();
+	m_IndexToHandle.push_back(handle);
+	m_Lights.push_back(light);
+
+	m_Storage.MarkDirty(GetCount() - 1);
+
+	return handle;
+}
+
+void LightManager::Remove(LightHandle handle)
+{
+	if (!IsValid(handle))
+		return;
+
+	const uint32_t index = m_HandleToIndex[handle];
+	const uint32_t last	 = GetCount() - 1;
+
+	// The last light fills the hole, only that slot changes on the GPU
+	if (index != last)
+	{
+		m_Lights[index]			= m_Lights[last];
+		m_IndexToHandle[index]	= m_IndexToHandle[last];
+		m_HandleToIndex[m_IndexToHandle[index]] = index;
+
+		m_Storage.MarkDirty(index);
+	}
+
+	m_Lights.pop_back();
+	m_IndexToHandle.pop_back();
+
+	m_HandleToIndex[handle] = UINT32_MAX;
+	m_FreeHandles.push_back(handle);
+}
+
+void LightManager::Update(LightHandle handle, const LightData& light)
+{
+	if (!IsValid(handle))
+		return;
+
+	m_Lights[m_HandleToIndex[handle]] = light;
+	m_Storage.MarkDirty(m_HandleToIndex[handle]);
+}
+
+void LightManager::SetPosition(LightHandle handle, const glm::vec3& position)
+{
+	if (!IsValid(handle))
+		return;
+
+	m_Lights[m_HandleToIndex[handle]].m_LightPosition = position;
+	m_Storage.MarkDirty(m_HandleToIndex[handle]);
+}
+
+void LightManager::SetColour(LightHandle handle, const glm::vec3& colour)
+{
+	if (!IsValid(handle))
+		return;
+
+	m_Lights[m_HandleToIndex[handle]].m_Colour = colour;
+	m_Storage.MarkDirty(m_HandleToIndex[handle]);
+}
+
+void LightManager::SetRadius(LightHandle handle, float radius)
+{
+	if (!IsValid(handle))
+		return;
+
+	m_Lights[m_HandleToIndex[handle]].m_Radius = radius;
+	m_Storage.MarkDirty(m_HandleToIndex[handle]);
+}
+
+bool LightManager::IsValid(LightHandle handle) const
+{
+	return handle < m_HandleToIndex.size() && m_HandleToIndex[handle] != UINT32_MAX;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Light.h"
+#include "FrameSlicedBuffer.h"
+
+typedef uint32_t LightHandle;
+
+constexpr LightHandle INVALID_LIGHT_HANDLE			= UINT32_MAX;
+constexpr uint32_t	  LIGHT_BUFFER_INITIAL_CAPACITY = 256;	// Lights, the buffer doubles when it is full
+
+// Scene lights, addressed by stable handles and stored densely in a host visible storage buffer
+// (LightBufferHeader + LightData[count]) read by every lighting path.
+// The buffer is a FrameSlicedBuffer: one slice per frame in flight, only the lights changed since the
+// last write of a slice are copied, the header with the count is rewritten every frame.
+class LightManager
+{
+public:
+	LightManager();
+	LightManager(MainDevice* main_device);
+
+	void CreateBuffer();
+	bool BeginFrame(uint32_t frame);	// Uploads the dirty lights of the frame slice, true if the buffer was recreated
+	void DestroyBuffer();
+
+	LightHandle Add(const LightData& light);
+	void Remove(LightHandle handle);
+	void Update(LightHandle handle, const LightData& light);
+	void SetPosition(LightHandle handle, const glm::vec3& position);
+	void SetColour(LightHandle handle, const glm::vec3& colour);
+	void SetRadius(LightHandle handle, float radius);
+
+	bool IsValid(LightHandle handle) const;
+	const LightData& Get(LightHandle handle) const	{ return m_Lights[m_HandleToIndex[handle]]; }
+
+	uint32_t GetCount() const						{ return static_cast<uint32_t>(m_Lights.size()); }
+	const std::vector<LightData>& GetLights() const	{ return m_Lights; }	// Same order of the GPU buffer
+
+	VkBuffer& GetBuffer()							{ return m_Storage.GetBuffer(); }
+	VkDeviceSize GetSliceSize() const				{ return m_Storage.GetSliceSize(); }		// Range of the descriptors
+	uint32_t GetFrameOffset() const					{ return m_Storage.GetFrameOffset(); }
+	VkDeviceSize GetLastUploadSize() const			{ return m_Storage.GetLastUploadSize(); }
+
+private:
+	FrameSlicedBuffer			m_Storage;
+
+	std::vector<LightData>		m_Lights;			// Dense, removals move the last light in the hole
+	std::vector<LightHandle>	m_IndexToHandle;
+	std::vector<uint32_t>		m_HandleToIndex;	// UINT32_MAX for the free handles
+	std::vector<LightHandle>	m_FreeHandles;
+};
@@ -57,6 +57,8 @@ int main(void)
 	GUI::GetInstance()->SetRenderData(
 		vulkanRenderer->GetRenderData(), window.getWindow(),
 		vulkanRenderer->GetUBOSettingsRef(), &lights_speed, &light_idx, &light_col);
+	GUI::GetInstance()->SetGPUTimings(&vulkanRenderer->GetGPUTimings());
+	GUI::GetInstance()->SetTiledLightingStats(&vulkanRenderer->GetTiledLightingStats());
 	GUI::GetInstance()->Init();
 	GUI::GetInstance()->LoadFontsToGPU();
 
@@ -64,7 +66,7 @@ int main(void)
 	glm::mat4 model(1.0f);
 	model = glm::translate(model, glm::vec3(-4.5f, -0.5f, 2.5f));
 	model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	vulkanRenderer->UpdateModel(3, model);
+	vulkanRenderer->UpdateModel(1, model);
 
 	// Vivi models
 	glm::mat4 fst_model(1.0f);
@@ -80,9 +82,10 @@ int main(void)
 	thd_model = glm::translate(thd_model, glm::vec3(1.0f, -0.5f, 0.0f));
 	thd_model = glm::scale(thd_model, 0.4f * glm::vec3(1.0f, 1.0f, 1.0f));
 
+	// One model, three instances: a single instanced draw per mesh
 	vulkanRenderer->UpdateModel(0, fst_model);
-	vulkanRenderer->UpdateModel(1, snd_model);
-	vulkanRenderer->UpdateModel(2, thd_model);
+	vulkanRenderer->AddModelInstance(0, snd_model);
+	vulkanRenderer->AddModelInstance(0, thd_model);
 
 	// Timing for fps
 	double previous_time = glfwGetTime();
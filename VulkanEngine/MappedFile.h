@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pch.h"
+
+// Read-only memory mapping of a whole file: the OS pages the data in on demand, nothing
+// is copied into process memory until it is read.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const				{ return m_Data != nullptr; }
+	const uint8_t* GetData() const	{ return m_Data; }
+	size_t GetSize() const			{ return m_Size; }
+
+private:
+	const uint8_t*	m_Data = nullptr;
+	size_t			m_Size = 0;
+
+#ifdef _WIN32
+	void* m_File	= nullptr;
+	void* m_Mapping	= nullptr;
+#else
+	int m_File		= -1;
+#endif
+};
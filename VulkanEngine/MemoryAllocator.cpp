@@ -0,0 +1,283 @@
+#include "pch.h"
+
+#include "MemoryAllocator.h"
+#include "Utilities.h"
+
+MemoryAllocator* MemoryAllocator::s_Instance = nullptr;
+
+// Resources bigger than a block get a block of their own
+constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ULL * 1024ULL * 1024ULL;
+
+static VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+{
+	// Vulkan alignments are always powers of two
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+MemoryAllocator* MemoryAllocator::GetInstance()
+{
+	if (s_Instance == 0)
+		s_Instance = new MemoryAllocator();
+
+	return s_Instance;
+}
+
+void MemoryAllocator::Init(MainDevice* main_device)
+{
+	m_MainDevice = main_device;
+	vkGetPhysicalDeviceMemoryProperties(m_MainDevice->PhysicalDevice, &m_MemoryProperties);
+}
+
+Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags& properties, const bool linear)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const uint32_t memory_type	= Utility::FindMemoryTypeIndex(requirements.memoryTypeBits, properties);
+	MemoryPool& pool			= GetPool(memory_type, linear);
+
+	MemoryBlock* block	= nullptr;
+	VkDeviceSize offset	= 0;
+
+	for (auto& candidate : pool.Blocks)
+	{
+		if (AllocateFromBlock(candidate, requirements, &offset))
+		{
+			block = &candidate;
+			break;
+		}
+	}
+
+	if (!block)
+	{
+		CreateBlock(pool, memory_type, std::max(PreferredBlockSize(memory_type), requirements.size));
+		block = &pool.Blocks.back();
+
+		if (!AllocateFromBlock(*block, requirements, &offset))
+			throw std::runtime_error("Failed to sub-allocate from a new memory block!");
+	}
+
+	Allocation allocation = {};
+	allocation.Memory		= block->Memory;
+	allocation.Offset		= offset;
+	allocation.Size			= requirements.size;
+	allocation.MemoryType	= memory_type;
+	allocation.Linear		= linear;
+	allocation.Mapped		= block->Mapped ? static_cast<char*>(block->Mapped) + offset : nullptr;
+
+	return allocation;
+}
+
+void MemoryAllocator::Free(Allocation& allocation)
+{
+	if (allocation.Memory == VK_NULL_HANDLE)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	MemoryPool& pool = GetPool(allocation.MemoryType, allocation.Linear);
+
+	auto block = std::find_if(pool.Blocks.begin(), pool.Blocks.end(),
+		[&allocation](const MemoryBlock& b) { return b.Memory == allocation.Memory; });
+
+	if (block == pool.Blocks.end())
+		throw std::runtime_error("Attempted to free memory that doesn't belong to the allocator!");
+
+	VkDeviceSize offset = allocation.Offset;
+	VkDeviceSize size	= allocation.Size;
+
+	// Merge with the free range that follows...
+	auto next = block->FreeRanges.lower_bound(offset);
+
+	if (next != block->FreeRanges.end() && next->first == offset + size)
+	{
+		size += next->second;
+		next = block->FreeRanges.erase(next);
+	}
+
+	// ...and with the one that precedes, so the holes don't fragment the block
+	if (next != block->FreeRanges.begin())
+	{
+		auto prev = std::prev(next);
+
+		if (prev->first + prev->second == offset)
+		{
+			offset	 = prev->first;
+			size	+= prev->second;
+			block->FreeRanges.erase(prev);
+		}
+	}
+
+	block->FreeRanges[offset] = size;
+	block->Used -= allocation.Size;
+	--block->AllocationCount;
+
+	// Empty blocks go back to the driver, the last one of the pool is kept to avoid allocating it again right away
+	if (block->AllocationCount == 0 && pool.Blocks.size() > 1)
+	{
+		DestroyBlock(*block);
+		pool.Blocks.erase(block);
+	}
+
+	allocation = {};
+}
+
+void MemoryAllocator::Destroy()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (auto& pool : m_Pools)
+	{
+		for (auto& block : pool.Blocks)
+		{
+			if (block.AllocationCount > 0)
+				std::cerr << "MemoryAllocator: " << block.AllocationCount << " allocation(s) still alive at shutdown" << std::endl;
+
+			DestroyBlock(block);
+		}
+
+		pool.Blocks.clear();
+	}
+}
+
+AllocatorStatistics MemoryAllocator::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	AllocatorStatistics stats;
+
+	for (const auto& pool : m_Pools)
+		AccumulateStatistics(pool, stats);
+
+	return stats;
+}
+
+void MemoryAllocator::DumpStatistics(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto to_mb = [](const VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+	AllocatorStatistics total;
+
+	out << "Device memory allocator" << std::endl;
+
+	for (uint32_t i = 0; i < m_Pools.size(); ++i)
+	{
+		if (m_Pools[i].Blocks.empty())
+			continue;
+
+		AllocatorStatistics stats;
+		AccumulateStatistics(m_Pools[i], stats);
+		AccumulateStatistics(m_Pools[i], total);
+
+		const uint32_t memory_type = i / 2;
+
+		out << "  type " << memory_type << ((i % 2 == 0) ? " (buffers)" : " (images) ")
+			<< " flags 0x" << std::hex << m_MemoryProperties.memoryTypes[memory_type].propertyFlags << std::dec
+			<< " | blocks " << stats.BlockCount
+			<< " | allocations " << stats.AllocationCount
+			<< " | used " << to_mb(stats.UsedBytes) << " / " << to_mb(stats.BlockBytes) << " MB"
+			<< " | largest free " << to_mb(stats.LargestFreeRange) << " MB" << std::endl;
+	}
+
+	out << "  total: " << total.BlockCount << " vkAllocateMemory for " << total.AllocationCount << " resources, "
+		<< to_mb(total.UsedBytes) << " / " << to_mb(total.BlockBytes) << " MB used" << std::endl;
+}
+
+MemoryAllocator::MemoryPool& MemoryAllocator::GetPool(const uint32_t memory_type, const bool linear)
+{
+	return m_Pools[memory_type * 2 + (linear ? 0 : 1)];
+}
+
+VkDeviceSize MemoryAllocator::PreferredBlockSize(const uint32_t memory_type) const
+{
+	const uint32_t heap_index	= m_MemoryProperties.memoryTypes[memory_type].heapIndex;
+	const VkDeviceSize heap_size = m_MemoryProperties.memoryHeaps[heap_index].size;
+
+	// Small heaps (e.g. the 256 MB device local + host visible one) are not split in a few huge blocks
+	return std::min(DEFAULT_BLOCK_SIZE, heap_size / 8);
+}
+
+void MemoryAllocator::CreateBlock(MemoryPool& pool, const uint32_t memory_type, const VkDeviceSize size)
+{
+	MemoryBlock block;
+	block.Size = size;
+
+	VkMemoryAllocateInfo memory_alloc_info = {};
+	memory_alloc_info.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_alloc_info.allocationSize	= size;
+	memory_alloc_info.memoryTypeIndex	= memory_type;
+
+	VkResult result = vkAllocateMemory(m_MainDevice->LogicalDevice, &memory_alloc_info, nullptr, &block.Memory);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to allocate a device memory block!");
+
+	// Mapping once per block: the resources inside just offset the pointer
+	if (m_MemoryProperties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		result = vkMapMemory(m_MainDevice->LogicalDevice, block.Memory, 0, VK_WHOLE_SIZE, 0, &block.Mapped);
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("Failed to map a device memory block!");
+	}
+
+	block.FreeRanges[0] = size;
+
+	pool.Blocks.push_back(block);
+}
+
+void MemoryAllocator::DestroyBlock(MemoryBlock& block)
+{
+	if (block.Mapped)
+		vkUnmapMemory(m_MainDevice->LogicalDevice, block.Memory);
+
+	vkFreeMemory(m_MainDevice->LogicalDevice, block.Memory, nullptr);
+
+	block = {};
+}
+
+bool MemoryAllocator::AllocateFromBlock(MemoryBlock& block, const VkMemoryRequirements& requirements, VkDeviceSize* offset)
+{
+	// First fit: the first hole that can host the aligned range
+	for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it)
+	{
+		const VkDeviceSize range_begin	= it->first;
+		const VkDeviceSize range_end	= it->first + it->second;
+		const VkDeviceSize aligned		= AlignUp(range_begin, requirements.alignment);
+
+		if (aligned + requirements.size > range_end)
+			continue;
+
+		block.FreeRanges.erase(it);
+
+		// The alignment padding and the tail of the hole stay free
+		if (aligned > range_begin)
+			block.FreeRanges[range_begin] = aligned - range_begin;
+
+		if (aligned + requirements.size < range_end)
+			block.FreeRanges[aligned + requirements.size] = range_end - (aligned + requirements.size);
+
+		block.Used += requirements.size;
+		++block.AllocationCount;
+
+		*offset = aligned;
+		return true;
+	}
+
+	return false;
+}
+
+void MemoryAllocator::AccumulateStatistics(const MemoryPool& pool, AllocatorStatistics& stats)
+{
+	for (const auto& block : pool.Blocks)
+	{
+		++stats.BlockCount;
+		stats.AllocationCount	+= block.AllocationCount;
+		stats.BlockBytes		+= block.Size;
+		stats.UsedBytes			+= block.Used;
+
+		for (const auto& range : block.FreeRanges)
+			stats.LargestFreeRange = std::max(stats.LargestFreeRange, range.second);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pch.h"
+
+struct AllocatorStatistics {
+	uint32_t		BlockCount		= 0;	// vkAllocateMemory calls currently alive
+	uint32_t		AllocationCount	= 0;	// Buffers/images placed inside the blocks
+	VkDeviceSize	BlockBytes		= 0;	// Device memory reserved by the blocks
+	VkDeviceSize	UsedBytes		= 0;	// Bytes handed out to the resources
+	VkDeviceSize	LargestFreeRange = 0;	// Biggest contiguous hole, a fragmentation hint
+};
+
+// Device memory is reserved in large blocks (one pool per memory type) and split among
+// the resources with a first-fit free list: vkAllocateMemory is called once per block
+// instead of once per buffer/image, which keeps us far from maxMemoryAllocationCount.
+class MemoryAllocator
+{
+public:
+	static MemoryAllocator* GetInstance();
+
+	void Init(MainDevice* main_device);
+	Allocation Allocate(const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags& properties, const bool linear);
+	void Free(Allocation& allocation);
+	void Destroy();
+
+	AllocatorStatistics GetStatistics() const;
+	void DumpStatistics(std::ostream& out) const;
+
+private:
+	MemoryAllocator() = default;
+	static MemoryAllocator* s_Instance;
+
+	struct MemoryBlock {
+		VkDeviceMemory	Memory			= VK_NULL_HANDLE;
+		VkDeviceSize	Size			= 0;
+		VkDeviceSize	Used			= 0;
+		uint32_t		AllocationCount = 0;
+		void*			Mapped			= nullptr;	// HOST_VISIBLE blocks stay mapped for their whole life
+
+		std::map<VkDeviceSize, VkDeviceSize> FreeRanges;	// offset -> size, adjacent ranges are merged on Free
+	};
+
+	// Buffers and optimal-tiling images never share a block, so bufferImageGranularity can be ignored
+	struct MemoryPool {
+		std::vector<MemoryBlock> Blocks;
+	};
+
+	MainDevice*	m_MainDevice = nullptr;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+
+	std::array<MemoryPool, VK_MAX_MEMORY_TYPES * 2> m_Pools;
+	mutable std::mutex m_Mutex;
+
+private:
+	MemoryPool& GetPool(const uint32_t memory_type, const bool linear);
+	VkDeviceSize PreferredBlockSize(const uint32_t memory_type) const;
+	void CreateBlock(MemoryPool& pool, const uint32_t memory_type, const VkDeviceSize size);
+	void DestroyBlock(MemoryBlock& block);
+	bool AllocateFromBlock(MemoryBlock& block, const VkMemoryRequirements& requirements, VkDeviceSize* offset);
+
+	static void AccumulateStatistics(const MemoryPool& pool, AllocatorStatistics& stats);
+};
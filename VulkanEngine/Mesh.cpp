@@ -2,98 +2,164 @@
 
 #include "Mesh.h"
 
+#include <glm/gtc/packing.hpp>
+
+// Stessa codifica ottaedrica di shader.frag, decodificata in shader.vert
+static glm::vec2 EncodeOctahedral(glm::vec3 n)
+{
+	const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+
+	if (l1 == 0.0f)
+		return glm::vec2(0.0f);
+
+	n /= l1;
+
+	if (n.z < 0.0f)
+	{
+		const glm::vec2 wrapped = (1.0f - glm::abs(glm::vec2(n.y, n.x))) *
+			glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+
+		n.x = wrapped.x;
+		n.y = wrapped.y;
+	}
+
+	return glm::vec2(n.x, n.y);
+}
+
+static PackedVertex PackVertex(const Vertex& vertex, const glm::vec3& offset, const glm::vec3& inv_scale)
+{
+	const glm::vec3 position	= (vertex.pos - offset) * inv_scale;
+	const glm::vec2 normal		= EncodeOctahedral(vertex.nrm);
+
+	PackedVertex packed;
+	packed.pos[0] = static_cast<int16_t>(glm::packSnorm1x16(position.x));
+	packed.pos[1] = static_cast<int16_t>(glm::packSnorm1x16(position.y));
+	packed.pos[2] = static_cast<int16_t>(glm::packSnorm1x16(position.z));
+	packed.pos[3] = 0;
+	packed.nrm[0] = static_cast<int16_t>(glm::packSnorm1x16(normal.x));
+	packed.nrm[1] = static_cast<int16_t>(glm::packSnorm1x16(normal.y));
+	packed.tex[0] = glm::packHalf1x16(vertex.tex.x);
+	packed.tex[1] = glm::packHalf1x16(vertex.tex.y);
+
+	return packed;
+}
+
 Mesh::Mesh(MainDevice &mainDevice,
-		   VkQueue transferQueue,
-		   VkCommandPool transferCommandPool,
+		   UploadBatch& uploadBatch,
 		   std::vector<Vertex>* vertices,
 		   std::vector<uint32_t>* indices,
 			int newTexID)
+	: Mesh(mainDevice, uploadBatch,
+		vertices->data(), static_cast<uint32_t>(vertices->size()),
+		indices->data(), static_cast<uint32_t>(indices->size()), newTexID)
 {
-	m_vertexCount    = static_cast<int>(vertices->size());
-	m_indexCount	 = static_cast<int>(indices->size());
+}
+
+// I dati possono arrivare da qualsiasi memoria CPU (es. un file cooked mappato): vengono copiati direttamente nello staging
+Mesh::Mesh(MainDevice &mainDevice,
+		   UploadBatch& uploadBatch,
+		   const Vertex* vertices, uint32_t vertexCount,
+		   const uint32_t* indices, uint32_t indexCount,
+		   int newTexID)
+{
+	m_vertexCount    = static_cast<int>(vertexCount);
+	m_indexCount	 = static_cast<int>(indexCount);
 	m_MainDevice	 = mainDevice;
+	m_geometry		 = GeometryArena::GetInstance()->Allocate(vertexCount, indexCount);
 
-	createVertexBuffer(transferQueue, transferCommandPool, vertices);
-	createIndexBuffer(transferQueue, transferCommandPool, indices);
+	// I bounds servono prima dell'upload: le posizioni compresse sono relative all'AABB
+	computeBounds(vertices);
+	createVertexBuffer(uploadBatch, vertices);
+	createIndexBuffer(uploadBatch, indices);
 
 	m_model.model	 = glm::mat4(1.0f);
 	m_texID = newTexID;
 }
 
-void Mesh::createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices)
+void Mesh::createVertexBuffer(UploadBatch& uploadBatch, const Vertex* vertices)
 {
-	VkDeviceSize bufferSize = sizeof(Vertex) * vertices->size();
-
-	VkBuffer staging_buffer;
-	VkDeviceMemory staging_buffer_memory;
-
-	BufferSettings buffer_settings;
-	buffer_settings.size = bufferSize;
-	buffer_settings.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	buffer_settings.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-	// Creazione dello Staging Buffer, la cui memoria  accedibile attraverso la CPU (buffer pi lento)
-	// e verranno bypassate tutte le operazioni di caching standard.
-	// Il tipo del buffer  VK_BUFFER_USAGE_TRANSFER_SRC_BIT, significa che serve per effettuare un traferimento
-	// dei dati all'interno del buffer verso un altra locazione.
-	Utility::CreateBuffer(buffer_settings, &staging_buffer, &staging_buffer_memory);
-
-	//  Mapping della memoria sul Vertex Buffer
-	void* data;																	 // 1. Creazione di un puntatore ad una locazione della memoria normale
-	vkMapMemory(m_MainDevice.LogicalDevice, staging_buffer_memory, 0, bufferSize, 0, &data);  // 2. mapping tra la memoria del Vertex Buffer ed il pointer lato host
-	memcpy(data, vertices->data(), static_cast<size_t>(bufferSize));			 // 3. Copio i Vertex Data nel buffer della GPU
-	vkUnmapMemory(m_MainDevice.LogicalDevice, staging_buffer_memory);						 // 4. Disassocio il vertice dalla memoria
-
-	// Creazione di un buffer accessibile solo dalla GPU (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT).
-	// Il buffer  sia un buffer VK_BUFFER_USAGE_TRANSFER_DST_BIT
-	// ovvero che  creato per ricevere dei dati da un altra locazione di memoria (lo staging buffer), ma  anche
-	// VK_BUFFER_USAGE_VERTEX_BUFFER_BIT ovvero un buffer per i Vertex Data.
-	
-	buffer_settings.usage		= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-	buffer_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-	Utility::CreateBuffer(buffer_settings, &m_vertexBuffer, &m_vertexBufferMemory);
-
-	// Copia lo staging buffer nel vertex buffer della GPU,  un operazione che viene effettuata attraverso
-	// i CommandBuffer. Ovvero che  veloce perch viene eseguita dalla GPU.
-	Utility::CopyBufferCmd(staging_buffer, m_vertexBuffer, bufferSize);
-	
-	vkDestroyBuffer(m_MainDevice.LogicalDevice, staging_buffer, nullptr);
-	vkFreeMemory(m_MainDevice.LogicalDevice, staging_buffer_memory, nullptr);
+	if (m_vertexCount == 0)
+		return;
+
+	const GeometryArena* arena	= GeometryArena::GetInstance();
+	const VkDeviceSize stride	= arena->GetVertexStride();
+	const VkDeviceSize bufferSize = stride * static_cast<VkDeviceSize>(m_vertexCount);
+	const VkDeviceSize dstOffset  = stride * static_cast<VkDeviceSize>(m_geometry.FirstVertex);
+
+	// I vertici vanno nel range della mesh all'interno del vertex buffer condiviso (device local).
+	// Lo staging buffer e la copia vengono registrati nel batch: la GPU esegue tutte le copie
+	// con una sola submit, il range  utilizzabile dopo UploadBatch::Wait()
+	if (arena->GetVertexFormat() != VertexFormat::Packed)
+	{
+		uploadBatch.CopyToBuffer(vertices, bufferSize, getVertexBuffer(), dstOffset);
+		return;
+	}
+
+	// Quantizzazione sulla CPU, una volta per mesh: shader.vert decomprime con offset e scale della DrawInstance
+	const glm::vec3 offset	  = glm::vec3(m_positionOffset);
+	const glm::vec3 inv_scale = glm::vec3(
+		m_positionScale.x > 0.0f ? 1.0f / m_positionScale.x : 0.0f,
+		m_positionScale.y > 0.0f ? 1.0f / m_positionScale.y : 0.0f,
+		m_positionScale.z > 0.0f ? 1.0f / m_positionScale.z : 0.0f);
+
+	std::vector<PackedVertex> packed(static_cast<size_t>(m_vertexCount));
+
+	for (int i = 0; i < m_vertexCount; ++i)
+		packed[i] = PackVertex(vertices[i], offset, inv_scale);
+
+	uploadBatch.CopyToBuffer(packed.data(), bufferSize, getVertexBuffer(), dstOffset);
 }
 
-void Mesh::createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices)
+void Mesh::createIndexBuffer(UploadBatch& uploadBatch, const uint32_t* indices)
 {
-	VkDeviceSize bufferSize = sizeof(uint32_t) * indices->size();
-
-	VkBuffer staging_buffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	BufferSettings buffer_settings;
-	buffer_settings.size = bufferSize;
-	buffer_settings.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	buffer_settings.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	if (m_indexCount == 0)
+		return;
 
-	Utility::CreateBuffer(buffer_settings, &staging_buffer, &stagingBufferMemory);
+	VkDeviceSize bufferSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(m_indexCount);
 
-	// Mapping della memoria per l'index buffer
-	void* data;
-	vkMapMemory(m_MainDevice.LogicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);  // 2. Creao le associazioni (mapping) tra la memoria del vertex buffer ed il pointer
-	memcpy(data, indices->data(), static_cast<size_t>(bufferSize));							// 3. Copio il vettore dei vertici in un punto in memoria
-	vkUnmapMemory(m_MainDevice.LogicalDevice, stagingBufferMemory);							// 4. Disassocio il vertice dalla memoria
-
-	buffer_settings.usage		= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-	buffer_settings.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-	// Creazione del buffer per Index Data sulla GPU
-	Utility::CreateBuffer(buffer_settings, &m_indexBuffer, &m_indexBufferMemory);
-
-	// Copia dello staging buffer sulla GPU
-	Utility::CopyBufferCmd(staging_buffer, m_indexBuffer, bufferSize);
+	// Gli indici restano relativi alla mesh: firstIndex e vertexOffset delle draw li spostano nel suo range.
+	// Copia dei dati tramite staging buffer (registrata nel batch)
+	uploadBatch.CopyToBuffer(indices, bufferSize, getIndexBuffer(), sizeof(uint32_t) * static_cast<VkDeviceSize>(m_geometry.FirstIndex));
+}
 
-	// Distruzione dello staging Buffer
-	vkDestroyBuffer(m_MainDevice.LogicalDevice, staging_buffer, nullptr);
-	vkFreeMemory(m_MainDevice.LogicalDevice, stagingBufferMemory, nullptr);
+// Sfera centrata nell'AABB dei vertici: non minima, ma calcolata in due passate all'import.
+// Con VertexFormat::Packed anche l'AABB resta nella mesh, per la dequantizzazione delle posizioni
+void Mesh::computeBounds(const Vertex* vertices)
+{
+	m_positionOffset = glm::vec4(0.0f);
+	m_positionScale  = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+
+	if (m_vertexCount == 0)
+	{
+		m_boundingSphere = glm::vec4(0.0f);
+		return;
+	}
+
+	glm::vec3 min_pos = vertices[0].pos;
+	glm::vec3 max_pos = vertices[0].pos;
+
+	for (int i = 1; i < m_vertexCount; ++i)
+	{
+		min_pos = glm::min(min_pos, vertices[i].pos);
+		max_pos = glm::max(max_pos, vertices[i].pos);
+	}
+
+	const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+	float radius2 = 0.0f;
+
+	for (int i = 0; i < m_vertexCount; ++i)
+	{
+		const glm::vec3 d = vertices[i].pos - center;
+		radius2 = std::max(radius2, glm::dot(d, d));
+	}
+
+	m_boundingSphere = glm::vec4(center, std::sqrt(radius2));
+
+	if (GeometryArena::GetInstance()->GetVertexFormat() == VertexFormat::Packed)
+	{
+		m_positionOffset = glm::vec4(center, 0.0f);
+		m_positionScale  = glm::vec4((max_pos - min_pos) * 0.5f, 0.0f);
+	}
 }
 
 int Mesh::getVertexCount()
@@ -103,16 +169,13 @@ int Mesh::getVertexCount()
 
 VkBuffer Mesh::getVertexBuffer()
 {
-	return m_vertexBuffer;
+	return GeometryArena::GetInstance()->GetVertexBuffer(m_geometry.Block);
 }
 
+// Restituisce il range all'arena: le altre mesh del blocco restano dove sono
 void Mesh::destroyBuffers()
 {
-	vkDestroyBuffer(m_MainDevice.LogicalDevice, m_vertexBuffer, nullptr);
-	vkFreeMemory(m_MainDevice.LogicalDevice, m_vertexBufferMemory, nullptr);
-
-	vkDestroyBuffer(m_MainDevice.LogicalDevice, m_indexBuffer, nullptr);
-	vkFreeMemory(m_MainDevice.LogicalDevice, m_indexBufferMemory, nullptr);
+	GeometryArena::GetInstance()->Free(m_geometry);
 }
 
 int Mesh::getIndexCount()
@@ -122,7 +185,7 @@ int Mesh::getIndexCount()
 
 VkBuffer Mesh::getIndexBuffer()
 {
-	return m_indexBuffer;
+	return GeometryArena::GetInstance()->GetIndexBuffer(m_geometry.Block);
 }
 
 void Mesh::setModel(glm::mat4 newModel)
@@ -1,12 +1,14 @@
 #pragma once
 
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include <vulkan/vulkan.h>
 
 #include <vector>
 
 #include "Utilities.h"
+#include "UploadBatch.h"
+#include "GeometryArena.h"
 
+// Per-object data of the G-buffer pass, one element per MeshModel in the object buffer (std430)
 struct Model {
 	glm::mat4 model;
 };
@@ -17,20 +19,29 @@ public:
 	Mesh()  = default;
 	~Mesh() = default;
 	Mesh(MainDevice &m_MainDevice,
-		 VkQueue transferQueue, 
-		 VkCommandPool transferCommandPool, 
+		 UploadBatch& uploadBatch,
 		 std::vector<Vertex>* vertices,
 		 std::vector<uint32_t>* indices,
 		 int newTexID);
+	Mesh(MainDevice &m_MainDevice,
+		 UploadBatch& uploadBatch,
+		 const Vertex* vertices, uint32_t vertexCount,
+		 const uint32_t* indices, uint32_t indexCount,
+		 int newTexID);
 
 	int		 getVertexCount();
 	VkBuffer getVertexBuffer();
+	uint32_t getFirstVertex() const { return m_geometry.FirstVertex; }
 	void	 destroyBuffers();
 
 	int		 getIndexCount();
 	VkBuffer getIndexBuffer();
+	uint32_t getFirstIndex() const { return m_geometry.FirstIndex; }
 
 	int		 getTexID() const;
+	const glm::vec4& getBoundingSphere() const { return m_boundingSphere; }
+	const glm::vec4& getPositionOffset() const { return m_positionOffset; }
+	const glm::vec4& getPositionScale() const { return m_positionScale; }
 
 	void setModel(glm::mat4 newModel);
 	Model getModel();
@@ -40,19 +51,18 @@ private:
 	MainDevice		 m_MainDevice;
 	Model m_model;
 	int m_texID;
+	glm::vec4 m_boundingSphere;	// Centro (xyz) e raggio (w) in object space, per il culling su GPU
+	glm::vec4 m_positionOffset;	// Centro e meta' dell'AABB: posizione = offset + scale * snorm con VertexFormat::Packed
+	glm::vec4 m_positionScale;	// (0, 1 con VertexFormat::Full)
 
-	/* Vertex Data */
+	/* Vertex and Index Data, ranges of the GeometryArena buffers */
 	int				 m_vertexCount;
-	VkBuffer		 m_vertexBuffer;
-	VkDeviceMemory	 m_vertexBufferMemory;
-
-	/* Index Data */
 	int				 m_indexCount;
-	VkBuffer		 m_indexBuffer;
-	VkDeviceMemory   m_indexBufferMemory;
+	GeometryRange	 m_geometry;
 
 private:
-	void createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices);
-	void createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices);
+	void createVertexBuffer(UploadBatch& uploadBatch, const Vertex* vertices);
+	void createIndexBuffer(UploadBatch& uploadBatch, const uint32_t* indices);
+	void computeBounds(const Vertex* vertices);
 };
 
@@ -0,0 +1,65 @@
+#include "pch.h"
+
+#include "CookedMesh.h"
+
+// Offline tool: converts the source models (.obj, .fbx, ...) into the cooked format read by the renderer.
+//	MeshCooker Models/Vivi_Final.obj Models/FloorTiledMarble.fbx
+//	MeshCooker --output Models/Custom.cooked Models/Custom.fbx
+
+void printUsage()
+{
+	std::cout << "MeshCooker [--force] [--output file] model [model ...]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+	std::string output;
+	bool force = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--output" && i + 1 < argc)	output = argv[++i];
+		else if (arg == "--force")				force = true;
+		else									inputs.push_back(arg);
+	}
+
+	// A custom output name only makes sense for a single model
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	int result = 0;
+
+	for (const auto& input : inputs)
+	{
+		const std::string cooked_file = output.empty() ? CookedMesh::GetCookedPath(input) : output;
+
+		if (!force && output.empty() && CookedMesh::IsUpToDate(input))
+		{
+			std::cout << input << ": up to date" << std::endl;
+			continue;
+		}
+
+		try
+		{
+			auto const cook_begin = std::chrono::high_resolution_clock::now();
+
+			CookedMesh::Cook(input, cooked_file);
+
+			const double cook_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cook_begin).count();
+			std::cout << input << " -> " << cooked_file << " (" << cook_ms << " ms)" << std::endl;
+		}
+		catch (std::runtime_error& e)
+		{
+			std::cerr << e.what() << std::endl;
+			result = EXIT_FAILURE;
+		}
+	}
+
+	return result;
+}
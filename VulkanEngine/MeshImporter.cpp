@@ -0,0 +1,114 @@
+#include "pch.h"
+
+#include "MeshImporter.h"
+
+#include <assimp/postprocess.h>
+
+// aiProcess_Triangulate tutti gli oggetti vengono rappresentati come triangoli
+// aiProcess_FlipUVs : inverte i texels in modo che possano funzionare con Vulkan
+// aiProcess_JoinIdenticalVertices : 
+const unsigned int MeshImporter::IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices;
+
+std::vector<std::string> MeshImporter::LoadMaterials(const aiScene* scene)
+{
+	// Creazione 1:1 lista di textures
+	std::vector<std::string>texture_list(scene->mNumMaterials);
+
+	// Copia del nome della texture (nel caso in cui esista)
+	for (size_t i = 0; i < scene->mNumMaterials; i++)
+	{
+		aiMaterial* material = scene->mMaterials[i];
+
+		texture_list[i] = "";
+
+
+		// Controllo l'esistenza di una texture diffusa (colore semplice)
+		if (material->GetTextureCount(aiTextureType_DIFFUSE))
+		{
+			// Prelevamento della path
+			aiString path;
+			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
+			{
+				// Eliminazione delle relative paths
+				size_t idx = std::string(path.data).rfind("\\");
+				std::string file_name = std::string(path.data).substr(idx + 1);
+				texture_list[i] = file_name;
+			}
+		}
+
+		// Se non è presente alcuna texture, utilizza miss.png
+		if (texture_list[i].empty())
+		{
+			texture_list[i] = "miss.png";
+		}
+
+	}
+	return texture_list;
+}
+
+void MeshImporter::CollectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+{
+	// Attraversa ogni mesh per ciascun nodo ed aggiungerla alla mesh list
+	for (size_t i = 0; i < node->mNumMeshes; i++)
+	{
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+	}
+
+	// Attraversa ad ogni nodo connesso a questo nodo
+	for (size_t i = 0; i < node->mNumChildren; i++)
+	{
+		CollectMeshes(node->mChildren[i], scene, meshes);
+	}
+}
+
+void MeshImporter::ConvertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	vertices.resize(mesh->mNumVertices);
+
+	// Attraversa ogni vertice e copia lungo i vertici
+	for (size_t i = 0; i < mesh->mNumVertices; i++)
+	{
+		// Impostazione della posizione
+		vertices[i].pos = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+
+		vertices[i].nrm = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
+
+		// Set tex coords
+		if (mesh->mTextureCoords[0])
+		{
+			vertices[i].tex = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+		}
+		else
+		{
+			vertices[i].tex = { 0.0f, 0.0f };
+		}
+
+		// Set color (not really used right now in code)
+		vertices[i].col = { 1.0f, 1.0f, 1.0f };
+	}
+
+	indices.clear();
+	indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+
+	for (size_t i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace& face = mesh->mFaces[i];
+
+		for (size_t j = 0; j < face.mNumIndices; j++)
+		{
+			indices.push_back(face.mIndices[j]);
+		}
+	}
+}
+
+void MeshImporter::ComputeBounds(const std::vector<Vertex>& vertices, glm::vec3& bounds_min, glm::vec3& bounds_max)
+{
+	bounds_min = glm::vec3(std::numeric_limits<float>::max());
+	bounds_max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	for (const auto& vertex : vertices)
+	{
+		bounds_min = glm::min(bounds_min, vertex.pos);
+		bounds_max = glm::max(bounds_max, vertex.pos);
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "pch.h"
+
+#include <assimp/scene.h>
+
+// Conversione CPU-only da Assimp ai dati del renderer (Vertex/indici/texture), condivisa
+// dal caricamento a runtime e dal MeshCooker: non tocca Vulkan.
+class MeshImporter
+{
+public:
+	static std::vector<std::string> LoadMaterials(const aiScene* scene);
+	static void CollectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes);
+	static void ConvertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	static void ComputeBounds(const std::vector<Vertex>& vertices, glm::vec3& bounds_min, glm::vec3& bounds_max);
+
+	static const unsigned int IMPORT_FLAGS;
+};
@@ -1,149 +1,109 @@
 #include "pch.h"
 #include "MeshModel.h"
 
-MeshModel::MeshModel(const std::vector<Mesh>& meshList)
+MeshModel::MeshModel(const MeshHandle& asset)
 {
-	m_MeshList = meshList;
-	m_Model = glm::mat4(1.0f);
+	m_Asset = asset;
+	m_Instances.push_back(Instance());
 }
 
 size_t MeshModel::GetMeshCount() const
 {
-	return m_MeshList.size();
+	return m_Asset ? m_Asset->Meshes.size() : 0;
 }
 
 Mesh* MeshModel::GetMesh(const size_t index)
 {
-	if (index >= m_MeshList.size())
+	if (index >= GetMeshCount())
 	{
 		throw std::runtime_error("Attempted to access invalid mesh index.");
 	}
 
-	return &m_MeshList[index];
+	return &m_Asset->Meshes[index];
 }
 
 glm::mat4 MeshModel::GetModel()
 {
-	return m_Model;
+	return m_Instances[0].Transform.Model;
 }
 
 void MeshModel::SetModel(const glm::mat4& model)
 {
-	m_Model = model;
+	m_Instances[0].Transform = ObjectBuffer::MakeObjectData(model);
 }
 
-void MeshModel::DestroyMeshModel()
+uint32_t MeshModel::AddInstance(const glm::mat4& model)
 {
-	for (auto& mesh : m_MeshList)
+	Instance instance;
+	instance.Transform = ObjectBuffer::MakeObjectData(model);
+
+	m_Instances.push_back(instance);
+
+	return static_cast<uint32_t>(m_Instances.size() - 1);
+}
+
+void MeshModel::SetInstance(uint32_t instance, const glm::mat4& model)
+{
+	if (instance >= m_Instances.size())
 	{
-		mesh.destroyBuffers();
+		throw std::runtime_error("Attempted to access invalid instance index.");
 	}
+
+	m_Instances[instance].Transform = ObjectBuffer::MakeObjectData(model);
 }
 
-std::vector<std::string> MeshModel::LoadMaterials(const aiScene* scene)
+uint32_t MeshModel::GetInstanceCount() const
 {
-	// Creazione 1:1 lista di textures
-	std::vector<std::string>texture_list(scene->mNumMaterials);
+	return static_cast<uint32_t>(m_Instances.size());
+}
 
-	// Copia del nome della texture (nel caso in cui esista)
-	for (size_t i = 0; i < scene->mNumMaterials; i++)
-	{
-		aiMaterial* material = scene->mMaterials[i];
-
-		texture_list[i] = "";
-
-
-		// Controllo l'esistenza di una texture diffusa (colore semplice)
-		if (material->GetTextureCount(aiTextureType_DIFFUSE))
-		{
-			// Prelevamento della path
-			aiString path;
-			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
-			{
-				// Eliminazione delle relative paths
-				size_t idx = std::string(path.data).rfind("\\");
-				std::string file_name = std::string(path.data).substr(idx + 1);
-				texture_list[i] = file_name;
-			}
-		}
-
-		// Se non  presente alcuna texture, utilizza miss.png
-		if (texture_list[i].empty())
-		{
-			texture_list[i] = "miss.png";
-		}
+const ObjectData& MeshModel::GetObjectData(uint32_t instance) const
+{
+	return m_Instances[instance].Transform;
+}
 
-	}
-	return texture_list;
+uint32_t MeshModel::GetObjectID(uint32_t instance) const
+{
+	return m_Instances[instance].ObjectID;
 }
 
-std::vector<Mesh> MeshModel::LoadNode(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, 
-	VkQueue transferQueue, VkCommandPool transferCommandPool, aiNode* node, const aiScene* scene, std::vector<int> matToTex)
+void MeshModel::SetObjectID(uint32_t instance, uint32_t object_id)
 {
-	std::vector<Mesh> mesh_list;
+	m_Instances[instance].ObjectID = object_id;
+}
 
-	// Attraversa ogni mesh per ciascun nodo ed aggiungerla alla mesh list
-	for (size_t i = 0; i < node->mNumMeshes; i++)
-	{
-		// Caricamento della mesh
-		mesh_list.push_back(LoadMesh(newPhysicalDevice, newDevice, transferQueue, transferCommandPool,
-			scene->mMeshes[i], scene, matToTex));
-	}
+void MeshModel::DestroyMeshModel()
+{
+	// I buffer vengono distrutti dall'ultimo MeshModel che rilascia l'asset
+	m_Asset.reset();
+}
 
-	// Attraversa ad ogni nodo connesso a questo nodo e caricalo, dopo dich append la relativa mesh alla lista.
+std::vector<Mesh> MeshModel::LoadNode(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, 
+	UploadBatch& uploadBatch, aiNode* node, const aiScene* scene, std::vector<int> matToTex)
+{
+	std::vector<const aiMesh*> scene_meshes;
+	MeshImporter::CollectMeshes(node, scene, scene_meshes);
 
-	for (size_t i = 0; i < node->mNumChildren; i++)
-	{
-		std::vector<Mesh> new_list = LoadNode(newPhysicalDevice, newDevice, transferQueue, transferCommandPool, 
-			node->mChildren[i], scene, matToTex);
+	std::vector<Mesh> mesh_list;
 
-		mesh_list.insert(mesh_list.end(), new_list.begin(), new_list.end());
+	// Caricamento di ogni mesh del nodo e dei suoi figli
+	for (const aiMesh* mesh : scene_meshes)
+	{
+		mesh_list.push_back(LoadMesh(newPhysicalDevice, newDevice, uploadBatch, mesh, scene, matToTex));
 	}
 
 	return mesh_list;
 }
 
-Mesh MeshModel::LoadMesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue transferQueue, 
-	VkCommandPool transferCommandPool, aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex)
+Mesh MeshModel::LoadMesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, UploadBatch& uploadBatch,
+	const aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex)
 {
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 
-	vertices.resize(mesh->mNumVertices);
-
-	// Attraversa ogni vertice e copia lungo i vertici
-	for (size_t i = 0; i < mesh->mNumVertices; i++)
-	{
-		// Impostazione della posizione
-		vertices[i].pos = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
-
-		vertices[i].nrm = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
-
-		// Set tex coords
-		if (mesh->mTextureCoords[0])
-		{
-			vertices[i].tex = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
-		}
-		else
-		{
-			vertices[i].tex = { 0.0f, 0.0f };
-		}
-
-		// Set color (not really used right now in code)
-		vertices[i].col = { 1.0f, 1.0f, 1.0f };
-	}
-
-	for (size_t i = 0; i < mesh->mNumFaces; i++)
-	{
-		aiFace face = mesh->mFaces[i];
-
-		for (size_t j = 0; j < face.mNumIndices; j++)
-		{
-			indices.push_back(face.mIndices[j]);
-		}
-	}
+	MeshImporter::ConvertMesh(mesh, vertices, indices);
 
 	MainDevice m = {newPhysicalDevice, newDevice};
 
-	return Mesh(m, transferQueue, transferCommandPool, &vertices, &indices, matToTex[mesh->mMaterialIndex]);
-}
\ No newline at end of file
+	return Mesh(m, uploadBatch, &vertices, &indices, matToTex[mesh->mMaterialIndex]);
+}
@@ -3,6 +3,9 @@
 #include "pch.h"
 
 #include "Mesh.h"
+#include "AssetCache.h"
+#include "MeshImporter.h"
+#include "ObjectBuffer.h"
 
 #include <assimp/scene.h>
 
@@ -10,23 +13,34 @@ class MeshModel
 {
 public:
 	MeshModel() = default;
-	MeshModel(const std::vector<Mesh>& meshList);
+	MeshModel(const MeshHandle& asset);
 	~MeshModel() = default;
 
 	size_t GetMeshCount() const;
 	Mesh* GetMesh(const size_t index);
-	glm::mat4 GetModel();
+	glm::mat4 GetModel();						// Transform of the first instance
 	void SetModel(const glm::mat4& model);
+	uint32_t AddInstance(const glm::mat4& model);
+	void SetInstance(uint32_t instance, const glm::mat4& model);
+	uint32_t GetInstanceCount() const;
+	const ObjectData& GetObjectData(uint32_t instance) const;
+	uint32_t GetObjectID(uint32_t instance) const;
+	void SetObjectID(uint32_t instance, uint32_t object_id);
 	void DestroyMeshModel();
 
-	static std::vector<std::string> LoadMaterials(const aiScene *scene);
-	static std::vector<Mesh> LoadNode(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue transferQueue, VkCommandPool transferCommandPool,
+	static std::vector<Mesh> LoadNode(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, UploadBatch& uploadBatch,
 		aiNode* node, const aiScene* scene, std::vector<int> matToTex);
-	static Mesh LoadMesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkQueue transferQueue, VkCommandPool transferCommandPool,
-		aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex);
+	static Mesh LoadMesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, UploadBatch& uploadBatch,
+		const aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex);
 
 private:
-	std::vector<Mesh> m_MeshList;
-	glm::mat4 m_Model;
+	// Copia disegnata del modello: trasformazione (con la normal matrix, ricalcolata solo quando cambia) e slot nell'object buffer
+	struct Instance {
+		ObjectData	Transform;
+		uint32_t	ObjectID = UINT32_MAX;
+	};
+
+	MeshHandle m_Asset;		// Shared with every other placement of the same file
+	std::vector<Instance> m_Instances;	// Un elemento per copia disegnata: tutte con una draw instanced per mesh
 };
 
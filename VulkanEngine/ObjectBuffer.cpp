@@ -0,0 +1,59 @@
+#include "pch.h"
+
+#include "ObjectBuffer.h"
+
+ObjectBuffer::ObjectBuffer()
+{
+	m_Version = 0;
+}
+
+ObjectBuffer::ObjectBuffer(MainDevice* main_device) : ObjectBuffer()
+{
+	m_Storage = FrameSlicedBuffer(main_device, 0, sizeof(ObjectData), "object");
+}
+
+ObjectData ObjectBuffer::MakeObjectData(const glm::mat4& model)
+{
+	ObjectData object;
+	object.Model	= model;
+	object.Normal	= glm::mat3x4(glm::transpose(glm::inverse(glm::mat3(model))));
+
+	return object;
+}
+
+void ObjectBuffer::CreateBuffer()
+{
+	m_Storage.CreateBuffer(std::max(OBJECT_BUFFER_INITIAL_CAPACITY, GetCount()));
+}
+
+bool ObjectBuffer::BeginFrame(uint32_t frame)
+{
+	const bool recreated = m_Storage.BeginFrame(frame, GetCount());
+	m_Storage.UploadDirty(m_Objects.data(), GetCount());
+
+	return recreated;
+}
+
+void ObjectBuffer::DestroyBuffer()
+{
+	m_Storage.DestroyBuffer();
+}
+
+uint32_t ObjectBuffer::Add(const ObjectData& object)
+{
+	m_Objects.push_back(object);
+	m_Storage.MarkDirty(GetCount() - 1);
+	++m_Version;
+
+	return GetCount() - 1;
+}
+
+void ObjectBuffer::Update(uint32_t object_id, const ObjectData& object)
+{
+	if (object_id >= GetCount())
+		return;
+
+	m_Objects[object_id] = object;
+	m_Storage.MarkDirty(object_id);
+	++m_Version;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pch.h"
+
+#include "FrameSlicedBuffer.h"
+
+constexpr uint32_t OBJECT_BUFFER_INITIAL_CAPACITY = 1024;	// Objects, the buffer doubles when it is full
+
+// Transform of a drawn object (std430): the normal matrix is computed on the CPU when the object moves,
+// the vertex shader no longer inverts the model matrix for every vertex
+struct ObjectData {
+	glm::mat4	Model		= glm::mat4(1.0f);
+	glm::mat3x4	Normal		= glm::mat3x4(1.0f);	// transpose(inverse(mat3(Model))), a std430 mat3 has vec4 columns
+};
+
+static_assert(sizeof(ObjectData) == 112, "ObjectData must match the std430 struct of shader.vert and cull.comp");
+
+// Transforms of every model instance, addressed by object ID and stored in a host visible storage buffer
+// read by the G-buffer vertex shader and by the culling shader (through the draw instances of the DrawList).
+// Like the light buffer it is a FrameSlicedBuffer: one slice per frame in flight, only the objects changed since
+// the last write of a slice are copied. Objects are never removed, so an ID stays valid for the whole session.
+class ObjectBuffer
+{
+public:
+	ObjectBuffer();
+	ObjectBuffer(MainDevice* main_device);
+
+	static ObjectData MakeObjectData(const glm::mat4& model);
+
+	void CreateBuffer();
+	bool BeginFrame(uint32_t frame);	// Uploads the dirty objects of the frame slice, true if the buffer was recreated
+	void DestroyBuffer();
+
+	uint32_t Add(const ObjectData& object);
+	void Update(uint32_t object_id, const ObjectData& object);
+
+	uint32_t GetCount() const						{ return static_cast<uint32_t>(m_Objects.size()); }
+	uint64_t GetVersion() const						{ return m_Version; }		// Changes with every Add and Update
+	const ObjectData& Get(uint32_t object_id) const	{ return m_Objects[object_id]; }
+
+	VkBuffer& GetBuffer()							{ return m_Storage.GetBuffer(); }
+	VkDeviceSize GetSliceSize() const				{ return m_Storage.GetSliceSize(); }		// Range of the descriptor
+	uint32_t GetFrameOffset() const					{ return m_Storage.GetFrameOffset(); }
+	VkDeviceSize GetLastUploadSize() const			{ return m_Storage.GetLastUploadSize(); }
+
+private:
+	FrameSlicedBuffer			m_Storage;
+	std::vector<ObjectData>		m_Objects;			// Indexed by object ID
+	uint64_t					m_Version;
+};
@@ -20,37 +20,30 @@ void RenderPassHandler::CreateOffScreenRenderPass()
 
 	VkFormat image_format = m_SwapChainHandler->GetSwapChainImageFormat();
 	
-	// SUBPASS 1 - INPUT ATTACHMENTS
-	VkAttachmentDescription input_position_attachment	= InputPositionAttachment(image_format);
+	// SUBPASS 1 - G-BUFFER (albedo, normali ottaedriche, depth campionata dal lighting pass)
 	VkAttachmentDescription input_color_attachment		= InputColourAttachment(image_format);
-	VkAttachmentDescription input_normal_attachment		= InputPositionAttachment(image_format);
-	VkAttachmentDescription input_depth_attachment		= InputDepthAttachment();
-
-	// Input-Position Attachment Reference
-	VkAttachmentReference position_attach_ref = {};
-	position_attach_ref.attachment	= 0;
-	position_attach_ref.layout		= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	VkAttachmentDescription input_normal_attachment		= InputNormalAttachment();
+	VkAttachmentDescription input_depth_attachment		= GBufferDepthAttachment();
 
 	// Input-Colour Attachment Reference
 	VkAttachmentReference color_attach_ref = {};
-	color_attach_ref.attachment		= 1;
+	color_attach_ref.attachment		= 0;
 	color_attach_ref.layout			= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	// Input-Normal Attachment Reference
 	VkAttachmentReference normal_attach_ref = {};
-	normal_attach_ref.attachment	= 2;
+	normal_attach_ref.attachment	= 1;
 	normal_attach_ref.layout		= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-	std::array<VkAttachmentReference, 3> attach_refs
+	std::array<VkAttachmentReference, 2> attach_refs
 	{
-		position_attach_ref,
 		color_attach_ref,
 		normal_attach_ref
 	};
 
 	// Input-Depth Attachment Reference
 	VkAttachmentReference depth_attach_ref = {};
-	depth_attach_ref.attachment		= 3;
+	depth_attach_ref.attachment		= 2;
 	depth_attach_ref.layout			= VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	subpasses[0].pipelineBindPoint			= VK_PIPELINE_BIND_POINT_GRAPHICS;
@@ -60,10 +53,17 @@ void RenderPassHandler::CreateOffScreenRenderPass()
 
 	std::array<VkSubpassDependency, 2> subpass_dep = SetSubpassDependencies();
 
+	// La depth viene scritta dai test sui fragment e letta dal lighting pass (fragment shader o compute del tiled lighting)
+	subpass_dep[0].dstStageMask		|= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpass_dep[0].dstAccessMask	|= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpass_dep[1].srcStageMask		|= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpass_dep[1].srcAccessMask	|= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpass_dep[1].dstStageMask		= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	subpass_dep[1].dstAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+
 	// SUBPASS DEPENDENCIES
-	std::array<VkAttachmentDescription, 4> renderPassAttachments = 
+	std::array<VkAttachmentDescription, 3> renderPassAttachments = 
 	{
-		input_position_attachment, 
 		input_color_attachment, 
 		input_normal_attachment, 
 		input_depth_attachment 
@@ -155,6 +155,10 @@ VkAttachmentDescription RenderPassHandler::SwapchainColourAttachment(const VkFor
 	colour_attachment.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;			
 	colour_attachment.finalLayout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;		
 
+	// Headless: l'immagine non viene presentata ma eventualmente copiata verso l'host
+	if (m_SwapChainHandler->IsHeadless())
+		colour_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
 	return colour_attachment;
 }
 
@@ -162,10 +166,7 @@ VkAttachmentDescription RenderPassHandler::InputColourAttachment(const VkFormat&
 {
 	VkAttachmentDescription color_attachment_input = {};
 
-	color_attachment_input.format = Utility::ChooseSupportedFormat( 
-		{ VK_FORMAT_R32G32B32A32_SFLOAT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	color_attachment_input.format = Utility::ChooseAlbedoBufferFormat();
 
 	color_attachment_input.samples			= VK_SAMPLE_COUNT_1_BIT;
 	color_attachment_input.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
@@ -178,24 +179,36 @@ VkAttachmentDescription RenderPassHandler::InputColourAttachment(const VkFormat&
 	return color_attachment_input;
 }
 
-VkAttachmentDescription RenderPassHandler::InputPositionAttachment(const VkFormat& imageFormat)
+VkAttachmentDescription RenderPassHandler::InputNormalAttachment()
 {
-	VkAttachmentDescription color_attachment_input = {};
+	VkAttachmentDescription normal_attachment_input = {};
+
+	normal_attachment_input.format			= Utility::ChooseNormalBufferFormat();
+	normal_attachment_input.samples			= VK_SAMPLE_COUNT_1_BIT;
+	normal_attachment_input.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	normal_attachment_input.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
+	normal_attachment_input.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	normal_attachment_input.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	normal_attachment_input.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
+	normal_attachment_input.finalLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	return normal_attachment_input;
+}
 
-	color_attachment_input.format = Utility::ChooseSupportedFormat(
-		{ VK_FORMAT_R32G32B32A32_SFLOAT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+VkAttachmentDescription RenderPassHandler::GBufferDepthAttachment()
+{
+	VkAttachmentDescription depth_attachment_desc = {};
 
-	color_attachment_input.samples			= VK_SAMPLE_COUNT_1_BIT;
-	color_attachment_input.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
-	color_attachment_input.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
-	color_attachment_input.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	color_attachment_input.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	color_attachment_input.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment_input.finalLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	depth_attachment_desc.format			= Utility::ChooseGBufferDepthFormat();
+	depth_attachment_desc.samples			= VK_SAMPLE_COUNT_1_BIT;
+	depth_attachment_desc.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth_attachment_desc.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;		// Serve al lighting pass per ricostruire la posizione
+	depth_attachment_desc.stencilLoadOp		= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depth_attachment_desc.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment_desc.initialLayout		= VK_IMAGE_LAYOUT_UNDEFINED;
+	depth_attachment_desc.finalLayout		= VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
-	return color_attachment_input;
+	return depth_attachment_desc;
 }
 
 VkAttachmentDescription RenderPassHandler::InputDepthAttachment()
@@ -19,9 +19,10 @@ public:
 	void CreateOffScreenRenderPass();
 	void CreateRenderPass();
 	VkAttachmentDescription SwapchainColourAttachment(const VkFormat& imageFormat);
-	VkAttachmentDescription InputPositionAttachment(const VkFormat& imageFormat);
 	VkAttachmentDescription InputColourAttachment(const VkFormat& imageFormat);
+	VkAttachmentDescription InputNormalAttachment();
 	VkAttachmentDescription InputDepthAttachment();
+	VkAttachmentDescription GBufferDepthAttachment();
 
 	//void SetSubpassDescription();
 	std::array<VkSubpassDependency, 2> SetSubpassDependencies();
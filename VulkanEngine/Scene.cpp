@@ -18,7 +18,7 @@ void Scene::PassRenderData(const VulkanRenderData& render_data)
 	m_RenderData = render_data;
 }
 
-void Scene::LoadScene(std::vector<Mesh> &meshList, TextureObjects &textureObjects)
+void Scene::LoadScene(std::vector<Mesh> &meshList, TextureObjects &textureObjects, UploadBatch& uploadBatch)
 {
 	std::vector<Vertex> meshVertices =
 	{
@@ -40,21 +40,18 @@ void Scene::LoadScene(std::vector<Mesh> &meshList, TextureObjects &textureObject
 		2, 3, 0
 	};
 
-	int giraffeTexture = TextureLoader::GetInstance()->CreateTexture("giraffe.jpg");
+	int giraffeTexture = TextureLoader::GetInstance()->CreateTexture("giraffe.jpg", uploadBatch);
 
 	meshList.push_back(Mesh(
-		m_RenderData.main_device,
-		m_RenderData.graphic_queue, m_RenderData.command_pool,
+		m_RenderData.main_device, uploadBatch,
 		&meshVertices, &meshIndices, giraffeTexture));
 
 	meshList.push_back(Mesh(
-		m_RenderData.main_device,
-		m_RenderData.graphic_queue, m_RenderData.command_pool,
+		m_RenderData.main_device, uploadBatch,
 		&meshVertices2, &meshIndices, giraffeTexture));
 
 	Cube cube;
-	meshList.push_back(Mesh(m_RenderData.main_device,
-		m_RenderData.graphic_queue, m_RenderData.command_pool,
+	meshList.push_back(Mesh(m_RenderData.main_device, uploadBatch,
 		&cube.GetVertexData(), &cube.GetIndexData(), NULL));
 
 	glm::mat4 meshModelMatrix = meshList[0].getModel().model;
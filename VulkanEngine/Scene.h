@@ -15,7 +15,7 @@ public:
 
 	void PassRenderData(const VulkanRenderData& render_data);
 
-	void LoadScene(std::vector<Mesh> &mesh_list, TextureObjects& texture_objects);
+	void LoadScene(std::vector<Mesh> &mesh_list, TextureObjects& texture_objects, UploadBatch& upload_batch);
 
 private:
 	VulkanRenderData	m_RenderData;
@@ -0,0 +1,137 @@
+#version 450
+
+#extension GL_KHR_vulkan_glsl: enable
+
+#define CLUSTER_X 		16				// CLUSTER_DIM_X/Y/Z in Light.h
+#define CLUSTER_Y 		9
+#define CLUSTER_Z 		24
+#define LIGHT_CUTOFF 	(1.0 / 256.0)	// Attenuation below which a light does not contribute (invisible at 8 bit)
+
+struct Light {
+	vec3 	color;
+	float 	ambient_intensity;
+	vec3 	position;
+	float 	radius;
+};
+
+layout(set = 0, binding = 0) uniform sampler2D inputDepth;		// World position is rebuilt from the depth
+layout(set = 0, binding = 1) uniform sampler2D inputColour;
+layout(set = 0, binding = 2) uniform sampler2D inputNormal;		// Octahedral encoded normal
+
+// LightBufferHeader (16 byte) + LightData[count], same buffer of the tiled path
+layout(std430, set = 1, binding = 0) readonly buffer LightBuffer {
+	uint 	count;
+	Light 	l[];
+} light_buffer;
+
+// ClusterGridHeader + ClusterRange[CLUSTER_COUNT] + light indices, built on the CPU every frame
+layout(std430, set = 1, binding = 1) readonly buffer ClusterBuffer {
+	uvec4 	dims;			// x, y, z, index count
+	vec4 	depth_params;	// near, far, slice scale, slice bias
+	uvec2 	ranges[CLUSTER_X * CLUSTER_Y * CLUSTER_Z];	// offset, count
+	uint 	indices[];
+} clusters;
+
+layout(set = 2, binding = 0) uniform SettingsData {
+	int		render_target;
+} settings;
+
+layout(set = 3, binding = 0) uniform UboViewProjection {
+	mat4 projection;
+	mat4 view;
+	mat4 inv_view_projection;
+} ubo_vp;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 colour;
+
+vec3 DecodeNormal(vec2 f)
+{
+	vec3 n 	= vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x    += n.x >= 0.0 ? -t : t;
+	n.y    += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 ReconstructPosition(vec2 uv, float depth)
+{
+	// The fullscreen triangle UVs map 1:1 on the Vulkan NDC (y down, depth in [0, 1])
+	vec4 world = ubo_vp.inv_view_projection * vec4(uv * 2.0 - 1.0, depth, 1.0);
+	return world.xyz / world.w;
+}
+
+uint ClusterIndex(vec2 uv, float view_depth)
+{
+	uint x = min(uint(uv.x * CLUSTER_X), CLUSTER_X - 1);
+	uint y = min(uint(uv.y * CLUSTER_Y), CLUSTER_Y - 1);
+
+	// Exponential slices: slice = log(depth) * scale + bias (LightClusters::DepthSlice)
+	float slice = floor(log(max(view_depth, clusters.depth_params.x)) * clusters.depth_params.z + clusters.depth_params.w);
+	uint z 		= uint(clamp(slice, 0.0, float(CLUSTER_Z - 1)));
+
+	return (z * CLUSTER_Y + y) * CLUSTER_X + x;
+}
+
+void main()
+{
+	colour = vec4(0.0);
+	float depth 	= texture(inputDepth, inUV.xy).r;
+	bool background = depth >= 1.0;		// Cleared depth, no geometry: same zeros of the old cleared targets
+
+	vec3 fragPos 	= background ? vec3(0.0) : ReconstructPosition(inUV.xy, depth);
+	vec3 fragColour = texture(inputColour, inUV.xy).rgb;
+	vec3 fragNrm 	= background ? vec3(0.0) : DecodeNormal(texture(inputNormal, inUV.xy).rg);
+	gl_FragDepth 	= fragPos.z;
+
+	// Background pixels have no cluster, only the lights of their froxel are shaded otherwise
+	uvec2 range = uvec2(0);
+
+	if (!background)
+	{
+		float view_depth = -(ubo_vp.view * vec4(fragPos, 1.0)).z;
+		range 			 = clusters.ranges[ClusterIndex(inUV.xy, view_depth)];
+	}
+
+	vec3 N 		= normalize(fragNrm);
+	vec3 View 	= normalize(vec3(0.0, 0.0, 0.0) - fragPos);
+
+	for (uint i = 0; i < range.y; ++i)
+	{
+		Light light 		= light_buffer.l[clusters.indices[range.x + i]];
+		vec3 L 				= light.position.xyz - fragPos;
+
+		float distance 		= length(L);
+		// Windowed so that the light reaches exactly zero at the culling range
+		float attenuation 	= max(light.radius / (distance * distance + 1.0) - LIGHT_CUTOFF, 0.0);
+
+		L 				= normalize(L);
+
+		float dotNL 	= max(0.0, dot(N, L));
+		vec3 diffuse  	= light.color * fragColour * dotNL * attenuation;
+
+		vec3 R 			= reflect(-L, N);
+		float dotRV 	= max(0.0, dot(R, View));
+		vec3 specular 	= light.color * fragColour * pow(dotRV, 16.0) * attenuation;
+
+		colour.rgb 	   += diffuse + specular;
+	}
+	
+	switch(settings.render_target)
+	{
+	case 0:
+		colour = vec4(fragPos, 1.0); 
+		break;
+	case 1:
+		colour = vec4(fragNrm, 1.0); 
+		break;
+	case 2:
+		colour = vec4(fragColour, 1.0); 
+		break;
+	case 3:
+		break;
+	}
+
+	colour.a = 1.0;
+}
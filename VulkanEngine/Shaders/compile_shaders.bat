@@ -1,5 +1,16 @@
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader.vert
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o packed_vert.spv -V -DPACKED_VERTEX shader.vert
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o bindless_frag.spv -V -DBINDLESS shader.frag
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o second_vert.spv -V second_shader.vert
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o second_frag.spv -V second_shader.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o tiled_lighting_comp.spv -V tiled_lighting.comp
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o composite_frag.spv -V composite.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o clustered_frag.spv -V clustered_shader.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o depth_prime_frag.spv -V depth_prime.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o light_volume_vert.spv -V light_volume.vert
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o light_volume_frag.spv -V light_volume.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o hiz_build_comp.spv -V hiz_build.comp
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o cull_comp.spv -V cull.comp
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -o cull_instances_comp.spv -V -DCULL_INSTANCES cull.comp
 pause
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+
+// Output del tiled lighting (compute), stessa risoluzione della swapchain
+layout(set = 0, binding = 0) uniform sampler2D inputLighting;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 colour;
+
+void main()
+{
+	colour = vec4(texture(inputLighting, inUV.xy).rgb, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 450
+
+#extension GL_KHR_vulkan_glsl: enable
+
+layout(set = 0, binding = 0) uniform sampler2D inputDepth;
+
+layout(location = 0) in vec2 inUV;
+
+// Copies the G-buffer depth in the depth attachment of the lighting pass (light volumes only)
+void main()
+{
+	gl_FragDepth = texture(inputDepth, inUV.xy).r;
+}
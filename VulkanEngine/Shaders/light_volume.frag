@@ -0,0 +1,78 @@
+#version 450
+
+#extension GL_KHR_vulkan_glsl: enable
+
+#define LIGHT_CUTOFF 	(1.0 / 256.0)	// Attenuation below which a light does not contribute (invisible at 8 bit)
+
+struct Light {
+	vec3 	color;
+	float 	ambient_intensity;
+	vec3 	position;
+	float 	radius;
+};
+
+layout(set = 0, binding = 0) uniform sampler2D inputDepth;		// World position is rebuilt from the depth
+layout(set = 0, binding = 1) uniform sampler2D inputColour;
+layout(set = 0, binding = 2) uniform sampler2D inputNormal;		// Octahedral encoded normal
+
+layout(std430, set = 1, binding = 0) readonly buffer LightBuffer {
+	uint 	count;
+	Light 	l[];
+} light_buffer;
+
+layout(set = 3, binding = 0) uniform UboViewProjection {
+	mat4 projection;
+	mat4 view;
+	mat4 inv_view_projection;
+} ubo_vp;
+
+layout(location = 0) flat in uint inLight;
+
+layout(location = 0) out vec4 colour;
+
+vec3 DecodeNormal(vec2 f)
+{
+	vec3 n 	= vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x    += n.x >= 0.0 ? -t : t;
+	n.y    += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 ReconstructPosition(vec2 uv, float depth)
+{
+	vec4 world = ubo_vp.inv_view_projection * vec4(uv * 2.0 - 1.0, depth, 1.0);
+	return world.xyz / world.w;
+}
+
+void main()
+{
+	// The depth test already dropped the background and the surfaces behind the volume
+	ivec2 texel 	= ivec2(gl_FragCoord.xy);
+	vec2 uv 		= gl_FragCoord.xy / vec2(textureSize(inputDepth, 0));
+
+	vec3 fragPos 	= ReconstructPosition(uv, texelFetch(inputDepth, texel, 0).r);
+	Light light 	= light_buffer.l[inLight];
+	vec3 L 			= light.position.xyz - fragPos;
+
+	float distance 		= length(L);
+	float attenuation 	= max(light.radius / (distance * distance + 1.0) - LIGHT_CUTOFF, 0.0);
+
+	// Surfaces in front of the volume pass the depth test: they are out of range
+	if (attenuation <= 0.0)
+		discard;
+
+	vec3 fragColour = texelFetch(inputColour, texel, 0).rgb;
+	vec3 N 			= DecodeNormal(texelFetch(inputNormal, texel, 0).rg);
+	vec3 View 		= normalize(vec3(0.0, 0.0, 0.0) - fragPos);
+	L 				= normalize(L);
+
+	float dotNL 	= max(0.0, dot(N, L));
+	vec3 diffuse  	= light.color * fragColour * dotNL * attenuation;
+
+	vec3 R 			= reflect(-L, N);
+	float dotRV 	= max(0.0, dot(R, View));
+	vec3 specular 	= light.color * fragColour * pow(dotRV, 16.0) * attenuation;
+
+	colour = vec4(diffuse + specular, 1.0);
+}
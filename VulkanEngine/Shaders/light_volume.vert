@@ -0,0 +1,57 @@
+#version 450
+
+#extension GL_KHR_vulkan_glsl: enable
+
+#define SPHERE_SEGMENTS 	12				// LIGHT_VOLUME_SEGMENTS/RINGS in Light.h
+#define SPHERE_RINGS 		8
+#define LIGHT_CUTOFF 		(1.0 / 256.0)
+#define PI 					3.14159265359
+
+struct Light {
+	vec3 	color;
+	float 	ambient_intensity;
+	vec3 	position;
+	float 	radius;
+};
+
+// LightBufferHeader (16 byte) + LightData[count], same buffer of the tiled and clustered paths
+layout(std430, set = 1, binding = 0) readonly buffer LightBuffer {
+	uint 	count;
+	Light 	l[];
+} light_buffer;
+
+layout(set = 3, binding = 0) uniform UboViewProjection {
+	mat4 projection;
+	mat4 view;
+	mat4 inv_view_projection;
+} ubo_vp;
+
+layout(location = 0) flat out uint outLight;
+
+vec3 SpherePoint(uint ring, uint segment)
+{
+	float theta = PI * float(ring) / float(SPHERE_RINGS);
+	float phi 	= 2.0 * PI * float(segment) / float(SPHERE_SEGMENTS);
+	return vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+}
+
+void main()
+{
+	// Two counter-clockwise (seen from outside) triangles per quad of the UV sphere
+	const uvec2 corners[6] = uvec2[](uvec2(0, 0), uvec2(1, 1), uvec2(1, 0), uvec2(0, 0), uvec2(0, 1), uvec2(1, 1));
+
+	uint quad 		= uint(gl_VertexIndex) / 6;
+	uvec2 corner 	= corners[uint(gl_VertexIndex) % 6];
+	uint ring 		= quad / SPHERE_SEGMENTS + corner.x;
+	uint segment 	= quad % SPHERE_SEGMENTS + corner.y;
+
+	Light light = light_buffer.l[gl_InstanceIndex];
+
+	// The vertices lie on the sphere, the faces are pushed out so that the mesh contains it
+	float range 	= sqrt(max(light.radius / LIGHT_CUTOFF - 1.0, 0.0));
+	float scale 	= range / (cos(PI / float(SPHERE_SEGMENTS)) * cos(PI / float(2 * SPHERE_RINGS)));
+	vec3 world 		= light.position + SpherePoint(ring, segment) * scale;
+
+	outLight 		= uint(gl_InstanceIndex);
+	gl_Position 	= ubo_vp.projection * ubo_vp.view * vec4(world, 1.0);
+}
@@ -2,45 +2,70 @@
 
 #extension GL_KHR_vulkan_glsl: enable
 
-#define NUM_LIGHTS 20
-
-struct UboLight {
+struct Light {
 	vec3 	color;
 	float 	ambient_intensity;
 	vec3 	position;
 	float 	radius;
 };
 
-layout(set = 0, binding = 0) uniform sampler2D inputPosition;
+layout(set = 0, binding = 0) uniform sampler2D inputDepth;		// World position is rebuilt from the depth
 layout(set = 0, binding = 1) uniform sampler2D inputColour;
-layout(set = 0, binding = 2) uniform sampler2D inputNormal;
+layout(set = 0, binding = 2) uniform sampler2D inputNormal;		// Octahedral encoded normal
 
-layout(set = 1, binding = 0) uniform UboLights {
-	UboLight l[NUM_LIGHTS]; 
-} ubo_lights;
+// LightBufferHeader (16 byte) + LightData[count], the light count changes at runtime
+layout(std430, set = 1, binding = 0) readonly buffer LightBuffer {
+	uint 	count;
+	Light 	l[];
+} light_buffer;
 
 layout(set = 2, binding = 0) uniform SettingsData {
 	int		render_target;
 } settings;
 
+layout(set = 3, binding = 0) uniform UboViewProjection {
+	mat4 projection;
+	mat4 view;
+	mat4 inv_view_projection;
+} ubo_vp;
+
 layout(location = 0) in vec2 inUV;
 
 layout(location = 0) out vec4 colour;
 
+vec3 DecodeNormal(vec2 f)
+{
+	vec3 n 	= vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x    += n.x >= 0.0 ? -t : t;
+	n.y    += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 ReconstructPosition(vec2 uv, float depth)
+{
+	// The fullscreen triangle UVs map 1:1 on the Vulkan NDC (y down, depth in [0, 1])
+	vec4 world = ubo_vp.inv_view_projection * vec4(uv * 2.0 - 1.0, depth, 1.0);
+	return world.xyz / world.w;
+}
+
 void main()
 {
 	colour = vec4(0.0);
-	vec3 fragPos 	= texture(inputPosition, inUV.xy).rgb;
+	float depth 	= texture(inputDepth, inUV.xy).r;
+	bool background = depth >= 1.0;		// Cleared depth, no geometry: same zeros of the old cleared targets
+
+	vec3 fragPos 	= background ? vec3(0.0) : ReconstructPosition(inUV.xy, depth);
 	vec3 fragColour = texture(inputColour, inUV.xy).rgb;
-	vec3 fragNrm 	= texture(inputNormal, inUV.xy).rgb;
+	vec3 fragNrm 	= background ? vec3(0.0) : DecodeNormal(texture(inputNormal, inUV.xy).rg);
 	gl_FragDepth 	= fragPos.z;
 
-	for (int i = 0; i < NUM_LIGHTS; ++i)
+	for (uint i = 0; i < light_buffer.count; ++i)
 	{
-		vec3 L 				= ubo_lights.l[i].position.xyz - fragPos;
+		vec3 L 				= light_buffer.l[i].position.xyz - fragPos;
 
 		float distance 		= length(L);
-		float attenuation 	= ubo_lights.l[i].radius / (pow(distance, 2.0) + 1.0);
+		float attenuation 	= light_buffer.l[i].radius / (pow(distance, 2.0) + 1.0);
 
 		vec3 View 		= vec3(0.0, 0.0, 0.0) - fragPos;
 
@@ -50,11 +75,11 @@ void main()
 		View 			= normalize(View);
 
 		float dotNL 	= max(0.0, dot(N, L));
-		vec3 diffuse  	= ubo_lights.l[i].color * fragColour * dotNL * attenuation;
+		vec3 diffuse  	= light_buffer.l[i].color * fragColour * dotNL * attenuation;
 
 		vec3 R 			= reflect(-L, N);
 		float dotRV 	= max(0.0, dot(R, View));
-		vec3 specular 	= ubo_lights.l[i].color * fragColour * pow(dotRV, 16.0) ;		// * attenuation
+		vec3 specular 	= light_buffer.l[i].color * fragColour * pow(dotRV, 16.0) ;		// * attenuation
 
 		colour.rgb 	   += diffuse + specular;
 	}
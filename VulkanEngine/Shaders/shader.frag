@@ -1,20 +1,46 @@
 #version 450
 #extension GL_KHR_vulkan_glsl : enable
 
-layout(location = 0) in vec3 fragWorldPos;
+// Compiled twice: frag.spv binds one texture set per batch, bindless_frag.spv (-DBINDLESS) indexes
+// the array of every texture with the texture index of the draw instance
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 1) in vec3 fragCol;
 layout(location = 2) in vec3 fragNrm;
 layout(location = 3) in vec2 fragTex;
+layout(location = 4) flat in uint fragTexture;
 
+#ifdef BINDLESS
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+#else
 layout(set = 1, binding = 0) uniform sampler2D texture_sampler;
+#endif
+
+layout(location = 0) out vec4 outColour; // colour of the fragment (RGBA8 sRGB)
+layout(location = 1) out vec2 outNormal; // Normal, octahedral encoding (RG16)
 
-layout(location = 0) out vec4 outPos; 	 // World Position	
-layout(location = 1) out vec4 outColour; // colour of the fragment
-layout(location = 2) out vec4 outNormal; // Normal	
+// Octahedral encoding: the unit sphere is projected on the octahedron and unfolded on [-1, 1]^2
+vec2 OctWrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormal(vec3 n)
+{
+	n /= (abs(n.x) + abs(n.y) + abs(n.z));
+	n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+	return n.xy;
+}
 
 void main()
 {
-	outPos	 	= vec4(fragWorldPos, 1.0);
+#ifdef BINDLESS
+	// L'indice arriva da un input flat: per il compilatore non e' uniforme, senza nonuniformEXT l'accesso sarebbe undefined
+	outColour 	= vec4(texture(textures[nonuniformEXT(fragTexture)], fragTex).xyz, 1.0);
+#else
 	outColour 	= vec4(texture(texture_sampler, fragTex).xyz, 1.0);
-	outNormal 	= vec4(fragNrm, 1.0);
+#endif
+	outNormal 	= EncodeNormal(normalize(fragNrm));
 }
@@ -1,41 +1,86 @@
 #version 450 		// Use GLSL 4.5
 
+// Compiled twice: vert.spv reads Vertex, packed_vert.spv (-DPACKED_VERTEX) reads PackedVertex (DataStructures.h)
+#ifdef PACKED_VERTEX
+layout(location = 0) in vec3 pos;	// snorm, relative to the AABB of the mesh
+layout(location = 2) in vec2 nrm;	// Octahedral encoding, snorm
+layout(location = 3) in vec2 tex;	// Half float
+#else
 layout(location = 0) in vec3 pos;
 layout(location = 1) in vec3 col;
 layout(location = 2) in vec3 nrm;
 layout(location = 3) in vec2 tex;
+#endif
 
 layout(set = 0, binding = 0) uniform UboViewProjection {
 	mat4 projection;
 	mat4 view;
 } uboViewProjection;
 
-// NOT IN USE, LEFT FOR REFERENCE (UBO NOT EFFICIENT AS PUSH COSTANT)
-//layout(set = 0, binding = 1) uniform UboModel {
-//	mat4 model;
-//} uboModel;
-
-// You can have only one PushCostant per Shader
-layout(push_constant) uniform PushModel{
+// One transform per object ID (no push constants: the recorded command buffers do not change when an object moves).
+// The normal matrix is computed on the CPU when the object moves (ObjectData in ObjectBuffer.h)
+struct ObjectData {
 	mat4 model;
-} pushModel;
+	mat3 normal;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} object_buffer;
+
+// One record per drawn instance, the draw passes the first one as firstInstance (DrawInstance in DrawList.h).
+// With GPU culling the buffer holds the visible instances, compacted per command by cull.comp
+struct DrawInstance {
+	uint object;
+	uint texture;
+	uint command;
+	uint pad0;
+	vec4 position_offset;	// AABB of the mesh: position = offset + scale * pos with the packed vertices
+	vec4 position_scale;
+};
 
-layout(location = 0) out vec3 fragWorldPos;
+layout(std430, set = 2, binding = 1) readonly buffer DrawInstances {
+	DrawInstance instances[];
+} draw_instances;
+
+// location 0 (world position) is no longer written: the lighting pass rebuilds it from the depth
 layout(location = 1) out vec3 fragCol;
 layout(location = 2) out vec3 fragNrm;
 layout(location = 3) out vec2 fragTex;
+layout(location = 4) flat out uint fragTexture;	// Element of the bindless texture array
+
+#ifdef PACKED_VERTEX
+vec3 DecodeNormal(vec2 f)
+{
+	vec3 n 	= vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x    += n.x >= 0.0 ? -t : t;
+	n.y    += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+#endif
 
 void main() {
+	DrawInstance instance 	= draw_instances.instances[gl_InstanceIndex];
+	ObjectData object 		= object_buffer.objects[instance.object];
+
+#ifdef PACKED_VERTEX
+	vec3 position 	= instance.position_offset.xyz + instance.position_scale.xyz * pos;
+	vec3 normal 	= DecodeNormal(nrm);
+	fragCol 		= vec3(1.0);
+#else
+	vec3 position 	= pos;
+	vec3 normal 	= normalize(nrm);
+	fragCol 		= col;
+#endif
+
 	gl_Position = uboViewProjection.projection *
 				  uboViewProjection.view * 
-				  pushModel.model * vec4(pos, 1.0);
-	fragCol 	= col;
+				  object.model * vec4(position, 1.0);
 	fragTex 	= tex;
-
-	fragWorldPos = vec3(pushModel.model * vec4(pos, 1.0));
+	fragTexture = instance.texture;
 
 	// convert normal to world space
-	mat3 nrmModel 	= transpose(inverse(mat3(pushModel.model)));
-	fragNrm 		= nrmModel * normalize(nrm);
+	fragNrm 	= object.normal * normal;
 }
 
@@ -78,6 +78,12 @@ void SwapChain::SetRecreationStatus(bool const status)
 	m_IsRecreating = status;
 }
 
+void SwapChain::SetHeadlessExtent(const VkExtent2D& extent)
+{
+	m_IsHeadless		= true;
+	m_SwapChainExtent	= extent;
+}
+
 void SwapChain::ResizeFrameBuffers()
 {
 	m_SwapChainFrameBuffers.resize(m_SwapChainImages.size());
@@ -110,6 +116,18 @@ void SwapChain::DestroySwapChainImageViews()
 
 void SwapChain::DestroySwapChain()
 {
+	if (m_IsHeadless)
+	{
+		for (size_t i = 0; i < m_SwapChainImages.size(); ++i)
+		{
+			Utility::DestroyImage(m_SwapChainImages[i].image, m_HeadlessImageMemory[i]);
+		}
+
+		m_SwapChainImages.clear();
+		m_HeadlessImageMemory.clear();
+		return;
+	}
+
 	vkDestroySwapchainKHR(m_MainDevice->LogicalDevice, m_Swapchain, nullptr);
 }
 
@@ -136,6 +154,12 @@ VkFormat& SwapChain::GetSwapChainImageFormat()
 
 void SwapChain::CreateSwapChain()
 {
+	if (m_IsHeadless)
+	{
+		CreateHeadlessImages();
+		return;
+	}
+
 	SwapChainDetails swapChainDetails = GetSwapChainDetails(m_MainDevice->PhysicalDevice, *m_VulkanSurface);
 
 	VkExtent2D extent				  = ChooseSwapExtent(swapChainDetails.surfaceCapabilities);
@@ -333,9 +357,11 @@ VkExtent2D SwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCa
 	}
 	else				// Altrimenti, significa che  ancora presente un valore di default
 	{
-		int width;
-		int height;
+		int width	= 0;
+		int height	= 0;
+#ifndef HEADLESS_ONLY
 		glfwGetFramebufferSize(m_Window->getWindow(), &width, &height);	// Si prelevano le dimensioni della finestra di GLFW
+#endif
 															// Si crea una nuova Extent con le dimensioni corrette
 		VkExtent2D newExtent = {};
 		newExtent.width		= static_cast<uint32_t>(width);
@@ -347,4 +373,28 @@ VkExtent2D SwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCa
 
 		return newExtent;
 	}
+}
+
+void SwapChain::CreateHeadlessImages()
+{
+	// Le immagini offscreen prendono il posto di quelle della SwapChain, una per ogni frame in flight.
+	// TRANSFER_SRC permette di copiare il risultato su un buffer host (readback, CI).
+	m_SwapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	ImageInfo image_info = {};
+	image_info.width		= m_SwapChainExtent.width;
+	image_info.height		= m_SwapChainExtent.height;
+	image_info.format		= m_SwapChainImageFormat;
+	image_info.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage		= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	image_info.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	m_SwapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	m_HeadlessImageMemory.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < m_SwapChainImages.size(); ++i)
+	{
+		m_SwapChainImages[i].image		= Utility::CreateImage(image_info, &m_HeadlessImageMemory[i]);
+		m_SwapChainImages[i].imageView	= Utility::CreateImageView(m_SwapChainImages[i].image, m_SwapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
 }
\ No newline at end of file
@@ -2,7 +2,11 @@
 
 #include "pch.h"
 
+#ifdef HEADLESS_ONLY
+class Window;
+#else
 #include "Window.h"
+#endif
 #include "Utilities.h"
 
 struct SwapChainImage {
@@ -44,6 +48,8 @@ public:
 	/* Setters */
 	void SetRenderPass(VkRenderPass* renderPass);
 	void SetRecreationStatus(bool const status);
+	void SetHeadlessExtent(const VkExtent2D& extent);
+	bool IsHeadless() const { return m_IsHeadless; }
 
 	/* Vectors operations */
 	std::vector<VkFramebuffer>& GetFrameBuffers();
@@ -77,8 +83,13 @@ private:
 
 	bool m_IsRecreating = false;
 
+	/* Headless: offscreen colour images stand in for the swapchain ones */
+	bool m_IsHeadless = false;
+	std::vector<Allocation> m_HeadlessImageMemory;
+
 private:
 	VkSurfaceFormatKHR  ChooseBestSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats);
 	VkPresentModeKHR	ChooseBestPresentationMode(const std::vector<VkPresentModeKHR>& presentationModes);
 	VkExtent2D			ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCapabilities);
+	void				CreateHeadlessImages();
 };
\ No newline at end of file
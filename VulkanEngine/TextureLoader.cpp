@@ -1,65 +1,171 @@
 #include "pch.h"
 #include "TextureLoader.h"
+#include "ThreadPool.h"
 
 TextureLoader* TextureLoader::s_Instance = nullptr;
 
-int TextureLoader::CreateTexture(const std::string& file_name)
+int TextureLoader::CreateTexture(const std::string& file_name, UploadBatch& upload_batch)
 {
-	m_FileName = file_name;
+	return CreateTextures({ file_name }, upload_batch).front();
+}
 
-	int const texture_image_location = CreateTextureImage();
-	const VkImageView image_view = Utility::CreateImageView(m_TextureObjects->TextureImages[texture_image_location], VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+std::vector<int> TextureLoader::CreateTextures(const std::vector<std::string>& file_names, UploadBatch& upload_batch)
+{
+	std::vector<TextureJob> jobs(file_names.size());
 
-	m_TextureObjects->TextureImageViews.push_back(image_view);
+	size_t i = 0;
 
-	int const descriptor_location = CreateTextureDescriptor(image_view);
+	try
+	{
+		for (; i < jobs.size(); ++i)
+		{
+			TextureJob& job = jobs[i];
+			job.FileName = file_names[i];
+
+			// Solo l'header: le dimensioni servono per creare immagine e staging prima della decodifica
+			ReadTextureInfo(job.FileName, &job.Width, &job.Height);
+			job.ImageSize = static_cast<VkDeviceSize>(job.Width) * static_cast<VkDeviceSize>(job.Height) * 4;
+
+			// The batch is about to flush: the staging memory handed out so far has to be filled first
+			if (!upload_batch.HasRoomFor(job.ImageSize))
+				WaitDecodes(jobs, i);
+
+			Allocation texture_image_memory;
+			job.Image = CreateImage(job.Width, job.Height, &texture_image_memory);
+
+			// Subito nelle liste: se qualcosa fallisce piu' avanti l'immagine viene distrutta con le altre
+			m_TextureObjects->TextureImages.push_back(job.Image);
+			m_TextureObjects->TextureImageMemory.push_back(texture_image_memory);
+
+			// Transizioni e copia vengono registrate nel batch, i pixel arrivano dal worker direttamente nello staging buffer
+			upload_batch.TransitionImageLayout(job.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			void* staging = upload_batch.ReserveImageCopy(job.ImageSize, job.Image, job.Width, job.Height);
+			upload_batch.TransitionImageLayout(job.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+			const std::string file_name = job.FileName;
+			const int width				= job.Width;
+			const int height			= job.Height;
+
+			job.Decoded = ThreadPool::GetInstance()->Submit([file_name, width, height, staging]() {
+				DecodeTexture(file_name, width, height, staging);
+			});
+		}
+	}
+	catch (...)
+	{
+		// The decodes already submitted are still writing into the staging memory of the batch.
+		// Only waited, not rethrown: the exception that stopped the loop is the one that propagates
+		for (auto& job : jobs)
+		{
+			if (job.Decoded.valid())
+				job.Decoded.wait();
+		}
+
+		throw;
+	}
 
-	return descriptor_location;
-}
+	WaitDecodes(jobs, jobs.size());
 
-int TextureLoader::CreateTextureImage()
-{
-	CreateTextureBuffer();
+	// Views and descriptors stay on the calling thread, the descriptor pool is not thread-safe
+	std::vector<int> descriptor_locations;
+	descriptor_locations.reserve(jobs.size());
 
-	VkDeviceMemory m_TextureImageMemory;
+	for (const auto& job : jobs)
+	{
+		const VkImageView image_view = Utility::CreateImageView(job.Image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+		m_TextureObjects->TextureImageViews.push_back(image_view);
 
-	VkImage texture_image = CreateImage(&m_TextureImageMemory);
+		descriptor_locations.push_back(CreateTextureDescriptor(image_view));
+	}
 
-	// Descrive la pipeline barrier che deve rispettare la queue
-	TransitionImageLayout(texture_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		Utility::CopyImageBuffer(m_StagingBuffer, texture_image, m_Width, m_Height);
-	TransitionImageLayout(texture_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	return descriptor_locations;
+}
 
-	m_TextureObjects->TextureImages.push_back(texture_image);
-	m_TextureObjects->TextureImageMemory.push_back(m_TextureImageMemory);
+void TextureLoader::ReadTextureInfo(const std::string& file_name, int* width, int* height)
+{
+	int nChannels;
 
-	vkDestroyBuffer(m_MainDevice.LogicalDevice, m_StagingBuffer, nullptr);
-	vkFreeMemory(m_MainDevice.LogicalDevice, m_StagingBufferMemory, nullptr);
+	std::string fileLoc = GetTexturePath(file_name);
 
-	return static_cast<int>(m_TextureObjects->TextureImages.size()) - 1;
+	if (!stbi_info(fileLoc.c_str(), width, height, &nChannels))
+	{
+		throw std::runtime_error("Failed to load a Texture file! (" + file_name + ")");
+	}
 }
 
-stbi_uc* TextureLoader::LoadTextureFile(int* width, int* height, VkDeviceSize* image_size)
+void TextureLoader::DecodeTexture(const std::string& file_name, const int width, const int height, void* staging)
 {
-	int nChannels;
+	int image_width, image_height, nChannels;
 
-	std::string fileLoc = "Textures/" + m_FileName;
-	stbi_uc* image = stbi_load(fileLoc.c_str(), width, height, &nChannels, STBI_rgb_alpha);
+	std::string fileLoc = GetTexturePath(file_name);
+	stbi_uc* image = stbi_load(fileLoc.c_str(), &image_width, &image_height, &nChannels, STBI_rgb_alpha);
 
 	if (!image)
 	{
-		throw std::runtime_error("Failed to load a Texture file! (" + m_FileName + ")");
+		throw std::runtime_error("Failed to load a Texture file! (" + file_name + ")");
 	}
 
-	*image_size = static_cast<uint64_t>((*width)) * static_cast<uint64_t>((*height)) * 4L;
+	if (image_width != width || image_height != height)
+	{
+		stbi_image_free(image);
+		throw std::runtime_error("Texture file changed while loading! (" + file_name + ")");
+	}
 
-	return image;
+	memcpy(staging, image, static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
 
-	return nullptr;
+	stbi_image_free(image);
+}
+
+void TextureLoader::WaitDecodes(std::vector<TextureJob>& jobs, const size_t count)
+{
+	// Every job must be finished before rethrowing, the staging memory is still being written
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (jobs[i].Decoded.valid())
+			jobs[i].Decoded.wait();
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (jobs[i].Decoded.valid())
+			jobs[i].Decoded.get();
+	}
 }
 
 int TextureLoader::CreateTextureDescriptor(const VkImageView& texture_image)
 {
+	// Bindless: nessun set per texture, la texture diventa l'elemento texID dell'array (e il limite e' quello del device)
+	if (m_TextureObjects->BindlessDescriptorSet != VK_NULL_HANDLE)
+	{
+		const uint32_t texture_id = static_cast<uint32_t>(m_TextureObjects->SamplerDescriptorSets.size());
+
+		if (texture_id >= m_MainDevice.MaxBindlessTextures)
+		{
+			throw std::runtime_error("Too many textures for the bindless texture array!");
+		}
+
+		VkDescriptorImageInfo image_info = {};
+		image_info.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		image_info.imageView	= texture_image;
+		image_info.sampler		= m_TextureObjects->TextureSampler;
+
+		VkWriteDescriptorSet texture_write = {};
+		texture_write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		texture_write.dstSet			= m_TextureObjects->BindlessDescriptorSet;
+		texture_write.dstBinding		= 0;
+		texture_write.dstArrayElement	= texture_id;
+		texture_write.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		texture_write.descriptorCount	= 1;
+		texture_write.pImageInfo		= &image_info;
+
+		vkUpdateDescriptorSets(m_MainDevice.LogicalDevice, 1, &texture_write, 0, nullptr);
+
+		// Lo slot tiene allineati gli indici con gli altri vettori di TextureObjects
+		m_TextureObjects->SamplerDescriptorSets.push_back(VK_NULL_HANDLE);
+
+		return static_cast<int>(texture_id);
+	}
+
 	VkDescriptorSet descriptor_set;
 
 	VkDescriptorSetAllocateInfo set_alloc_info = {};
@@ -96,105 +202,37 @@ int TextureLoader::CreateTextureDescriptor(const VkImageView& texture_image)
 	return static_cast<int>(m_TextureObjects->SamplerDescriptorSets.size()) - 1;
 }
 
-TextureLoader* TextureLoader::GetInstance()
+void TextureLoader::DestroyTexture(const int texture_id)
 {
-	if (s_Instance == 0)
-		s_Instance = new TextureLoader();
+	// Lo slot resta nei vettori (gli indici delle altre texture non cambiano), il descriptor set
+	// viene rilasciato insieme al pool
+	vkDestroyImageView(m_MainDevice.LogicalDevice, m_TextureObjects->TextureImageViews[texture_id], nullptr);
+	Utility::DestroyImage(m_TextureObjects->TextureImages[texture_id], m_TextureObjects->TextureImageMemory[texture_id]);
 
-	return s_Instance;
+	m_TextureObjects->TextureImageViews[texture_id]	= VK_NULL_HANDLE;
+	m_TextureObjects->TextureImages[texture_id]		= VK_NULL_HANDLE;
 }
 
-void TextureLoader::CreateTextureBuffer()
+TextureLoader* TextureLoader::GetInstance()
 {
-	stbi_uc* image_data = LoadTextureFile(&m_Width, &m_Height, &m_Image_size);
-
-	m_BufferSettings.size		= m_Image_size;
-	m_BufferSettings.usage		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	m_BufferSettings.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-	Utility::CreateBuffer(m_BufferSettings, &m_StagingBuffer, &m_StagingBufferMemory);
-
-	// copy image data to staging buffer
-	void* data;
-	vkMapMemory(m_MainDevice.LogicalDevice, m_StagingBufferMemory, 0, m_Image_size, 0, &data);
-	memcpy(data, image_data, static_cast<size_t>(m_Image_size));
-	vkUnmapMemory(m_MainDevice.LogicalDevice, m_StagingBufferMemory);
+	if (s_Instance == 0)
+		s_Instance = new TextureLoader();
 
-	stbi_image_free(image_data);
+	return s_Instance;
 }
 
-VkImage TextureLoader::CreateImage(VkDeviceMemory *m_TextureImageMemory)
+VkImage TextureLoader::CreateImage(const int width, const int height, Allocation *texture_image_memory)
 {
 	// create image to hold final texture
 	ImageInfo image_info = {};
-	image_info.width		= m_Width;
-	image_info.height		= m_Height;
+	image_info.width		= width;
+	image_info.height		= height;
 	image_info.format		= VK_FORMAT_R8G8B8A8_UNORM;
 	image_info.tiling		= VK_IMAGE_TILING_OPTIMAL;
 	image_info.usage		= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 	image_info.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-	return Utility::CreateImage(image_info, m_TextureImageMemory);
-}
-
-void TextureLoader::TransitionImageLayout(const VkImage& image, const VkImageLayout& old_layout, const VkImageLayout& new_layout)
-{
-	VkCommandBuffer command_buffer = Utility::BeginCommandBuffer();
-
-	VkImageMemoryBarrier image_memory_barrier = {};
-	image_memory_barrier.sType								= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	image_memory_barrier.oldLayout							= old_layout;					// Layout da cui spostarsi
-	image_memory_barrier.newLayout							= new_layout;					// Layout in cui spostarsi
-	image_memory_barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;		// Queue family da cui spostarsi
-	image_memory_barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;		// Queue family in cui spostarsi
-	image_memory_barrier.image								= image;						// Immagine su cui wrappare la barriera
-	image_memory_barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
-	image_memory_barrier.subresourceRange.baseMipLevel		= 0;
-	image_memory_barrier.subresourceRange.levelCount		= 1;
-	image_memory_barrier.subresourceRange.baseArrayLayer	= 0;
-	image_memory_barrier.subresourceRange.layerCount		= 1;
-
-	bool const old_layout_undefined = old_layout == VK_IMAGE_LAYOUT_UNDEFINED;
-	bool const new_layout_transfer_dst_optimal = new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-	bool const old_layout_transfer_dst_optimal = old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	bool const new_layout_shader_read_only = new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkPipelineStageFlags src_stage = 0;	// Stage dal quale  possibile iniziare la transizione
-	VkPipelineStageFlags dst_stage = 0;	// Stage nel quale la transizione deve essere gi terminata
-
-	// La transizione da oldLayout a newLayout inizier a partire dallo stage definito in srcAccessMask
-	// ma prima del termine dello stage definito in dstAccessMask.
-	if (old_layout_undefined && new_layout_transfer_dst_optimal)
-	{
-		image_memory_barrier.srcAccessMask = 0;								// Qualsiasi stage iniziale
-		image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;	// copyBufferImage  una operazione di write
-
-		src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;	// qualsiasi momento dopo l'inizio della pipeline
-		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;		// Primache provi a fare una write nel transfer stage!
-	}
-	else if (old_layout_transfer_dst_optimal && new_layout_shader_read_only)
-	{
-		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;			// al termine delle operazioni di scrittura del transfer stage
-		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;	// prima che provi a a leggere il fragment shader
-	}
-
-	const VkDependencyFlags dep_flags = 0;
-
-	const uint32_t memory_barrier_count = 0;
-	const uint32_t buffer_memory_barrier_count = 0;
-	const uint32_t image_memory_barrier_count = 1;
-
-	vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, dep_flags,
-		memory_barrier_count, nullptr,						// no global memory barrier
-		buffer_memory_barrier_count, nullptr,				// no buffer memory barrier
-		image_memory_barrier_count, &image_memory_barrier
-	);
-
-	Utility::EndAndSubmitCommandBuffer(command_buffer);
+	return Utility::CreateImage(image_info, texture_image_memory);
 }
 
 void TextureLoader::Init(const VulkanRenderData& data, TextureObjects *objs)
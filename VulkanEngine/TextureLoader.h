@@ -1,18 +1,19 @@
 #pragma once
 
 #include "Utilities.h"
+#include "UploadBatch.h"
 
 class TextureLoader
 {
 public:
 	void Init(const VulkanRenderData& data, TextureObjects* objs);
-	int CreateTexture(const std::string& file_name);
-	int CreateTextureImage();
-	stbi_uc* LoadTextureFile(int* width, int* height, VkDeviceSize* imageSize);
-	void TransitionImageLayout(const VkImage& image, const VkImageLayout& old_layout, const VkImageLayout& new_layout);
+	int CreateTexture(const std::string& file_name, UploadBatch& upload_batch);
+	std::vector<int> CreateTextures(const std::vector<std::string>& file_names, UploadBatch& upload_batch);
 	int CreateTextureDescriptor(const VkImageView& texture_image);
+	void DestroyTexture(const int texture_id);
 
 	static TextureLoader* GetInstance();
+	static std::string GetTexturePath(const std::string& file_name) { return "Textures/" + file_name; }
 
 private:
 	MainDevice	m_MainDevice;
@@ -28,15 +29,19 @@ private:
 	TextureLoader() = default;
 	static TextureLoader* s_Instance;
 
-	std::string m_FileName;
-	int m_Width;
-	int m_Height;
-	VkDeviceSize m_Image_size;
-	VkBuffer		m_StagingBuffer;
-	VkDeviceMemory	m_StagingBufferMemory;
-	BufferSettings	m_BufferSettings;
+	// Stato di una singola texture durante il caricamento, nessun membro condiviso tra i job
+	struct TextureJob {
+		std::string			FileName;
+		int					Width		= 0;
+		int					Height		= 0;
+		VkDeviceSize		ImageSize	= 0;
+		VkImage				Image		= VK_NULL_HANDLE;
+		std::future<void>	Decoded;
+	};
 
 private:
-	void CreateTextureBuffer();
-	VkImage CreateImage(VkDeviceMemory* m_TextureImageMemory);
+	VkImage CreateImage(const int width, const int height, Allocation* texture_image_memory);
+	static void ReadTextureInfo(const std::string& file_name, int* width, int* height);
+	static void DecodeTexture(const std::string& file_name, const int width, const int height, void* staging);
+	static void WaitDecodes(std::vector<TextureJob>& jobs, const size_t count);
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "pch.h"
+
+#include "ThreadPool.h"
+
+ThreadPool* ThreadPool::s_Instance = nullptr;
+
+ThreadPool* ThreadPool::GetInstance()
+{
+	if (s_Instance == 0)
+		s_Instance = new ThreadPool();
+
+	return s_Instance;
+}
+
+ThreadPool::ThreadPool()
+{
+	// The main thread keeps recording/submitting, the other cores take the jobs
+	const uint32_t hardware_threads = std::max(std::thread::hardware_concurrency(), 2u);
+
+	for (uint32_t i = 0; i < hardware_threads - 1; ++i)
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void ThreadPool::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_JobAvailable.notify_all();
+
+	// The jobs already queued are completed before the workers leave
+	for (auto& worker : m_Workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+
+	m_Workers.clear();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+
+			if (m_Jobs.empty())
+				return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop();
+		}
+
+		job();
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "pch.h"
+
+// Fixed set of worker threads fed by a FIFO of jobs. Submit() returns a future, exceptions
+// thrown by a job are rethrown by future::get() on the thread that collects the result.
+class ThreadPool
+{
+public:
+	static ThreadPool* GetInstance();
+
+	template <typename F>
+	auto Submit(F&& job) -> std::future<decltype(job())>
+	{
+		using Result = decltype(job());
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+		std::future<Result> result = task->get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (m_Stopping)
+				throw std::runtime_error("Job submitted to a stopped ThreadPool!");
+
+			m_Jobs.emplace([task]() { (*task)(); });
+		}
+
+		m_JobAvailable.notify_one();
+		return result;
+	}
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+	void Destroy();
+
+private:
+	ThreadPool();
+	static ThreadPool* s_Instance;
+
+	std::vector<std::thread>			m_Workers;
+	std::queue<std::function<void()>>	m_Jobs;
+	std::mutex							m_Mutex;
+	std::condition_variable				m_JobAvailable;
+	bool								m_Stopping = false;
+
+private:
+	void WorkerLoop();
+};
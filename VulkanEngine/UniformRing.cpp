@@ -0,0 +1,80 @@
+#include "pch.h"
+
+#include "UniformRing.h"
+
+UniformRing::UniformRing()
+{
+	m_MainDevice	= nullptr;
+	m_Buffer		= VK_NULL_HANDLE;
+	m_Memory		= {};
+	m_FrameSize		= 0;
+	m_FrameBegin	= 0;
+	m_Cursor		= 0;
+}
+
+UniformRing::UniformRing(MainDevice* main_device) : UniformRing()
+{
+	m_MainDevice = main_device;
+}
+
+void UniformRing::CreateBuffer(VkDeviceSize frame_size)
+{
+	m_FrameSize = Align(frame_size);
+
+	BufferSettings buffer_settings;
+	buffer_settings.size		= m_FrameSize * MAX_FRAMES_IN_FLIGHT;
+	buffer_settings.usage		= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	buffer_settings.properties	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	Utility::CreateBuffer(buffer_settings, &m_Buffer, &m_Memory);
+
+	// The allocator maps HOST_VISIBLE blocks once, the pointer stays valid until DestroyBuffer()
+	if (!m_Memory.Mapped)
+		throw std::runtime_error("The uniform ring buffer is not host visible!");
+}
+
+void UniformRing::BeginFrame(uint32_t frame)
+{
+	m_FrameBegin	= m_FrameSize * (frame % MAX_FRAMES_IN_FLIGHT);
+	m_Cursor		= m_FrameBegin;
+}
+
+uint32_t UniformRing::Push(const void* data, VkDeviceSize size)
+{
+	uint32_t offset = 0;
+
+	memcpy(Reserve(size, &offset), data, static_cast<size_t>(size));
+
+	return offset;
+}
+
+void* UniformRing::Reserve(VkDeviceSize size, uint32_t* offset)
+{
+	if (m_Cursor + size > m_FrameBegin + m_FrameSize)
+		throw std::runtime_error("Uniform ring buffer overflow, the frame slice is too small!");
+
+	*offset = static_cast<uint32_t>(m_Cursor);
+
+	void* data = static_cast<char*>(m_Memory.Mapped) + m_Cursor;
+	m_Cursor += Align(size);
+
+	return data;
+}
+
+void UniformRing::DestroyBuffer()
+{
+	if (m_Buffer == VK_NULL_HANDLE)
+		return;
+
+	Utility::DestroyBuffer(m_Buffer, m_Memory);
+	m_Buffer = VK_NULL_HANDLE;
+}
+
+VkDeviceSize UniformRing::Align(VkDeviceSize size) const
+{
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(
+		std::max(m_MainDevice->MinUniformBufferOffset, m_MainDevice->MinStorageBufferOffset), 1);
+
+	// Both offset alignments are powers of two, so is their maximum
+	return (size + alignment - 1) & ~(alignment - 1);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pch.h"
+
+#include "Utilities.h"
+
+// Dynamic offsets of the uniform data written for the current frame
+struct FrameUniformOffsets {
+	uint32_t ViewProjection = 0;
+	uint32_t Lights			= 0;	// Slice del frame nel light buffer del LightManager (non nel ring)
+	uint32_t Settings		= 0;
+	uint32_t Clusters		= 0;	// Griglia dei cluster + liste di luci, scritto solo in LIGHTING_CLUSTERED
+	uint32_t Objects		= 0;	// Slice del frame nell'object buffer (non nel ring): ObjectData[] per object ID
+	uint32_t Culling		= 0;	// CullData del culling su GPU (frustum corrente, View-Projection della Hi-Z)
+	uint32_t TiledStats		= 0;	// TiledLightingStats, scritto dal compute shader del tiled lighting
+};
+
+// One persistently mapped, host coherent buffer for all the per-frame uniform data.
+// Every frame in flight owns a slice of the ring: the data is memcpy'd at aligned offsets
+// and the descriptor sets (UNIFORM_BUFFER_DYNAMIC) are bound with those offsets, so the
+// same sets are used by every frame and a slice is rewritten only after its fence.
+// The buffer is also a storage buffer: the light lists of the clustered lighting live here too.
+class UniformRing
+{
+public:
+	UniformRing();
+	UniformRing(MainDevice* main_device);
+
+	void CreateBuffer(VkDeviceSize frame_size);
+	void BeginFrame(uint32_t frame);
+	uint32_t Push(const void* data, VkDeviceSize size);		// Returns the dynamic offset of the data
+	void* Reserve(VkDeviceSize size, uint32_t* offset);		// Space written in place by the caller
+	void DestroyBuffer();
+
+	VkDeviceSize Align(VkDeviceSize size) const;
+
+	void* GetData(uint32_t offset)			{ return static_cast<char*>(m_Memory.Mapped) + offset; }	// Data written at a previous offset
+
+	VkBuffer& GetBuffer()					{ return m_Buffer; }
+	VkDeviceSize GetFrameSize() const		{ return m_FrameSize; }
+
+private:
+	MainDevice	*m_MainDevice;
+
+	VkBuffer	m_Buffer;
+	Allocation	m_Memory;
+
+	VkDeviceSize m_FrameSize;	// Slice of a frame in flight, multiple of the uniform/storage offset alignment
+	VkDeviceSize m_FrameBegin;
+	VkDeviceSize m_Cursor;		// Next free byte, relative to the start of the buffer
+};
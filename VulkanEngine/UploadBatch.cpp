@@ -0,0 +1,359 @@
+#include "pch.h"
+
+#include "UploadBatch.h"
+#include "Utilities.h"
+
+// Above this amount of staging memory the batch is flushed, so a huge scene doesn't keep
+// every staging buffer alive at the same time
+constexpr VkDeviceSize MAX_UPLOAD_BATCH_BYTES = 256ULL * 1024ULL * 1024ULL;
+
+UploadBatch::UploadBatch()
+{
+	m_Device				= VK_NULL_HANDLE;
+	m_CommandBuffer			= VK_NULL_HANDLE;
+	m_AcquireCommandBuffer	= VK_NULL_HANDLE;
+	m_TransferComplete		= VK_NULL_HANDLE;
+	m_Fence					= VK_NULL_HANDLE;
+	m_Submitted				= false;
+	m_StagingBytes			= 0;
+}
+
+UploadBatch::UploadBatch(const VkDevice& device, const UploadQueue& transfer, const UploadQueue& graphics) : UploadBatch()
+{
+	m_Device	= device;
+	m_Transfer	= transfer;
+	m_Graphics	= graphics;
+}
+
+void UploadBatch::CopyToBuffer(const void* data, const VkDeviceSize size, const VkBuffer& dst_buffer, const VkDeviceSize dst_offset,
+	const VkPipelineStageFlags dst_stage, const VkAccessFlags dst_access)
+{
+	void* mapped = nullptr;
+	VkBuffer staging_buffer = CreateStagingBuffer(size, &mapped);
+
+	memcpy(mapped, data, static_cast<size_t>(size));
+
+	VkBufferCopy buffer_copy_region = {};
+	buffer_copy_region.srcOffset = 0;
+	buffer_copy_region.dstOffset = dst_offset;
+	buffer_copy_region.size		 = size;
+
+	vkCmdCopyBuffer(m_CommandBuffer, staging_buffer, dst_buffer, 1, &buffer_copy_region);
+
+	// Same family: the global barrier recorded in Submit() covers every copy
+	if (!UsesTransferQueue())
+		return;
+
+	VkBufferMemoryBarrier ownership_barrier = {};
+	ownership_barrier.sType					= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	ownership_barrier.srcQueueFamilyIndex	= m_Transfer.Family;
+	ownership_barrier.dstQueueFamilyIndex	= m_Graphics.Family;
+	ownership_barrier.buffer				= dst_buffer;
+	ownership_barrier.offset				= dst_offset;	// Only the written range: the rest of a shared buffer may be in use
+	ownership_barrier.size					= size;
+
+	// Release: the transfer queue gives the buffer away once the copy is done
+	ownership_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	ownership_barrier.dstAccessMask = 0;
+
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+		0, nullptr, 1, &ownership_barrier, 0, nullptr);
+
+	// Acquire: the graphics queue takes it back before the stage that reads it
+	ownership_barrier.srcAccessMask = 0;
+	ownership_barrier.dstAccessMask = dst_access;
+
+	vkCmdPipelineBarrier(m_AcquireCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dst_stage, 0,
+		0, nullptr, 1, &ownership_barrier, 0, nullptr);
+}
+
+void UploadBatch::CopyToImage(const void* data, const VkDeviceSize size, const VkImage& image, const uint32_t width, const uint32_t height)
+{
+	memcpy(ReserveImageCopy(size, image, width, height), data, static_cast<size_t>(size));
+}
+
+void* UploadBatch::ReserveImageCopy(const VkDeviceSize size, const VkImage& image, const uint32_t width, const uint32_t height)
+{
+	void* mapped = nullptr;
+	VkBuffer staging_buffer = CreateStagingBuffer(size, &mapped);
+
+	VkBufferImageCopy image_region = {};
+	image_region.bufferOffset						= 0;
+	image_region.bufferRowLength					= 0;
+	image_region.bufferImageHeight					= 0;
+	image_region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	image_region.imageSubresource.mipLevel			= 0;
+	image_region.imageSubresource.baseArrayLayer	= 0;
+	image_region.imageSubresource.layerCount		= 1;
+	image_region.imageOffset						= { 0, 0, 0 };
+	image_region.imageExtent						= { width, height, 1 };	// Whole image: valid for any minImageTransferGranularity
+
+	// The image must already be in TRANSFER_DST_OPTIMAL (see TransitionImageLayout)
+	vkCmdCopyBufferToImage(m_CommandBuffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_region);
+
+	return mapped;
+}
+
+void UploadBatch::TransitionImageLayout(const VkImage& image, const VkImageLayout& old_layout, const VkImageLayout& new_layout)
+{
+	Begin();
+
+	VkImageMemoryBarrier image_memory_barrier = {};
+	image_memory_barrier.sType								= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_memory_barrier.oldLayout							= old_layout;					// Layout da cui spostarsi
+	image_memory_barrier.newLayout							= new_layout;					// Layout in cui spostarsi
+	image_memory_barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;		// Queue family da cui spostarsi
+	image_memory_barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;		// Queue family in cui spostarsi
+	image_memory_barrier.image								= image;						// Immagine su cui wrappare la barriera
+	image_memory_barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	image_memory_barrier.subresourceRange.baseMipLevel		= 0;
+	image_memory_barrier.subresourceRange.levelCount		= 1;
+	image_memory_barrier.subresourceRange.baseArrayLayer	= 0;
+	image_memory_barrier.subresourceRange.layerCount		= 1;
+
+	VkPipelineStageFlags src_stage = 0;	// Stage after which the transition can start
+	VkPipelineStageFlags dst_stage = 0;	// Stage that has to wait for the transition
+
+	if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	{
+		image_memory_barrier.srcAccessMask = 0;								// Qualsiasi stage iniziale
+		image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;	// copyBufferImage is a write operation
+
+		src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+	else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		if (UsesTransferQueue())
+		{
+			// Release + acquire pair: the layout transition happens once, between the two queues
+			image_memory_barrier.srcQueueFamilyIndex = m_Transfer.Family;
+			image_memory_barrier.dstQueueFamilyIndex = m_Graphics.Family;
+
+			image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			image_memory_barrier.dstAccessMask = 0;
+
+			vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+			image_memory_barrier.srcAccessMask = 0;
+			image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(m_AcquireCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+			return;
+		}
+
+		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;			// al termine delle operazioni di scrittura del transfer stage
+		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;	// prima che provi a a leggere il fragment shader
+	}
+	else
+	{
+		throw std::runtime_error("Unsupported layout transition in the upload batch!");
+	}
+
+	vkCmdPipelineBarrier(m_CommandBuffer, src_stage, dst_stage, 0,
+		0, nullptr,						// no global memory barrier
+		0, nullptr,						// no buffer memory barrier
+		1, &image_memory_barrier);
+}
+
+void UploadBatch::Submit()
+{
+	if (IsEmpty() || m_Submitted)
+		return;
+
+	if (!UsesTransferQueue())
+	{
+		// Buffer copies become visible to every later command of the graphics queue
+		VkMemoryBarrier memory_barrier = {};
+		memory_barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memory_barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dstAccessMask	= VK_ACCESS_MEMORY_READ_BIT;
+
+		vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+			1, &memory_barrier, 0, nullptr, 0, nullptr);
+	}
+
+	VkResult result = vkEndCommandBuffer(m_CommandBuffer);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to stop recording the upload Command Buffer!");
+
+	VkFenceCreateInfo fence_info = {};
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	result = vkCreateFence(m_Device, &fence_info, nullptr, &m_Fence);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the upload Fence!");
+
+	VkSubmitInfo submit_info		= {};
+	submit_info.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount	= 1;
+	submit_info.pCommandBuffers		= &m_CommandBuffer;
+
+	if (!UsesTransferQueue())
+	{
+		// One submit for every copy of the batch, no vkQueueWaitIdle
+		result = vkQueueSubmit(m_Graphics.Queue, 1, &submit_info, m_Fence);
+
+		if (result != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit the upload Command Buffer!");
+
+		m_Submitted = true;
+		return;
+	}
+
+	result = vkEndCommandBuffer(m_AcquireCommandBuffer);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to stop recording the acquire Command Buffer!");
+
+	VkSemaphoreCreateInfo semaphore_info = {};
+	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	result = vkCreateSemaphore(m_Device, &semaphore_info, nullptr, &m_TransferComplete);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the upload Semaphore!");
+
+	// The copies run on the transfer queue, in parallel with the frames already in flight
+	submit_info.signalSemaphoreCount	= 1;
+	submit_info.pSignalSemaphores		= &m_TransferComplete;
+
+	result = vkQueueSubmit(m_Transfer.Queue, 1, &submit_info, VK_NULL_HANDLE);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to submit the upload Command Buffer!");
+
+	// The graphics queue only executes the acquire barriers, after the copies have landed
+	const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkSubmitInfo acquire_info			= {};
+	acquire_info.sType					= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	acquire_info.waitSemaphoreCount		= 1;
+	acquire_info.pWaitSemaphores		= &m_TransferComplete;
+	acquire_info.pWaitDstStageMask		= &wait_stage;
+	acquire_info.commandBufferCount		= 1;
+	acquire_info.pCommandBuffers		= &m_AcquireCommandBuffer;
+
+	result = vkQueueSubmit(m_Graphics.Queue, 1, &acquire_info, m_Fence);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to submit the acquire Command Buffer!");
+
+	m_Submitted = true;
+}
+
+void UploadBatch::Wait()
+{
+	if (IsEmpty())
+		return;
+
+	Submit();
+
+	vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	// The copies are done, the staging memory goes back to the allocator
+	for (auto& staging : m_StagingBuffers)
+		Utility::DestroyBuffer(staging.Buffer, staging.Memory);
+
+	vkDestroyFence(m_Device, m_Fence, nullptr);
+	vkFreeCommandBuffers(m_Device, m_Transfer.CommandPool, 1, &m_CommandBuffer);
+
+	if (m_AcquireCommandBuffer != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(m_Device, m_TransferComplete, nullptr);
+		vkFreeCommandBuffers(m_Device, m_Graphics.CommandPool, 1, &m_AcquireCommandBuffer);
+	}
+
+	m_StagingBuffers.clear();
+	m_StagingBytes			= 0;
+	m_CommandBuffer			= VK_NULL_HANDLE;
+	m_AcquireCommandBuffer	= VK_NULL_HANDLE;
+	m_TransferComplete		= VK_NULL_HANDLE;
+	m_Fence					= VK_NULL_HANDLE;
+	m_Submitted				= false;
+}
+
+bool UploadBatch::HasRoomFor(const VkDeviceSize size) const
+{
+	return IsEmpty() || m_StagingBytes + size <= MAX_UPLOAD_BATCH_BYTES;
+}
+
+bool UploadBatch::IsComplete() const
+{
+	return m_Submitted && vkGetFenceStatus(m_Device, m_Fence) == VK_SUCCESS;
+}
+
+void UploadBatch::Begin()
+{
+	// A batch already in flight has to complete before recording again
+	if (m_Submitted)
+		Wait();
+
+	if (!IsEmpty())
+		return;
+
+	m_CommandBuffer = BeginCommandBuffer(m_Transfer.CommandPool);
+
+	if (UsesTransferQueue())
+		m_AcquireCommandBuffer = BeginCommandBuffer(m_Graphics.CommandPool);
+}
+
+VkCommandBuffer UploadBatch::BeginCommandBuffer(const VkCommandPool& command_pool)
+{
+	VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+
+	VkCommandBufferAllocateInfo alloc_info = {};
+	alloc_info.sType				= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.level				= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	alloc_info.commandPool			= command_pool;
+	alloc_info.commandBufferCount	= 1;
+
+	VkResult result = vkAllocateCommandBuffers(m_Device, &alloc_info, &command_buffer);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to allocate the upload Command Buffer!");
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	result = vkBeginCommandBuffer(command_buffer, &begin_info);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to start recording the upload Command Buffer!");
+
+	return command_buffer;
+}
+
+VkBuffer UploadBatch::CreateStagingBuffer(const VkDeviceSize size, void** mapped)
+{
+	// Too much staging memory in flight: the copies recorded so far are flushed first
+	if (!HasRoomFor(size))
+		Wait();
+
+	Begin();
+
+	BufferSettings buffer_settings;
+	buffer_settings.size		= size;
+	buffer_settings.usage		= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	buffer_settings.properties	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	StagingBuffer staging = {};
+	Utility::CreateBuffer(buffer_settings, &staging.Buffer, &staging.Memory);
+
+	// The allocator keeps the HOST_VISIBLE blocks mapped, the caller writes the data straight there
+	*mapped = staging.Memory.Mapped;
+
+	m_StagingBuffers.push_back(staging);
+	m_StagingBytes += size;
+
+	return staging.Buffer;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "pch.h"
+
+// Queue on which a batch records and submits its commands
+struct UploadQueue {
+	VkQueue			Queue		= VK_NULL_HANDLE;
+	VkCommandPool	CommandPool	= VK_NULL_HANDLE;
+	uint32_t		Family		= UINT_MAX;
+};
+
+// Records many staging copies and layout transitions into one command buffer, submitted once
+// with a fence. The staging buffers stay alive until Wait(), so callers only block when they
+// actually need the data on the GPU (typically once, at the end of the loading).
+//
+// When the transfer queue belongs to a different family than the graphics one, the copies run
+// on the transfer queue and the resources are released to the graphics family; a tiny command
+// buffer on the graphics queue waits on a semaphore and acquires them. Anything submitted to the
+// graphics queue after Submit() can use the uploaded resources without waiting on the host.
+class UploadBatch
+{
+public:
+	UploadBatch();
+	UploadBatch(const VkDevice& device, const UploadQueue& transfer, const UploadQueue& graphics);
+
+	void CopyToBuffer(const void* data, const VkDeviceSize size, const VkBuffer& dst_buffer, const VkDeviceSize dst_offset = 0,
+		const VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		const VkAccessFlags dst_access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+	void CopyToImage(const void* data, const VkDeviceSize size, const VkImage& image, const uint32_t width, const uint32_t height);
+
+	// Records the copy and returns the mapped staging memory: it can be filled from any thread,
+	// as long as it is complete before Submit()/Wait() and before the batch runs out of room
+	void* ReserveImageCopy(const VkDeviceSize size, const VkImage& image, const uint32_t width, const uint32_t height);
+	void TransitionImageLayout(const VkImage& image, const VkImageLayout& old_layout, const VkImageLayout& new_layout);
+
+	void Submit();
+	void Wait();
+
+	bool IsEmpty() const		{ return m_CommandBuffer == VK_NULL_HANDLE; }
+	bool IsSubmitted() const	{ return m_Submitted; }
+	bool IsComplete() const;
+	bool HasRoomFor(const VkDeviceSize size) const;		// False when staging 'size' more bytes would flush the batch
+	bool UsesTransferQueue() const { return m_Transfer.Family != m_Graphics.Family; }
+
+private:
+	struct StagingBuffer {
+		VkBuffer	Buffer;
+		Allocation	Memory;
+	};
+
+	VkDevice		m_Device;
+	UploadQueue		m_Transfer;
+	UploadQueue		m_Graphics;
+
+	VkCommandBuffer	m_CommandBuffer;			// Copies, recorded on the transfer queue
+	VkCommandBuffer	m_AcquireCommandBuffer;		// Ownership acquire, graphics queue (only with a dedicated transfer family)
+	VkSemaphore		m_TransferComplete;			// Transfer submit -> acquire submit
+	VkFence			m_Fence;
+	bool			m_Submitted;
+
+	std::vector<StagingBuffer>	m_StagingBuffers;
+	VkDeviceSize				m_StagingBytes;
+
+private:
+	void Begin();
+	VkCommandBuffer BeginCommandBuffer(const VkCommandPool& command_pool);
+	VkBuffer CreateStagingBuffer(const VkDeviceSize size, void** mapped);
+};
@@ -34,7 +34,7 @@ std::vector<char> Utility::ReadFile(const std::string& filename)
 	return file_buffer;
 }
 
-void Utility::CreateBuffer(const BufferSettings& buffer_settings, VkBuffer* buffer_data, VkDeviceMemory* memory)
+void Utility::CreateBuffer(const BufferSettings& buffer_settings, VkBuffer* buffer_data, Allocation* memory)
 {
 	VkBufferCreateInfo buffer_info = {};
 	buffer_info.sType			= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -52,23 +52,25 @@ void Utility::CreateBuffer(const BufferSettings& buffer_settings, VkBuffer* buff
 	VkMemoryRequirements mem_requirements;
 	vkGetBufferMemoryRequirements(m_MainDevice->LogicalDevice, *buffer_data, &mem_requirements);
 
-	VkMemoryAllocateInfo memory_alloc_info = {};
-	memory_alloc_info.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_alloc_info.allocationSize	= mem_requirements.size;					
-	memory_alloc_info.memoryTypeIndex	= Utility::FindMemoryTypeIndex(mem_requirements.memoryTypeBits, buffer_settings.properties);
-
 	// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT  : CPU pu interagire con la memoria
 	// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : Permette il posizionamento dei dati direttamente nel buffer dopo il mapping
 	// (altrimenti ha bisogno di essere specificato manualmente)
 
-	result = vkAllocateMemory(m_MainDevice->LogicalDevice, &memory_alloc_info, nullptr, memory);
+	// The buffer gets a range of a shared memory block, HOST_VISIBLE ranges come already mapped
+	*memory = MemoryAllocator::GetInstance()->Allocate(mem_requirements, buffer_settings.properties, true);
+
+	result = vkBindBufferMemory(m_MainDevice->LogicalDevice, *buffer_data, memory->Memory, memory->Offset);
 
 	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to allocate Vertex Buffer Memory!");
+		throw std::runtime_error("Failed to bind memory to a buffer!");
 	}
+}
 
-	vkBindBufferMemory(m_MainDevice->LogicalDevice, *buffer_data, *memory, 0);
+void Utility::DestroyBuffer(const VkBuffer& buffer, Allocation& memory)
+{
+	vkDestroyBuffer(m_MainDevice->LogicalDevice, buffer, nullptr);
+	MemoryAllocator::GetInstance()->Free(memory);
 }
 
 VkCommandBuffer Utility::BeginCommandBuffer()
@@ -122,25 +124,6 @@ void Utility::CopyBufferCmd(const VkBuffer& src_buffer, const VkBuffer& dst_buff
 	EndAndSubmitCommandBuffer(transfer_command_buffer);
 }
 
-void Utility::CopyImageBuffer(const VkBuffer &src, const VkImage &image, const uint32_t width, const uint32_t height)
-{
-	VkCommandBuffer transfer_command_buffer = BeginCommandBuffer();
-
-	VkBufferImageCopy image_region = {};
-	image_region.bufferOffset						= 0;
-	image_region.bufferRowLength					= 0;
-	image_region.bufferImageHeight					= 0;
-	image_region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
-	image_region.imageSubresource.mipLevel			= 0;
-	image_region.imageSubresource.baseArrayLayer	= 0;
-	image_region.imageSubresource.layerCount		= 1;
-	image_region.imageOffset						= { 0, 0, 0 };
-	image_region.imageExtent						= { width, height, 1 };
-
-	vkCmdCopyBufferToImage(transfer_command_buffer, src, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_region);
-
-	EndAndSubmitCommandBuffer(transfer_command_buffer);
-}
 /*
 Model* Utility::AllocateDynamicBufferTransferSpace(VkDeviceSize minUniformBufferOffset)
 {
@@ -190,7 +173,7 @@ void Utility::FreeAlignedMemoryDUBO(Model * modelTransferSpace)
 */
 
 
-VkImage Utility::CreateImage(const ImageInfo& image_info, VkDeviceMemory* imageMemory)
+VkImage Utility::CreateImage(const ImageInfo& image_info, Allocation* imageMemory)
 {
 	// CREAZIONE DELL'IMMAGINE (Header dell'immagine, in memoria non  ancora presente)
 	VkImageCreateInfo imageCreateInfo = {};
@@ -199,7 +182,7 @@ VkImage Utility::CreateImage(const ImageInfo& image_info, VkDeviceMemory* imageM
 	imageCreateInfo.extent.width	= image_info.width;
 	imageCreateInfo.extent.height	= image_info.height;
 	imageCreateInfo.extent.depth	= 1;			// NO 3D ASPECT
-	imageCreateInfo.mipLevels		= 1;
+	imageCreateInfo.mipLevels		= image_info.mip_levels;
 	imageCreateInfo.arrayLayers		= 1;
 	imageCreateInfo.format			= image_info.format;
 	imageCreateInfo.tiling			= image_info.tiling;
@@ -220,19 +203,11 @@ VkImage Utility::CreateImage(const ImageInfo& image_info, VkDeviceMemory* imageM
 	VkMemoryRequirements memoryRequirements;
 	vkGetImageMemoryRequirements(m_MainDevice->LogicalDevice, image, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocInfo = {};
-	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocInfo.allocationSize = memoryRequirements.size;
-	memoryAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(memoryRequirements.memoryTypeBits, image_info.properties);
+	// Optimal images are kept apart from the buffers, linear ones can share their blocks
+	*imageMemory = MemoryAllocator::GetInstance()->Allocate(memoryRequirements, image_info.properties,
+		image_info.tiling == VK_IMAGE_TILING_LINEAR);
 
-	result = vkAllocateMemory(m_MainDevice->LogicalDevice, &memoryAllocInfo, nullptr, imageMemory);
-
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to allocate memory for image!");
-	}
-
-	result = vkBindImageMemory(m_MainDevice->LogicalDevice, image, *imageMemory, 0);
+	result = vkBindImageMemory(m_MainDevice->LogicalDevice, image, imageMemory->Memory, imageMemory->Offset);
 
 	if (result != VK_SUCCESS)
 	{
@@ -242,7 +217,14 @@ VkImage Utility::CreateImage(const ImageInfo& image_info, VkDeviceMemory* imageM
 	return image;
 }
 
-VkImageView Utility::CreateImageView(const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspect_flags)
+void Utility::DestroyImage(const VkImage& image, Allocation& image_memory)
+{
+	vkDestroyImage(m_MainDevice->LogicalDevice, image, nullptr);
+	MemoryAllocator::GetInstance()->Free(image_memory);
+}
+
+VkImageView Utility::CreateImageView(const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspect_flags,
+	uint32_t base_mip, uint32_t mip_count)
 {
 	VkImageViewCreateInfo viewCreateInfo = {};
 	viewCreateInfo.sType		= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -256,8 +238,8 @@ VkImageView Utility::CreateImageView(const VkImage& image, const VkFormat& forma
 
 	// subresourceRange : dice all'ImageView quale parte dell'image visualizzare
 	viewCreateInfo.subresourceRange.aspectMask		= aspect_flags;	 // Quale aspetto dell'immagine visualizzare (COLOR, DEPTH, STENCIL)
-	viewCreateInfo.subresourceRange.baseMipLevel	= 0;			 // Livello iniziale della mipmap (primo mipmap level)
-	viewCreateInfo.subresourceRange.levelCount		= 1;			 // Numero di livelli mipmap da visualizzare
+	viewCreateInfo.subresourceRange.baseMipLevel	= base_mip;		 // Livello iniziale della mipmap (primo mipmap level)
+	viewCreateInfo.subresourceRange.levelCount		= mip_count;	 // Numero di livelli mipmap da visualizzare
 	viewCreateInfo.subresourceRange.baseArrayLayer	= 0;			 // Livello iniziale del primo arrayLayer (primo arrayLayer)
 	viewCreateInfo.subresourceRange.layerCount		= 1;			 // Numero di ArrayLayer
 
@@ -295,68 +277,156 @@ void Utility::CreateDepthBufferImage(BufferImage& image, const VkExtent2D &image
 	image.ImageView = Utility::CreateImageView(image.Image, image.Format, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
+// G-buffer compatto: albedo RGBA8 sRGB, normali ottaedriche su due canali, posizione ricostruita dalla depth
+VkFormat Utility::ChooseAlbedoBufferFormat()
+{
+	return Utility::ChooseSupportedFormat({ VK_FORMAT_R8G8B8A8_SRGB }, VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
+VkFormat Utility::ChooseNormalBufferFormat()
+{
+	// R16G16_SNORM is not guaranteed as colour attachment, R16G16_SFLOAT is
+	return Utility::ChooseSupportedFormat({ VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16_SFLOAT }, VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
+VkFormat Utility::ChooseGBufferDepthFormat()
+{
+	// Sampled by the lighting pass: no stencil, the 32 bit float keeps the reconstructed position precise
+	return Utility::ChooseSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT }, VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
 void Utility::CreateColorBufferImage(BufferImage& image, const VkExtent2D& image_extent)
 {
-	const std::vector<VkFormat> formats = { VK_FORMAT_R32G32B32A32_SFLOAT };
-	const VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
-	const VkFormatFeatureFlags format_flags = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	CreateGBufferImage(image, image_extent, ChooseAlbedoBufferFormat(),
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
 
-	image.Format = Utility::ChooseSupportedFormat(formats, tiling, format_flags);
+void Utility::CreateNormalBufferImage(BufferImage& image, const VkExtent2D& image_extent)
+{
+	CreateGBufferImage(image, image_extent, ChooseNormalBufferFormat(),
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
 
-	ImageInfo image_info = {};
-	image_info.width = image_extent.width;
-	image_info.height = image_extent.height;
-	image_info.format = image.Format;
-	image_info.tiling = tiling;
-	image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-	image_info.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+void Utility::CreateGBufferDepthImage(BufferImage& image, const VkExtent2D& image_extent)
+{
+	// La view espone solo l'aspect DEPTH, anche quando il formato ha lo stencil
+	CreateGBufferImage(image, image_extent, ChooseGBufferDepthFormat(),
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
 
-	image.Image = Utility::CreateImage(image_info, &image.Memory);
+// Output HDR del tiled lighting: scritta dal compute shader, letta dal pass di composizione
+void Utility::CreateLightingBufferImage(BufferImage& image, const VkExtent2D& image_extent)
+{
+	CreateGBufferImage(image, image_extent, VK_FORMAT_R16G16B16A16_SFLOAT,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
 
-	image.ImageView = Utility::CreateImageView(image.Image, image.Format, VK_IMAGE_ASPECT_COLOR_BIT);
+// Hi-Z dell'occlusion culling: R32 float con tutte le mip, costruita dalla depth del G-buffer a fine frame
+void Utility::CreateHiZPyramid(HiZPyramid& pyramid, const VkExtent2D& image_extent)
+{
+	VkExtent2D mip_extent = { std::max(image_extent.width / 2, 1u), std::max(image_extent.height / 2, 1u) };
 
+	pyramid.MipExtents.clear();
+
+	while (pyramid.MipExtents.size() < HIZ_MAX_LEVELS)
 	{
-		VkSamplerCreateInfo samplerCreateInfo = {};
-		samplerCreateInfo.sType						= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerCreateInfo.magFilter					= VK_FILTER_NEAREST;		// linear interpolation between the texels
-		samplerCreateInfo.minFilter					= VK_FILTER_NEAREST;		// quando viene miniaturizzata come renderizzarla (lerp)
-		samplerCreateInfo.addressModeU				= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		samplerCreateInfo.addressModeV				= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		samplerCreateInfo.addressModeW				= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		samplerCreateInfo.borderColor				= VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-		samplerCreateInfo.unnormalizedCoordinates	= VK_FALSE;			//  normalizzata
-		samplerCreateInfo.mipmapMode				= VK_SAMPLER_MIPMAP_MODE_NEAREST;
-		samplerCreateInfo.mipLodBias				= 0.0f;
-		samplerCreateInfo.minLod					= 0.0f;
-		samplerCreateInfo.maxLod					= 1.0f;
-		samplerCreateInfo.anisotropyEnable			= VK_TRUE;
-		samplerCreateInfo.maxAnisotropy				= 16;
-		samplerCreateInfo.compareEnable				= VK_FALSE;
-		samplerCreateInfo.compareOp					= VK_COMPARE_OP_NEVER;
+		pyramid.MipExtents.push_back(mip_extent);
 
-		image.Sampler = Utility::CreateSampler(samplerCreateInfo);
+		if (mip_extent.width == 1 && mip_extent.height == 1)
+			break;
+
+		mip_extent = { std::max(mip_extent.width / 2, 1u), std::max(mip_extent.height / 2, 1u) };
 	}
+
+	const uint32_t levels = static_cast<uint32_t>(pyramid.MipExtents.size());
+
+	pyramid.Image.Format = VK_FORMAT_R32_SFLOAT;
+
+	ImageInfo image_info = {};
+	image_info.width		= pyramid.MipExtents[0].width;
+	image_info.height		= pyramid.MipExtents[0].height;
+	image_info.format		= pyramid.Image.Format;
+	image_info.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage		= VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	image_info.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	image_info.mip_levels	= levels;
+
+	pyramid.Image.Image		= Utility::CreateImage(image_info, &pyramid.Image.Memory);
+	pyramid.Image.ImageView = Utility::CreateImageView(pyramid.Image.Image, pyramid.Image.Format, VK_IMAGE_ASPECT_COLOR_BIT, 0, levels);
+
+	pyramid.MipViews.resize(levels);
+
+	for (uint32_t mip = 0; mip < levels; ++mip)
+		pyramid.MipViews[mip] = Utility::CreateImageView(pyramid.Image.Image, pyramid.Image.Format, VK_IMAGE_ASPECT_COLOR_BIT, mip, 1);
+
+	// Letta solo con texelFetch (mip esplicita): nessun filtro
+	VkSamplerCreateInfo sampler_info = {};
+	sampler_info.sType					= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter				= VK_FILTER_NEAREST;
+	sampler_info.minFilter				= VK_FILTER_NEAREST;
+	sampler_info.mipmapMode				= VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.minLod					= 0.0f;
+	sampler_info.maxLod					= static_cast<float>(levels);
+	sampler_info.unnormalizedCoordinates = VK_FALSE;
+
+	pyramid.Image.Sampler = Utility::CreateSampler(sampler_info);
+
+	// La piramide resta in GENERAL per tutta la sua vita: il culling del primo frame la legge prima che sia mai stata scritta
+	VkCommandBuffer command_buffer = BeginCommandBuffer();
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout						= VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout						= VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.image							= pyramid.Image.Image;
+	barrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel	= 0;
+	barrier.subresourceRange.levelCount		= levels;
+	barrier.subresourceRange.baseArrayLayer	= 0;
+	barrier.subresourceRange.layerCount		= 1;
+	barrier.srcAccessMask					= 0;
+	barrier.dstAccessMask					= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	EndAndSubmitCommandBuffer(command_buffer);
 }
 
-void Utility::CreatePositionBufferImage(BufferImage& image, const VkExtent2D& image_extent)
+void Utility::DestroyHiZPyramid(HiZPyramid& pyramid)
 {
-	const std::vector<VkFormat> formats = { VK_FORMAT_R32G32B32A32_SFLOAT };
-	const VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
-	const VkFormatFeatureFlags format_flags = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	for (auto mip_view : pyramid.MipViews)
+		vkDestroyImageView(m_MainDevice->LogicalDevice, mip_view, nullptr);
 
-	image.Format = Utility::ChooseSupportedFormat(formats, tiling, format_flags);
+	pyramid.MipViews.clear();
+
+	DestroyBufferImage(pyramid.Image);
+}
+
+void Utility::CreateGBufferImage(BufferImage& image, const VkExtent2D& image_extent, const VkFormat format,
+	const VkImageUsageFlags usage, const VkImageAspectFlags aspect_flags)
+{
+	image.Format = format;
 
 	ImageInfo image_info = {};
-	image_info.width = image_extent.width;
-	image_info.height = image_extent.height;
-	image_info.format = image.Format;
-	image_info.tiling = tiling;
-	image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-	image_info.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	image_info.width		= image_extent.width;
+	image_info.height		= image_extent.height;
+	image_info.format		= image.Format;
+	image_info.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage		= usage;
+	image_info.properties	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
 	image.Image = Utility::CreateImage(image_info, &image.Memory);
 
-	image.ImageView = Utility::CreateImageView(image.Image, image.Format, VK_IMAGE_ASPECT_COLOR_BIT);
+	image.ImageView = Utility::CreateImageView(image.Image, image.Format, aspect_flags);
 
 	{
 		VkSamplerCreateInfo samplerCreateInfo = {};
@@ -381,6 +451,13 @@ void Utility::CreatePositionBufferImage(BufferImage& image, const VkExtent2D& im
 	}
 }
 
+void Utility::DestroyBufferImage(BufferImage& image)
+{
+	vkDestroySampler(m_MainDevice->LogicalDevice, image.Sampler, nullptr);
+	vkDestroyImageView(m_MainDevice->LogicalDevice, image.ImageView, nullptr);
+	DestroyImage(image.Image, image.Memory);
+}
+
 VkSampler Utility::CreateSampler(const VkSamplerCreateInfo& sampler_create_info) {
 	VkSampler sampler;
 	VkResult result = vkCreateSampler(m_MainDevice->LogicalDevice, &sampler_create_info, nullptr, &sampler);
@@ -489,6 +566,18 @@ void Utility::GetPossibleQueueFamilyIndices(const VkPhysicalDevice &possible_phy
 
 			VkBool32 presentation_support = false;
 
+			// Headless rendering: no surface to present to, the graphics queue does everything
+			if (*m_Surface == VK_NULL_HANDLE)
+			{
+				queue_family_indices.PresentationFamily = queue_family_indices.GraphicsFamily;
+
+				if (queue_family_indices.GraphicsFamily != UINT_MAX)
+					break;
+
+				++queue_index;
+				continue;
+			}
+
 			/*	Query per chiedere se  supportata la Presentation Mode nella Queue Family.
 				Solitamente le Queue Family appartenenti alla grafica la supportano.
 				Questa caratteristica  obbligatoria per presentare l'immagine dalla SwapChain alla Surface.*/
@@ -508,6 +597,21 @@ void Utility::GetPossibleQueueFamilyIndices(const VkPhysicalDevice &possible_phy
 			++queue_index;
 		}
 	}
+
+	// Una Queue Family con solo TRANSFER (il DMA engine delle GPU dedicate) esegue gli upload
+	// senza togliere tempo alla queue grafica; in mancanza si usa la queue grafica stessa.
+	queue_family_indices.TransferFamily = queue_family_indices.GraphicsFamily;
+
+	for (uint32_t i = 0; i < queue_family_count; ++i)
+	{
+		const VkQueueFlags flags = queue_family_list[i].queueFlags;
+
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && queue_family_list[i].queueCount > 0)
+		{
+			queue_family_indices.TransferFamily = i;
+			break;
+		}
+	}
 }
 
 bool Utility::CheckPossibleDeviceExtensionSupport(const VkPhysicalDevice& possible_physical_device, const std::vector<const char*>& requested_device_extensions)
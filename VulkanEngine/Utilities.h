@@ -3,9 +3,11 @@
 #include "pch.h"
 
 #include "Mesh.h"
+#include "MemoryAllocator.h"
 
 int constexpr MAX_FRAMES_IN_FLIGHT	= 3;
 int constexpr MAX_OBJECTS			= 20;
+int constexpr MAX_BINDLESS_TEXTURES	= 4096;	// Upper bound of the bindless array, clamped to the device limits
 
 class Utility
 {
@@ -19,20 +21,30 @@ public:
 	static bool CheckPossibleDeviceExtensionSupport(const VkPhysicalDevice& potential_phys_dev, const std::vector<const char*>& requested_dev_ext);
 
 	/* IMAGES */
-	static VkImage CreateImage(const ImageInfo& image_info, VkDeviceMemory* image_memory);
-	static VkImageView CreateImageView(const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspect_flags);
+	static VkImage CreateImage(const ImageInfo& image_info, Allocation* image_memory);
+	static VkImageView CreateImageView(const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspect_flags,
+		uint32_t base_mip = 0, uint32_t mip_count = 1);
 	static VkSampler CreateSampler(const VkSamplerCreateInfo& sampler_create_info);
 	static void CreateDepthBufferImage(BufferImage& image, const VkExtent2D &img_extent);
-	static void CreatePositionBufferImage(BufferImage& image, const VkExtent2D& image_extent);
 	static void CreateColorBufferImage(BufferImage& image, const VkExtent2D& img_extent);
+	static void CreateNormalBufferImage(BufferImage& image, const VkExtent2D& img_extent);
+	static void CreateGBufferDepthImage(BufferImage& image, const VkExtent2D& img_extent);
+	static void CreateLightingBufferImage(BufferImage& image, const VkExtent2D& img_extent);
+	static void CreateHiZPyramid(HiZPyramid& pyramid, const VkExtent2D& img_extent);
+	static VkFormat ChooseAlbedoBufferFormat();
+	static VkFormat ChooseNormalBufferFormat();
+	static VkFormat ChooseGBufferDepthFormat();
+	static void DestroyBufferImage(BufferImage& image);
+	static void DestroyHiZPyramid(HiZPyramid& pyramid);
+	static void DestroyImage(const VkImage& image, Allocation& image_memory);
 	
 	/* MEMORY */
 	static uint32_t FindMemoryTypeIndex(uint32_t supportedMemoryTypes, const VkMemoryPropertyFlags& properties);
 	
 	/* BUFFERS */
-	static void CreateBuffer(const BufferSettings& buffer_settings, VkBuffer* data, VkDeviceMemory* memory);
+	static void CreateBuffer(const BufferSettings& buffer_settings, VkBuffer* data, Allocation* memory);
+	static void DestroyBuffer(const VkBuffer& buffer, Allocation& memory);
 	static void CopyBufferCmd(const VkBuffer& src_buffer, const VkBuffer& dst_buffer, const VkDeviceSize& buffer_size);
-	static void CopyImageBuffer(const VkBuffer& src, const VkImage& image, const uint32_t width, const uint32_t height);
 
 	/* DYNAMIC UBO (SE NECESSARIO FARE UNA CLASSE PER I D-UBO)*/
 	//static Model* AllocateDynamicBufferTransferSpace(VkDeviceSize minUniformBufferOffset);
@@ -58,6 +70,9 @@ public:
 private:
 	Utility() = default;
 
+	static void CreateGBufferImage(BufferImage& image, const VkExtent2D& image_extent, const VkFormat format,
+		const VkImageUsageFlags usage, const VkImageAspectFlags aspect_flags);
+
 	static MainDevice*		m_MainDevice;
 	static VkSurfaceKHR*	m_Surface;
 	static VkCommandPool*	m_CommandPool;
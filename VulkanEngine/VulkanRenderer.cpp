@@ -1,30 +1,56 @@
 #include "pch.h"
 
 #include "VulkanRenderer.h"
+#include "ThreadPool.h"
 
 VulkanRenderer::VulkanRenderer()
 {
 	m_VulkanInstance					= 0;
 	m_Surface							= 0;
-	m_PushCostantRange					= {};
 	m_GraphicsQueue						= 0;
 	m_PresentationQueue					= 0;
+	m_TransferQueue						= 0;
+	m_TransferCommandPool				= 0;
 	m_MainDevice.LogicalDevice			= 0;
 	m_MainDevice.PhysicalDevice			= 0;
 	m_VPData.proj		= glm::mat4(1.f);
 	m_VPData.view			= glm::mat4(1.f);
+	m_VPData.inv_view_proj	= glm::mat4(1.f);
 	m_MainDevice.MinUniformBufferOffset	= 0;
+	m_MainDevice.MinStorageBufferOffset	= 0;
+	m_MainDevice.MultiDrawIndirect			= false;
+	m_MainDevice.DrawIndirectFirstInstance	= false;
+	m_MainDevice.DrawIndexedIndirectCount	= nullptr;
+	m_MainDevice.BindlessTextures			= false;
+	m_MainDevice.MaxBindlessTextures		= 0;
+	m_TiledStatsOffsets.fill(UINT32_MAX);
+	m_DrawListSetVersions.fill(UINT64_MAX);
 	
 	m_RenderPassHandler			= RenderPassHandler(&m_MainDevice, &m_SwapChain);
 	m_Descriptors				= Descriptors(&m_MainDevice.LogicalDevice);
 	m_SwapChain					= SwapChain(&m_MainDevice, &m_Surface, m_Window, m_QueueFamilyIndices);
 	m_GraphicPipeline			= GraphicPipeline(&m_MainDevice, &m_SwapChain, &m_RenderPassHandler);
+	m_ComputePipeline			= ComputePipeline(&m_MainDevice);
 	m_CommandHandler			= CommandHandler(&m_MainDevice, &m_GraphicPipeline, &m_RenderPassHandler);
 	m_OffScreenCommandHandler	= CommandHandler(&m_MainDevice, &m_GraphicPipeline, &m_RenderPassHandler);
+	m_GPUProfiler				= GPUProfiler(&m_MainDevice);
+	m_UniformRing				= UniformRing(&m_MainDevice);
+	m_LightManager				= LightManager(&m_MainDevice);
+	m_ObjectBuffer				= ObjectBuffer(&m_MainDevice);
+	m_DrawList					= DrawList(&m_MainDevice);
+
+	m_CommandHandler.SetProfiler(&m_GPUProfiler);
+	m_OffScreenCommandHandler.SetProfiler(&m_GPUProfiler);
+	m_CommandHandler.SetComputePipeline(&m_ComputePipeline);
+	m_OffScreenCommandHandler.SetComputePipeline(&m_ComputePipeline);
 }
 
 int VulkanRenderer::Init(Window* window)
 {
+#ifdef HEADLESS_ONLY
+	std::cerr << "This build has no GLFW support, only InitHeadless is available" << std::endl;
+	return EXIT_FAILURE;
+#else
 	m_Window = window;
 
 	if (!m_Window)
@@ -33,6 +59,24 @@ int VulkanRenderer::Init(Window* window)
 		return EXIT_FAILURE;
 	}
 
+	return InitRenderer();
+#endif
+}
+
+int VulkanRenderer::InitHeadless(uint32_t width, uint32_t height)
+{
+	m_Headless	= true;
+	m_Window	= nullptr;
+
+	// Without a surface there is nothing to present to, the swapchain extension is not needed
+	m_RequestedDeviceExtensions.clear();
+	m_SwapChain.SetHeadlessExtent({ width, height });
+
+	return InitRenderer();
+}
+
+int VulkanRenderer::InitRenderer()
+{
 	try
 	{
 		// Setting up global pointers 
@@ -41,6 +85,12 @@ int VulkanRenderer::Init(Window* window)
 		// Instance + Surface + Physical Device + Logical Device
 		CreateKernel();
 
+		// Device memory blocks shared by buffers and images
+		MemoryAllocator::GetInstance()->Init(&m_MainDevice);
+
+		// Vertex e index buffer condivisi da tutte le mesh
+		GeometryArena::GetInstance()->Init(&m_MainDevice, m_VertexFormat);
+
 		// Swapchain creation
 		m_SwapChain.CreateSwapChain();
 
@@ -50,33 +100,45 @@ int VulkanRenderer::Init(Window* window)
 			
 		// Creation of set layouts
 		m_Descriptors.CreateSetLayouts();
+
+		// Bindless: the G-buffer pipeline reads every texture from one array in set 1
+		if (m_MainDevice.BindlessTextures)
+			m_Descriptors.CreateBindlessTextureSetLayout(m_MainDevice.MaxBindlessTextures);
+
 		VkDescriptorSetLayout vp_set_layout		= m_Descriptors.GetViewProjectionSetLayout();
-		VkDescriptorSetLayout tex_set_layout	= m_Descriptors.GetTextureSetLayout();
+		VkDescriptorSetLayout tex_set_layout	= m_MainDevice.BindlessTextures ? m_Descriptors.GetBindlessTextureSetLayout() : m_Descriptors.GetTextureSetLayout();
 		VkDescriptorSetLayout inp_set_layout	= m_Descriptors.GetInputSetLayout();
 		VkDescriptorSetLayout light_set_layout	= m_Descriptors.GetLightSetLayout();
 		VkDescriptorSetLayout settings_set_layout	= m_Descriptors.GetSettingsSetLayout();
+		VkDescriptorSetLayout tiled_set_layout		= m_Descriptors.GetTiledLightingSetLayout();
+		VkDescriptorSetLayout composite_set_layout	= m_Descriptors.GetCompositeSetLayout();
+		VkDescriptorSetLayout cluster_set_layout	= m_Descriptors.GetClusterSetLayout();
+		VkDescriptorSetLayout object_set_layout		= m_Descriptors.GetObjectSetLayout();
+		VkDescriptorSetLayout hiz_set_layout		= m_Descriptors.GetHiZSetLayout();
+		VkDescriptorSetLayout cull_set_layout		= m_Descriptors.GetCullSetLayout();
 
 		// Setting descriptor layouts on the pipeline
 		m_GraphicPipeline.SetDescriptorSetLayouts(vp_set_layout, tex_set_layout, inp_set_layout, light_set_layout, settings_set_layout);
-
-		// Setting up PushCostant on the pipeline
-		SetupPushCostantRange();
-		m_GraphicPipeline.SetPushCostantRange(m_PushCostantRange);
+		m_GraphicPipeline.SetCompositeSetLayout(composite_set_layout);
+		m_GraphicPipeline.SetClusterSetLayout(cluster_set_layout);
+		m_GraphicPipeline.SetObjectSetLayout(object_set_layout);
+		m_ComputePipeline.SetDescriptorSetLayouts(inp_set_layout, tiled_set_layout, vp_set_layout, settings_set_layout);
+		m_ComputePipeline.SetCullingSetLayouts(hiz_set_layout, cull_set_layout, object_set_layout);
 
 		// Creating the first pipeline
 		m_GraphicPipeline.CreateGraphicPipeline();
 
+		// Tiled lighting compute pipeline
+		m_ComputePipeline.CreateTiledLightingPipeline();
+
+		// GPU culling: Hi-Z build + frustum/occlusion test of the indirect commands
+		m_ComputePipeline.CreateHiZPipeline();
+		m_ComputePipeline.CreateCullingPipeline();
+
 		// Creation of the offscreen buffer images
-		m_PositionBufferImages.resize(m_SwapChain.SwapChainImagesSize());
-		m_ColorBufferImages.resize(m_SwapChain.SwapChainImagesSize());
-		m_NormalBufferImages.resize(m_SwapChain.SwapChainImagesSize());
+		CreateGBufferImages();
 
-		for (size_t i = 0; i < m_ColorBufferImages.size(); i++)
-		{
-			Utility::CreatePositionBufferImage(m_PositionBufferImages[i], m_SwapChain.GetExtent());
-			Utility::CreatePositionBufferImage(m_ColorBufferImages[i], m_SwapChain.GetExtent());
-			Utility::CreatePositionBufferImage(m_NormalBufferImages[i], m_SwapChain.GetExtent());
-		}
+		Utility::CreateHiZPyramid(m_HiZ, m_SwapChain.GetExtent());
 
 		Utility::CreateDepthBufferImage(m_DepthBufferImage, m_SwapChain.GetExtent());
 
@@ -93,9 +155,16 @@ int VulkanRenderer::Init(Window* window)
 		m_CommandHandler.CreateCommandPool(m_QueueFamilyIndices);
 		m_CommandHandler.CreateCommandBuffers(m_SwapChain.FrameBuffersSize());
 
-		// Creation of Command Pool + Command Buffers for the second pipeline
+		// Creation of Command Pool + Command Buffers for the second pipeline (one per frame in flight, reused while the scene does not change)
 		m_OffScreenCommandHandler.CreateCommandPool(m_QueueFamilyIndices);
-		m_OffScreenCommandHandler.CreateCommandBuffers(m_SwapChain.FrameBuffersSize());
+		m_OffScreenCommandHandler.CreateCommandBuffers(MAX_FRAMES_IN_FLIGHT * m_SwapChain.FrameBuffersSize());
+		m_OffScreenCommandHandler.CreateSecondaryCommandBuffers(m_QueueFamilyIndices, m_SwapChain.FrameBuffersSize());
+
+		// Command Pool for the uploads on the transfer queue
+		CreateTransferCommandPool();
+
+		// Timestamp queries for the GPU frame time
+		m_GPUProfiler.CreateQueryPool(m_QueueFamilyIndices.GraphicsFamily);
 
 		// Sampler
 		m_TextureObjects.CreateSampler(m_MainDevice);
@@ -104,13 +173,27 @@ int VulkanRenderer::Init(Window* window)
 		CreateUniformBuffers();
 
 		// Creation of Descriptor Pools
-		m_Descriptors.CreateDescriptorPools(m_SwapChain.SwapChainImagesSize(), m_ViewProjectionUBO.size(), m_LightUBO.size(), m_SettingsUBO.size());
+		m_Descriptors.CreateDescriptorPools(m_SwapChain.SwapChainImagesSize());
 
 		// Creation of Descriptor Sets
-		m_Descriptors.CreateViewProjectionDescriptorSets(m_ViewProjectionUBO, sizeof(ViewProjectionData), m_SwapChain.SwapChainImagesSize());
-		m_Descriptors.CreateInputAttachmentsDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_PositionBufferImages, m_ColorBufferImages, m_NormalBufferImages);
-		m_Descriptors.CreateLightDescriptorSets(m_LightUBO, sizeof(LightData), m_SwapChain.SwapChainImagesSize());
-		m_Descriptors.CreateSettingsDescriptorSets(m_SettingsUBO, sizeof(SettingsData), m_SwapChain.SwapChainImagesSize());
+		m_Descriptors.CreateViewProjectionDescriptorSet(m_UniformRing.GetBuffer(), sizeof(ViewProjectionData));
+		m_Descriptors.CreateInputAttachmentsDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_GBufferDepthImages, m_ColorBufferImages, m_NormalBufferImages);
+		m_Descriptors.CreateLightDescriptorSet(m_LightManager.GetBuffer(), m_LightManager.GetSliceSize());
+		m_Descriptors.CreateSettingsDescriptorSet(m_UniformRing.GetBuffer(), sizeof(SettingsData));
+		m_Descriptors.CreateTiledLightingDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_LightManager.GetBuffer(),
+			m_LightManager.GetSliceSize(), m_UniformRing.GetBuffer(), m_LightingBufferImages);
+		m_Descriptors.CreateCompositeDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_LightingBufferImages);
+		m_Descriptors.CreateClusterDescriptorSet(m_LightManager.GetBuffer(), m_LightManager.GetSliceSize(),
+			m_UniformRing.GetBuffer(), LightClusters::MaxByteSize());
+		m_Descriptors.CreateObjectDescriptorSet(m_ObjectBuffer.GetBuffer(), m_ObjectBuffer.GetSliceSize());
+		m_Descriptors.CreateHiZDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_GBufferDepthImages, m_HiZ);
+		m_Descriptors.CreateCullDescriptorSet(m_UniformRing.GetBuffer(), m_HiZ);
+
+		if (m_MainDevice.BindlessTextures)
+		{
+			m_Descriptors.CreateBindlessTextureDescriptorSet();
+			m_TextureObjects.BindlessDescriptorSet = m_Descriptors.GetBindlessTextureSet();
+		}
 
 		// Creation of Syn Objects
 		CreateSynchronizationObjects();
@@ -121,15 +204,24 @@ int VulkanRenderer::Init(Window* window)
 		// Init the Textures
 		TextureLoader::GetInstance()->Init(GetRenderData(), &m_TextureObjects);
 
+		// Every staging copy of the loading goes in a single batch, submitted once
+		UploadBatch upload_batch = CreateUploadBatch();
+
 		// Loading the scene
 		m_Scene.PassRenderData(GetRenderData());
-		m_Scene.LoadScene(m_MeshList, m_TextureObjects);
+		m_Scene.LoadScene(m_MeshList, m_TextureObjects, upload_batch);
 
-		// Create the models
-		CreateMeshModel("Models/Vivi_Final.obj");
-		CreateMeshModel("Models/Vivi_Final.obj");
-		CreateMeshModel("Models/Vivi_Final.obj");
-		CreateMeshModel("Models/FloorTiledMarble.fbx");
+		// Create the models (the copies of Vivi are instances of model 0, added by the application)
+		CreateMeshModel("Models/Vivi_Final.obj", upload_batch);
+		CreateMeshModel("Models/FloorTiledMarble.fbx", upload_batch);
+
+		// The first frame needs the data: this is the only wait of the whole loading
+		upload_batch.Wait();
+
+#ifdef ENABLED_VALIDATION_LAYERS
+		MemoryAllocator::GetInstance()->DumpStatistics(std::cout);
+		GeometryArena::GetInstance()->DumpStatistics(std::cout);
+#endif
 	}
 	catch (std::runtime_error& e)
 	{
@@ -139,16 +231,33 @@ int VulkanRenderer::Init(Window* window)
 	return 0;
 }
 
+// G-buffer compatto: albedo RGBA8 sRGB + normali ottaedriche RG16 + depth campionabile (una per immagine,
+// il lighting pass di un frame la legge mentre il frame successivo pu gi riempire la propria)
+void VulkanRenderer::CreateGBufferImages()
+{
+	m_ColorBufferImages.resize(m_SwapChain.SwapChainImagesSize());
+	m_NormalBufferImages.resize(m_SwapChain.SwapChainImagesSize());
+	m_GBufferDepthImages.resize(m_SwapChain.SwapChainImagesSize());
+	m_LightingBufferImages.resize(m_SwapChain.SwapChainImagesSize());
+
+	for (size_t i = 0; i < m_ColorBufferImages.size(); i++)
+	{
+		Utility::CreateColorBufferImage(m_ColorBufferImages[i], m_SwapChain.GetExtent());
+		Utility::CreateNormalBufferImage(m_NormalBufferImages[i], m_SwapChain.GetExtent());
+		Utility::CreateGBufferDepthImage(m_GBufferDepthImages[i], m_SwapChain.GetExtent());
+		Utility::CreateLightingBufferImage(m_LightingBufferImages[i], m_SwapChain.GetExtent());
+	}
+}
+
 void VulkanRenderer::CreateOffScreenFrameBuffer() {
 	m_OffScreenFrameBuffer.resize(m_SwapChain.FrameBuffersSize());
 
 	for (uint32_t i = 0; i < m_SwapChain.FrameBuffersSize(); ++i)
 	{
-		std::array<VkImageView, 4> attachments = {
-			m_PositionBufferImages[i].ImageView,
+		std::array<VkImageView, 3> attachments = {
 			m_ColorBufferImages[i].ImageView,
 			m_NormalBufferImages[i].ImageView,
-			m_DepthBufferImage.ImageView
+			m_GBufferDepthImages[i].ImageView
 		};
 
 		VkFramebufferCreateInfo frameBufferCreateInfo = {};
@@ -177,7 +286,37 @@ void VulkanRenderer::UpdateModel(int modelID, glm::mat4 newModel)
 
 	if (modelID >= m_MeshModelList.size())
 		return;
-	m_MeshModelList[modelID].SetModel(newModel);
+
+	// Normal matrix calcolata una volta qui, nell'object buffer si copia solo questo oggetto
+	MeshModel& mesh_model = m_MeshModelList[modelID];
+	mesh_model.SetModel(newModel);
+	m_ObjectBuffer.Update(mesh_model.GetObjectID(0), mesh_model.GetObjectData(0));
+}
+
+// Nuova copia di un modello gi caricato: nessun upload, solo una model matrix in pi nella sua draw instanced
+uint32_t VulkanRenderer::AddModelInstance(int modelID, const glm::mat4& model)
+{
+	if (modelID < 0 || modelID >= static_cast<int>(m_MeshModelList.size()))
+		throw std::runtime_error("Attempted to instance an invalid model!");
+
+	MeshModel& mesh_model = m_MeshModelList[modelID];
+
+	const uint32_t instance = mesh_model.AddInstance(model);
+	mesh_model.SetObjectID(instance, m_ObjectBuffer.Add(mesh_model.GetObjectData(instance)));
+
+	++m_SceneVersion;	// instanceCount e firstInstance dei comandi indirect cambiano
+
+	return instance;
+}
+
+void VulkanRenderer::UpdateModelInstance(int modelID, uint32_t instance, const glm::mat4& model)
+{
+	if (modelID < 0 || modelID >= static_cast<int>(m_MeshModelList.size()))
+		return;
+
+	MeshModel& mesh_model = m_MeshModelList[modelID];
+	mesh_model.SetInstance(instance, model);
+	m_ObjectBuffer.Update(mesh_model.GetObjectID(instance), mesh_model.GetObjectData(instance));
 }
 
 void VulkanRenderer::UpdateCameraPosition(const glm::mat4& view_matrix)
@@ -187,45 +326,132 @@ void VulkanRenderer::UpdateCameraPosition(const glm::mat4& view_matrix)
 
 void VulkanRenderer::UpdateLightPosition(unsigned int lightID, const glm::vec3& pos)
 {
-	if (lightID >= m_LightData.size())
+	if (lightID >= m_SceneLights.size())
 		return;
-	m_LightData[lightID].m_LightPosition = pos;
+	m_LightManager.SetPosition(m_SceneLights[lightID], pos);
 }
 
 void VulkanRenderer::UpdateLightColour(unsigned int lightID, const glm::vec3& col)
 {
-	if (lightID >= m_LightData.size())
+	if (lightID >= m_SceneLights.size())
+		return;
+	m_LightManager.SetColour(m_SceneLights[lightID], col);
+}
+
+void VulkanRenderer::UpdateLightRadius(unsigned int lightID, float radius)
+{
+	if (lightID >= m_SceneLights.size())
 		return;
-	m_LightData[lightID].m_Colour = col;
+	m_LightManager.SetRadius(m_SceneLights[lightID], radius);
+}
+
+// Le luci aggiunte partono con i valori di default di LightData, il chiamante le posiziona e colora
+void VulkanRenderer::SetLightCount(uint32_t count)
+{
+	while (m_SceneLights.size() > count)
+	{
+		m_LightManager.Remove(m_SceneLights.back());
+		m_SceneLights.pop_back();
+	}
+
+	while (m_SceneLights.size() < count)
+		m_SceneLights.push_back(m_LightManager.Add(LightData()));
 }
 
 void VulkanRenderer::Draw(ImDrawData *draw_data)
 {
+	auto const wait_begin = std::chrono::high_resolution_clock::now();
+
 	vkWaitForFences(m_MainDevice.LogicalDevice, 1, &m_SyncObjects[m_CurrentFrame].InFlight, VK_TRUE, std::numeric_limits<uint64_t>::max());
 
+	m_FenceWaitMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - wait_begin).count();
+
+	// Staging memory of the uploads already landed goes back to the allocator, with the draw buffers no frame in flight reads
+	RetireUploads(false);
+	m_DrawList.DestroyRetiredBuffers(m_FrameCount);
+
 	vkResetFences(m_MainDevice.LogicalDevice, 1, &m_SyncObjects[m_CurrentFrame].InFlight); // InFlight messo ad UNSIGNALED
+
+	// The fence guarantees the queries previously written by this frame slot are available
+	m_GPUProfiler.BeginFrame(static_cast<uint32_t>(m_CurrentFrame), m_FrameCount);
 	
 	uint32_t image_idx;
-	VkResult result = vkAcquireNextImageKHR(
-						m_MainDevice.LogicalDevice, m_SwapChain.GetSwapChain(),
-						std::numeric_limits<uint64_t>::max(),
-					    m_SyncObjects[m_CurrentFrame].ImageAvailable, VK_NULL_HANDLE, &image_idx);
+	VkResult result = VK_SUCCESS;
+
+	if (m_Headless)
+	{
+		// One offscreen target per frame in flight, the fence above already guards it
+		image_idx = static_cast<uint32_t>(m_CurrentFrame) % static_cast<uint32_t>(m_SwapChain.SwapChainImagesSize());
+	}
+	else
+	{
+		result = vkAcquireNextImageKHR(
+					m_MainDevice.LogicalDevice, m_SwapChain.GetSwapChain(),
+					std::numeric_limits<uint64_t>::max(),
+					m_SyncObjects[m_CurrentFrame].ImageAvailable, VK_NULL_HANDLE, &image_idx);
+	}
 	
+	// Modelli aggiunti: nuovi comandi indirect, e di conseguenza nuovi command buffer offscreen.
+	// Le copie vanno sulla queue prima del submit del frame, che le vede senza attese sull'host
+	if (!m_DrawList.IsUpToDate(m_SceneVersion))
+	{
+		UploadBatch upload_batch = CreateUploadBatch();
+
+		m_DrawList.Build(m_MeshModelList, m_SceneVersion, upload_batch, m_FrameCount);
+
+		upload_batch.Submit();
+
+		if (upload_batch.IsSubmitted())
+			m_PendingUploads.push_back(upload_batch);
+	}
+
+	// I set degli altri slot possono essere ancora in uso dai frame in volo: ogni slot riscrive il proprio dopo la sua fence
+	if (m_DrawListSetVersions[m_CurrentFrame] != m_DrawList.GetSceneVersion() && m_DrawList.GetBuffer() != VK_NULL_HANDLE)
+	{
+		m_Descriptors.UpdateCullBuffers(m_CurrentFrame, m_DrawList.GetBuffer(), m_DrawList.GetCullInputBuffer(),
+			m_DrawList.GetCulledBuffer(), m_DrawList.GetCountBuffer(),
+			m_DrawList.GetDrawInstanceBuffer(), m_DrawList.GetInstanceCountBuffer(), m_DrawList.GetCulledInstanceBuffer());
+		m_Descriptors.UpdateDrawInstanceBuffer(m_CurrentFrame, m_DrawList.GetVisibleInstanceBuffer());
+
+		m_DrawListSetVersions[m_CurrentFrame] = m_DrawList.GetSceneVersion();
+	}
+
+	// Render queue: batch per pipeline, texture e profondit (front-to-back per l'early-Z), ordinati ogni frame.
+	// I command buffer offscreen vengono ri-registrati solo quando l'ordine cambia
+	m_DrawList.SortBatches(m_VPData.view, m_NearPlane, m_FarPlane, m_ObjectBuffer);
+
+	// The fence of this frame slot is signaled, its slice of the uniform ring can be overwritten
+	const FrameUniformOffsets uniform_offsets = UpdateUniformBuffersWithData(static_cast<uint32_t>(m_CurrentFrame));
+
+	// Steady state: nothing to record, the command buffer of the slot is submitted again
 	m_OffScreenCommandHandler.RecordOffScreenCommands(
-		draw_data, image_idx, m_SwapChain.GetExtent(), m_OffScreenFrameBuffer,
-		m_MeshList, m_MeshModelList, m_TextureObjects,
-		m_Descriptors.GetDescriptorSets(),
+		draw_data, image_idx, static_cast<uint32_t>(m_CurrentFrame), m_SceneVersion, m_SwapChain.GetExtent(), m_OffScreenFrameBuffer,
+		m_MeshList, m_DrawList, m_TextureObjects,
+		m_Descriptors.GetViewProjectionDescriptorSet(), m_Descriptors.GetObjectDescriptorSet(m_CurrentFrame), uniform_offsets,
 		m_Descriptors.GetInputDescriptorSets(),
-		m_PositionBufferImages, m_ColorBufferImages, m_NormalBufferImages, m_QueueFamilyIndices);
+		m_GBufferDepthImages, m_ColorBufferImages, m_NormalBufferImages,
+		m_HiZ, m_Descriptors.GetHiZDescriptorSets(), m_Descriptors.GetCullDescriptorSet(m_CurrentFrame), m_QueueFamilyIndices);
+
+	// I light volume sommano solo l'illuminazione: le altre viste del G-buffer passano dal fullscreen triangle
+	int lighting_mode = m_SettingsData.lighting_mode;
+
+	if (lighting_mode == LIGHTING_VOLUMES && m_SettingsData.render_target != 3)
+		lighting_mode = LIGHTING_FULLSCREEN;
 
 	m_CommandHandler.RecordCommands(
 		draw_data, image_idx, m_SwapChain.GetExtent(),
 		m_SwapChain.GetFrameBuffers(),
-		m_Descriptors.GetLightDescriptorSets(),
+		m_Descriptors.GetLightDescriptorSet(),
 		m_Descriptors.GetInputDescriptorSets(),
-		m_Descriptors.GetSettingsDescriptorSets());
-			
-	UpdateUniformBuffersWithData(image_idx);
+		m_Descriptors.GetSettingsDescriptorSet(),
+		m_Descriptors.GetViewProjectionDescriptorSet(),
+		uniform_offsets,
+		m_Descriptors.GetTiledLightingDescriptorSets(),
+		m_Descriptors.GetCompositeDescriptorSets(),
+		m_LightingBufferImages,
+		m_Descriptors.GetClusterDescriptorSet(),
+		lighting_mode,
+		m_LightManager.GetCount());
 
 	// Stages dove aspettare che il semaforo sia SIGNALED (all'output del final color)
 	VkPipelineStageFlags waitStages[] =
@@ -235,11 +461,11 @@ void VulkanRenderer::Draw(ImDrawData *draw_data)
 	
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount	= 1;														
+	submitInfo.waitSemaphoreCount	= m_Headless ? 0 : 1;	// Headless: no image to acquire, nothing to wait
 	submitInfo.pWaitSemaphores		= &m_SyncObjects[m_CurrentFrame].ImageAvailable;			
 	submitInfo.pWaitDstStageMask	= waitStages;												
 	submitInfo.commandBufferCount	= 1;														
-	submitInfo.pCommandBuffers		= &m_OffScreenCommandHandler.GetCommandBuffer(image_idx);  
+	submitInfo.pCommandBuffers		= &m_OffScreenCommandHandler.GetOffScreenCommandBuffer(static_cast<uint32_t>(m_CurrentFrame), image_idx);  
 	submitInfo.signalSemaphoreCount = 1;														
 	submitInfo.pSignalSemaphores	= &m_SyncObjects[m_CurrentFrame].OffScreenAvailable;		
 
@@ -250,9 +476,14 @@ void VulkanRenderer::Draw(ImDrawData *draw_data)
 		throw std::runtime_error("Failed to submit Command Buffer to Queue!");
 	}
 
-	// Submit light calculation pipeline
+	// Submit light calculation pipeline: the G-buffer is sampled by the fragment shader or by the tiled lighting compute shader
+	VkPipelineStageFlags lighting_wait_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	submitInfo.waitSemaphoreCount	= 1;
 	submitInfo.pWaitSemaphores		= &m_SyncObjects[m_CurrentFrame].OffScreenAvailable;
+	submitInfo.pWaitDstStageMask	= &lighting_wait_stage;
 	submitInfo.pCommandBuffers		= &m_CommandHandler.GetCommandBuffer(image_idx);
+	submitInfo.signalSemaphoreCount = m_Headless ? 0 : 1;	// Headless: nobody presents, nobody waits
 	submitInfo.pSignalSemaphores	= &m_SyncObjects[m_CurrentFrame].RenderFinished;
 
 	result = vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_SyncObjects[m_CurrentFrame].InFlight);
@@ -262,6 +493,14 @@ void VulkanRenderer::Draw(ImDrawData *draw_data)
 		throw std::runtime_error("Failed to submit Command Buffer to Queue!");
 	}
 
+	++m_FrameCount;
+
+	if (m_Headless)
+	{
+		m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		return;
+	}
+
 	// Presentazione dell'immagine a schermo
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType			   = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -288,6 +527,7 @@ void VulkanRenderer::Draw(ImDrawData *draw_data)
 
 void VulkanRenderer::HandleMinimization()
 {
+#ifndef HEADLESS_ONLY
 	int width = 0, height = 0;
 	glfwGetFramebufferSize(m_Window->getWindow(), &width, &height);
 
@@ -295,13 +535,31 @@ void VulkanRenderer::HandleMinimization()
 		glfwGetFramebufferSize(m_Window->getWindow(), &width, &height);
 		glfwWaitEvents();
 	}
+#endif
 
 	vkDeviceWaitIdle(m_MainDevice.LogicalDevice);
 
 	m_CommandHandler.FreeCommandBuffers();
+	m_OffScreenCommandHandler.FreeCommandBuffers();
+	m_OffScreenCommandHandler.DestroySecondaryCommandBuffers();
 
 	m_GraphicPipeline.DestroyPipeline();
 
+	// Tutto ci che ha la dimensione della vecchia swapchain: G-buffer, lighting, depth, Hi-Z e i framebuffer che li usano
+	for (auto framebuffer : m_OffScreenFrameBuffer)
+		vkDestroyFramebuffer(m_MainDevice.LogicalDevice, framebuffer, nullptr);
+
+	for (size_t i = 0; i < m_ColorBufferImages.size(); i++)
+	{
+		Utility::DestroyBufferImage(m_ColorBufferImages[i]);
+		Utility::DestroyBufferImage(m_NormalBufferImages[i]);
+		Utility::DestroyBufferImage(m_GBufferDepthImages[i]);
+		Utility::DestroyBufferImage(m_LightingBufferImages[i]);
+	}
+
+	Utility::DestroyBufferImage(m_DepthBufferImage);
+	Utility::DestroyHiZPyramid(m_HiZ);
+
 	m_SwapChain.DestroyFrameBuffers();
 	m_SwapChain.DestroySwapChainImageViews();
 	m_SwapChain.DestroySwapChain();
@@ -313,21 +571,35 @@ void VulkanRenderer::HandleMinimization()
 
 	m_GraphicPipeline.CreateGraphicPipeline();
 
-	m_PositionBufferImages.resize(m_SwapChain.SwapChainImagesSize());
-	m_ColorBufferImages.resize(m_SwapChain.SwapChainImagesSize());
-	m_NormalBufferImages.resize(m_SwapChain.SwapChainImagesSize());
+	CreateGBufferImages();
 
-	for (size_t i = 0; i < m_ColorBufferImages.size(); i++)
-	{
-		Utility::CreatePositionBufferImage(m_PositionBufferImages[i], m_SwapChain.GetExtent());
-		Utility::CreatePositionBufferImage(m_ColorBufferImages[i], m_SwapChain.GetExtent());
-		Utility::CreatePositionBufferImage(m_NormalBufferImages[i], m_SwapChain.GetExtent());
-	}
+	Utility::CreateHiZPyramid(m_HiZ, m_SwapChain.GetExtent());
 
 	Utility::CreateDepthBufferImage(m_DepthBufferImage, m_SwapChain.GetExtent());
 
 	m_SwapChain.CreateFrameBuffers(m_DepthBufferImage.ImageView, m_ColorBufferImages);
+	CreateOffScreenFrameBuffer();
 	m_CommandHandler.CreateCommandBuffers(m_SwapChain.FrameBuffersSize());
+
+	// The number of swap chain images can change: the offscreen buffers are per (frame slot, image)
+	m_OffScreenCommandHandler.CreateCommandBuffers(MAX_FRAMES_IN_FLIGHT * m_SwapChain.FrameBuffersSize());
+	m_OffScreenCommandHandler.CreateSecondaryCommandBuffers(m_QueueFamilyIndices, m_SwapChain.FrameBuffersSize());
+
+	// Set che leggono le immagini appena ricreate
+	m_Descriptors.RecreateSwapChainPools(m_SwapChain.SwapChainImagesSize());
+	m_Descriptors.CreateInputAttachmentsDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_GBufferDepthImages, m_ColorBufferImages, m_NormalBufferImages);
+	m_Descriptors.CreateTiledLightingDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_LightManager.GetBuffer(),
+		m_LightManager.GetSliceSize(), m_UniformRing.GetBuffer(), m_LightingBufferImages);
+	m_Descriptors.CreateCompositeDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_LightingBufferImages);
+	m_Descriptors.CreateHiZDescriptorSets(m_SwapChain.SwapChainImagesSize(), m_GBufferDepthImages, m_HiZ);
+	m_Descriptors.CreateCullDescriptorSet(m_UniformRing.GetBuffer(), m_HiZ);
+
+	// I nuovi set del culling non hanno ancora i buffer del DrawList, e la nuova Hi-Z non contiene una depth
+	m_DrawListSetVersions.fill(UINT64_MAX);
+	m_HiZValid = false;
+
+	// Framebuffer, extent e set sono cambiati: ogni command buffer offscreen va ri-registrato
+	m_OffScreenCommandHandler.InvalidateOffScreenCommands();
 }
 
 void VulkanRenderer::CreateInstance()
@@ -346,14 +618,16 @@ void VulkanRenderer::CreateInstance()
 	appInfo.applicationVersion  = VK_MAKE_VERSION(1, 0, 0);			  
 	appInfo.pEngineName			= "VULKAN RENDERER";				  
 	appInfo.engineVersion		= VK_MAKE_VERSION(1, 0, 0);			  
-	appInfo.apiVersion			= VK_API_VERSION_1_0;				  
+	appInfo.apiVersion			= VK_API_VERSION_1_1;	// vkGetPhysicalDeviceFeatures2 per le feature del descriptor indexing
 
 	VkInstanceCreateInfo createInfo = {};
 	createInfo.sType				= VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;	
 	createInfo.pApplicationInfo		= &appInfo;									
 
 	std::vector <const char*> instanceExtensions = std::vector<const char*>(); 
-	LoadGlfwExtensions(instanceExtensions);									   
+
+	if (!m_Headless)
+		LoadGlfwExtensions(instanceExtensions);									   
 	instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);		   
 
 	if (!CheckInstanceExtensionSupport(&instanceExtensions))								
@@ -382,31 +656,61 @@ void VulkanRenderer::CreateInstance()
 void VulkanRenderer::CreateKernel()
 {
 	CreateInstance();
-	CreateSurface();
+
+	if (!m_Headless)
+		CreateSurface();
+
 	RetrievePhysicalDevice();
 	CreateLogicalDevice();
 }
 
 void VulkanRenderer::LoadGlfwExtensions(std::vector<const char*>& instanceExtensions)
 {
+#ifndef HEADLESS_ONLY
 	uint32_t glfwExtensionCount = 0;	
 	const char** glfwExtensions;		
 
 	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount); 
 	for (size_t i = 0; i < glfwExtensionCount; ++i)							 
 		instanceExtensions.push_back(glfwExtensions[i]);
+#endif
 }
 
-void VulkanRenderer::CreateMeshModel(const std::string& file)
+void VulkanRenderer::CreateMeshModel(const std::string& file, UploadBatch& upload_batch)
 {
+	// Stesso file gi caricato e non modificato: nessun import e nessun upload, solo un nuovo riferimento
+	MeshHandle asset = AssetCache::GetInstance()->FindMesh(file);
+
+	if (!asset)
+	{
+		asset = ImportMeshModel(file, upload_batch);
+		AssetCache::GetInstance()->AddMesh(file, asset);
+	}
+
+	MeshModel mesh_Model = MeshModel(asset);
+	mesh_Model.SetObjectID(0, m_ObjectBuffer.Add(mesh_Model.GetObjectData(0)));
+	m_MeshModelList.push_back(mesh_Model);
+
+	++m_SceneVersion;
+}
+
+MeshHandle VulkanRenderer::ImportMeshModel(const std::string& file, UploadBatch& upload_batch)
+{
+	// Modello gi convertito da MeshCooker: niente parsing, i blob mappati vanno dritti nello staging
+	if (CookedMesh::IsUpToDate(file))
+	{
+		CookedMesh cooked;
+
+		if (cooked.Open(CookedMesh::GetCookedPath(file)))
+			return LoadCookedMeshModel(cooked, upload_batch);
+
+		std::cerr << "Invalid cooked file for " << file << ", importing the source" << std::endl;
+	}
+
 	// Import model scene
 	Assimp::Importer importer;
 
-	// aiProcess_Triangulate tutti gli oggetti vengono rappresentati come triangoli
-	// aiProcess_FlipUVs : inverte i texels in modo che possano funzionare con Vulkan
-	// aiProcess_JoinIdenticalVertices : 
-	const aiScene* scene = importer.ReadFile(file, aiProcess_Triangulate | 
-		aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
+	const aiScene* scene = importer.ReadFile(file, MeshImporter::IMPORT_FLAGS);
 	
 	if (!scene)
 	{
@@ -414,28 +718,122 @@ void VulkanRenderer::CreateMeshModel(const std::string& file)
 	}
 
 	// Caricamento delle texture (materials della scena)
-	std::vector<std::string> texture_names = MeshModel::LoadMaterials(scene);
+	std::vector<TextureHandle> textures;
+	const std::vector<int> mat_to_tex = LoadModelTextures(MeshImporter::LoadMaterials(scene), upload_batch, textures);
+
+	std::vector<Mesh> model_meshes = MeshModel::LoadNode(m_MainDevice.PhysicalDevice, m_MainDevice.LogicalDevice,
+		upload_batch, scene->mRootNode, scene, mat_to_tex);
+
+	return AssetCache::MakeMeshHandle(std::move(model_meshes), std::move(textures));
+}
+
+MeshHandle VulkanRenderer::LoadCookedMeshModel(const CookedMesh& cooked, UploadBatch& upload_batch)
+{
+	std::vector<TextureHandle> textures;
+	const std::vector<int> mat_to_tex = LoadModelTextures(cooked.GetMaterials(), upload_batch, textures);
+
+	std::vector<Mesh> model_meshes;
+	model_meshes.reserve(cooked.GetMeshCount());
+
+	for (uint32_t i = 0; i < cooked.GetMeshCount(); ++i)
+	{
+		const CookedMeshEntry& entry = cooked.GetMesh(i);
+
+		// La copia nello staging avviene nel costruttore, il file pu essere chiuso subito dopo
+		model_meshes.push_back(Mesh(m_MainDevice, upload_batch,
+			cooked.GetVertices(i), entry.VertexCount,
+			cooked.GetIndices(i), entry.IndexCount,
+			mat_to_tex[entry.MaterialIndex]));
+	}
+
+	return AssetCache::MakeMeshHandle(std::move(model_meshes), std::move(textures));
+}
+
+std::vector<int> VulkanRenderer::LoadModelTextures(const std::vector<std::string>& texture_names, UploadBatch& upload_batch, std::vector<TextureHandle>& textures)
+{
+	// Texture del modello per nome: quelle gi in cache vengono riutilizzate,
+	// le altre (una sola volta per file) vengono decodificate in parallelo
+	std::map<std::string, TextureHandle> model_textures;
+	std::vector<std::string> texture_files;
+
+	for (const auto& name : texture_names)
+	{
+		if (name.empty() || model_textures.count(name))
+			continue;
+
+		model_textures[name] = AssetCache::GetInstance()->FindTexture(TextureLoader::GetTexturePath(name));
+
+		if (!model_textures[name])
+			texture_files.push_back(name);
+	}
+
+	const std::vector<int> descriptors = TextureLoader::GetInstance()->CreateTextures(texture_files, upload_batch);
+
+	for (size_t i = 0; i < descriptors.size(); i++)
+	{
+		TextureHandle texture = AssetCache::MakeTextureHandle(descriptors[i]);
+		AssetCache::GetInstance()->AddTexture(TextureLoader::GetTexturePath(texture_files[i]), texture);
+
+		model_textures[texture_files[i]] = texture;
+	}
 
 	// Mapping degli ID texture con gli ID dei descirptor 
-	std::vector<int> mat_to_tex(texture_names.size());
+	std::vector<int> mat_to_tex(texture_names.size(), 0);
 
 	for (size_t i = 0; i < texture_names.size(); i++)
 	{
-		if (texture_names[i].empty())
+		if (!texture_names[i].empty())
+			mat_to_tex[i] = model_textures[texture_names[i]]->Descriptor;
+	}
+
+	for (const auto& texture : model_textures)
+		textures.push_back(texture.second);
+
+	return mat_to_tex;
+}
+
+void VulkanRenderer::LoadMeshModel(const std::string& file)
+{
+	UploadBatch upload_batch = CreateUploadBatch();
+
+	CreateMeshModel(file, upload_batch);
+
+	// No host wait: the acquire submitted on the graphics queue orders the copies before the next frames
+	upload_batch.Submit();
+
+	if (upload_batch.IsSubmitted())
+		m_PendingUploads.push_back(upload_batch);
+}
+
+UploadBatch VulkanRenderer::CreateUploadBatch()
+{
+	UploadQueue graphics;
+	graphics.Queue			= m_GraphicsQueue;
+	graphics.CommandPool	= m_CommandHandler.GetCommandPool();
+	graphics.Family			= m_QueueFamilyIndices.GraphicsFamily;
+
+	UploadQueue transfer;
+	transfer.Queue			= m_TransferQueue;
+	transfer.CommandPool	= m_TransferCommandPool;
+	transfer.Family			= m_QueueFamilyIndices.TransferFamily;
+
+	return UploadBatch(m_MainDevice.LogicalDevice, transfer, graphics);
+}
+
+void VulkanRenderer::RetireUploads(bool wait_all)
+{
+	for (auto it = m_PendingUploads.begin(); it != m_PendingUploads.end();)
+	{
+		if (wait_all || it->IsComplete())
 		{
-			mat_to_tex[i] = 0;
+			it->Wait();
+			it = m_PendingUploads.erase(it);
 		}
 		else
 		{
-			mat_to_tex[i] = TextureLoader::GetInstance()->CreateTexture(texture_names[i]);
+			++it;
 		}
 	}
-
-	std::vector<Mesh> model_meshes = MeshModel::LoadNode(m_MainDevice.PhysicalDevice, m_MainDevice.LogicalDevice,
-		m_GraphicsQueue, m_CommandHandler.GetCommandPool(), scene->mRootNode, scene, mat_to_tex);
-
-	MeshModel mesh_Model = MeshModel(model_meshes);
-	m_MeshModelList.push_back(mesh_Model);
 }
 
 bool VulkanRenderer::CheckInstanceExtensionSupport(std::vector<const char*>* extensionsToCheck)
@@ -519,6 +917,7 @@ void VulkanRenderer::RetrievePhysicalDevice()
 	vkGetPhysicalDeviceProperties(m_MainDevice.PhysicalDevice, &deviceProperties);
 
 	m_MainDevice.MinUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;// serve per DYNAMIC UBO
+	m_MainDevice.MinStorageBufferOffset = deviceProperties.limits.minStorageBufferOffsetAlignment;// luci del tiled lighting (DYNAMIC SSBO)
 }
 
 bool VulkanRenderer::CheckDeviceSuitable(VkPhysicalDevice possibleDevice)
@@ -541,10 +940,11 @@ bool VulkanRenderer::CheckDeviceSuitable(VkPhysicalDevice possibleDevice)
 	bool const extensionSupported = Utility::CheckPossibleDeviceExtensionSupport(possibleDevice, m_RequestedDeviceExtensions);
 
 
-	bool swapChainValid	= false;
+	// In headless mode there is no surface to query, the offscreen targets are always valid
+	bool swapChainValid	= m_Headless;
 
 	// Se le estensioni richieste sono supportate (quindi Surface compresa), si procede con la SwapChain
-	if (extensionSupported)
+	if (extensionSupported && !m_Headless)
 	{						
 		SwapChainDetails swapChainDetails = m_SwapChain.GetSwapChainDetails(possibleDevice, m_Surface);
 		swapChainValid = !swapChainDetails.presentationModes.empty() && !swapChainDetails.formats.empty();
@@ -560,7 +960,7 @@ bool VulkanRenderer::CheckDeviceSuitable(VkPhysicalDevice possibleDevice)
 void VulkanRenderer::CreateLogicalDevice()
 {
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> queueFamilyIndices = { m_QueueFamilyIndices.GraphicsFamily , m_QueueFamilyIndices.PresentationFamily };
+	std::set<uint32_t> queueFamilyIndices = { m_QueueFamilyIndices.GraphicsFamily , m_QueueFamilyIndices.PresentationFamily, m_QueueFamilyIndices.TransferFamily };
 
 	// DEVICE QUEUE (Queue utilizzate nel device logico)
 	for (int queueFamilyIndex : queueFamilyIndices)
@@ -575,9 +975,72 @@ void VulkanRenderer::CreateLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);	// Carico la create info dentro un vettore
 	}
 
+	// Estensione opzionale: il culling su GPU compatta le draw e il G-buffer ne legge il numero dal count buffer
+	const bool indirect_count = Utility::CheckPossibleDeviceExtensionSupport(m_MainDevice.PhysicalDevice, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME });
+
+	if (indirect_count)
+		m_RequestedDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+	// Estensione opzionale: texture bindless, un solo array parzialmente riempito indicizzato con l'indice di texture della draw.
+	// Update after bind: le texture caricate a runtime si scrivono nel set mentre i command buffer registrati sono in volo
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(m_MainDevice.PhysicalDevice, &device_properties);
+
+	bool bindless = device_properties.apiVersion >= VK_API_VERSION_1_1 &&
+		Utility::CheckPossibleDeviceExtensionSupport(m_MainDevice.PhysicalDevice, { VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME });
+
+	if (bindless)
+	{
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported_indexing = {};
+		supported_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 supported_features2 = {};
+		supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features2.pNext = &supported_indexing;
+
+		vkGetPhysicalDeviceFeatures2(m_MainDevice.PhysicalDevice, &supported_features2);
+
+		bindless = supported_indexing.shaderSampledImageArrayNonUniformIndexing == VK_TRUE &&
+			supported_indexing.runtimeDescriptorArray == VK_TRUE &&
+			supported_indexing.descriptorBindingPartiallyBound == VK_TRUE &&
+			supported_indexing.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+	}
+
+	// Solo le feature usate dal renderer, agganciate alla create info del device
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features = {};
+	indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	if (bindless)
+	{
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties = {};
+		indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &indexing_properties;
+
+		vkGetPhysicalDeviceProperties2(m_MainDevice.PhysicalDevice, &properties2);
+
+		m_MainDevice.BindlessTextures		= true;
+		m_MainDevice.MaxBindlessTextures	= std::min({ static_cast<uint32_t>(MAX_BINDLESS_TEXTURES),
+			indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+			indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexing_properties.maxDescriptorSetUpdateAfterBindSamplers });
+
+		indexing_features.shaderSampledImageArrayNonUniformIndexing		= VK_TRUE;
+		indexing_features.runtimeDescriptorArray						= VK_TRUE;
+		indexing_features.descriptorBindingPartiallyBound				= VK_TRUE;
+		indexing_features.descriptorBindingSampledImageUpdateAfterBind	= VK_TRUE;
+
+		// VK_KHR_maintenance3, richiesta dall'estensione, fa parte di Vulkan 1.1
+		m_RequestedDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	}
+
 	// LOGICAL DEVICE
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType					 = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;			// Tipo di strutturadati da utilizzare.
+	deviceCreateInfo.pNext					 = bindless ? &indexing_features : nullptr;
 	deviceCreateInfo.queueCreateInfoCount	 = static_cast<uint32_t>(queueCreateInfos.size());	// Numero di queue utilizzate nel device logico (corrispondono al numero di strutture "VkDeviceQueueCreateInfo").
 	deviceCreateInfo.pQueueCreateInfos		 = queueCreateInfos.data();							// Puntatore alle createInfo delle Queue
 	deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(m_RequestedDeviceExtensions.size());	// Numero di estensioni da utilizzare sul dispositivo logico.
@@ -587,6 +1050,16 @@ void VulkanRenderer::CreateLogicalDevice()
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.samplerAnisotropy	= VK_TRUE;
 
+	// Draw indirect del G-buffer: senza queste feature il DrawList torna alle draw dirette
+	VkPhysicalDeviceFeatures supported_features;
+	vkGetPhysicalDeviceFeatures(m_MainDevice.PhysicalDevice, &supported_features);
+
+	deviceFeatures.multiDrawIndirect			= supported_features.multiDrawIndirect;
+	deviceFeatures.drawIndirectFirstInstance	= supported_features.drawIndirectFirstInstance;
+
+	m_MainDevice.MultiDrawIndirect			= supported_features.multiDrawIndirect == VK_TRUE;
+	m_MainDevice.DrawIndirectFirstInstance	= supported_features.drawIndirectFirstInstance == VK_TRUE;
+
 	deviceCreateInfo.pEnabledFeatures	= &deviceFeatures;					// Features del dispositivo fisico che verranno utilizzate nel device logico (al momento nessuna).
 
 
@@ -598,6 +1071,10 @@ void VulkanRenderer::CreateLogicalDevice()
 	if (result != VK_SUCCESS)	// Nel caso in cui il Dispositivo Logico non venga creato con successo alzo un eccezione a runtime.
 		throw std::runtime_error("Failed to create Logical Device!");
 
+	if (indirect_count)
+		m_MainDevice.DrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+			vkGetDeviceProcAddr(m_MainDevice.LogicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+
 	vkGetDeviceQueue(							// Salvo il riferimento della queue grafica del device logico
 		m_MainDevice.LogicalDevice,				// nella variabile m_GraphicsQueue
 		m_QueueFamilyIndices.GraphicsFamily, 
@@ -609,16 +1086,46 @@ void VulkanRenderer::CreateLogicalDevice()
 		m_QueueFamilyIndices.PresentationFamily, // queue grafica, nel caso in cui sia presente una sola Queue nel device 
 		0,										 // allora si avranno due riferimenti 'm_PresentationQueue' e 'm_GraphicsQueue' alla stessa queue
 		&m_PresentationQueue);
+
+	vkGetDeviceQueue(							 // Queue degli upload: coincide con quella grafica se il device
+		m_MainDevice.LogicalDevice,				 // non ha una Queue Family dedicata al transfer
+		m_QueueFamilyIndices.TransferFamily,
+		0,
+		&m_TransferQueue);
 }
 
 void VulkanRenderer::CreateSurface()
 {
+#ifdef HEADLESS_ONLY
+	throw std::runtime_error("This build has no GLFW support, a surface can't be created!");
+#else
 	VkResult res = glfwCreateWindowSurface(m_VulkanInstance, m_Window->getWindow(), nullptr, &m_Surface);
 																		
 	if (res != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create the surface!");
 	}
+#endif
+}
+
+void VulkanRenderer::CreateTransferCommandPool()
+{
+	if (!m_QueueFamilyIndices.HasDedicatedTransfer())
+	{
+		// Same family: the uploads share the pool of the graphics command buffers
+		m_TransferCommandPool = m_CommandHandler.GetCommandPool();
+		return;
+	}
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType				= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags				= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;	// Command buffers da un solo submit
+	pool_info.queueFamilyIndex	= m_QueueFamilyIndices.TransferFamily;
+
+	VkResult result = vkCreateCommandPool(m_MainDevice.LogicalDevice, &pool_info, nullptr, &m_TransferCommandPool);
+
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("Failed to create the transfer Command Pool!");
 }
 
 const int VulkanRenderer::GetCurrentFrame() const
@@ -652,22 +1159,17 @@ void VulkanRenderer::CreateSynchronizationObjects()
 	}
 }
 
-void VulkanRenderer::SetupPushCostantRange()
-{
-	m_PushCostantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;  // Stage dove finiranno le push costant
-	m_PushCostantRange.offset	  = 0;
-	m_PushCostantRange.size		  = sizeof(Model);
-}
-
 void VulkanRenderer::SetUniformDataStructures()
 {
 	// View-Projection
 	float const aspectRatio = static_cast<float>(m_SwapChain.GetExtentWidth()) / static_cast<float>(m_SwapChain.GetExtentHeight());
-	m_VPData.proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.f);
+	m_VPData.proj = glm::perspective(glm::radians(45.0f), aspectRatio, m_NearPlane, m_FarPlane);
 	m_VPData.proj[1][1] = m_VPData.proj[1][1] * -1.0f;
 	m_VPData.view = glm::lookAt(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 1.0f, 0.f));
 
 	// Light
+	SetLightCount(NUM_LIGHTS);
+
 	pcg_extras::seed_seq_from<std::random_device> seed_source;
 	pcg32 rng(seed_source);
 	std::uniform_real_distribution<float> uniform_dist(0.0f, 1.0f);
@@ -696,80 +1198,93 @@ void VulkanRenderer::SetUniformDataStructures()
 		rnd_x = uniform_dist(rng);
 		l2.SetLightPosition(glm::vec4(rnd_r, rnd_g, rnd_b, 1.0f));
 
-		m_LightData[i] = l1.GetUBOData();
-		m_LightData[i + 1] = l2.GetUBOData();
+		m_LightManager.Update(m_SceneLights[i], l1.GetUBOData());
+		m_LightManager.Update(m_SceneLights[i + 1], l2.GetUBOData());
 	}
 
 	m_SettingsData.render_target = 3;
+	m_SettingsData.lighting_mode = LIGHTING_FULLSCREEN;
 }
 
 void VulkanRenderer::CreateUniformBuffers()
 {
-	BufferSettings buffer_settings;
-	buffer_settings.size		= sizeof(m_VPData);
-	buffer_settings.usage		= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-	buffer_settings.properties	= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	// Un'unica slice per frame in flight contiene View-Projection, settings, contatori del tiled lighting, dati del culling e cluster
+	const VkDeviceSize frame_size =
+		m_UniformRing.Align(sizeof(ViewProjectionData)) +
+		m_UniformRing.Align(sizeof(SettingsData)) +
+		m_UniformRing.Align(sizeof(TiledLightingStats)) +
+		m_UniformRing.Align(sizeof(CullData)) +
+		m_UniformRing.Align(LightClusters::MaxByteSize());
+
+	m_UniformRing.CreateBuffer(frame_size);
+
+	// Luci e oggetti hanno un buffer proprio, che cresce con il loro numero
+	m_LightManager.CreateBuffer();
+	m_ObjectBuffer.CreateBuffer();
+}
 
-	// Un UBO per ogni immagine della Swap Chain
-	m_ViewProjectionUBO.resize(m_SwapChain.SwapChainImagesSize());
-	m_ViewProjectionUBOMemory.resize(m_SwapChain.SwapChainImagesSize());
-	
-	/*
-	m_modelDynamicUBO.resize(m_swapChainImages.size());
-	m_modelDynamicUniformBufferMemory.resize(m_swapChainImages.size());*/
+FrameUniformOffsets VulkanRenderer::UpdateUniformBuffersWithData(uint32_t frame)
+{
+	const uint32_t slot = frame % MAX_FRAMES_IN_FLIGHT;
 
-	for (size_t i = 0; i < m_SwapChain.SwapChainImagesSize(); i++)
-	{
-		Utility::CreateBuffer(buffer_settings, &m_ViewProjectionUBO[i], &m_ViewProjectionUBOMemory[i]);
-		/* DYNAMIC UBO
-		createBuffer(m_mainDevice.physicalDevice, m_mainDevice.LogicalDevice,
-			modelBufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&m_modelDynamicUBO[i], &m_modelDynamicUniformBufferMemory[i]);*/
-	}
+	// The fence of this slot is signaled: the counters written by its last tiled lighting dispatch are complete
+	if (m_TiledStatsOffsets[slot] != UINT32_MAX)
+		m_TiledLightingStats = *static_cast<const TiledLightingStats*>(m_UniformRing.GetData(m_TiledStatsOffsets[slot]));
+
+	// The ring is HOST_VISIBLE | HOST_COHERENT and stays mapped for the whole run
+	m_UniformRing.BeginFrame(frame);
 
-	buffer_settings.size = NUM_LIGHTS * sizeof(LightData);
+	m_VPData.inv_view_proj = glm::inverse(m_VPData.proj * m_VPData.view);
 
-	m_LightUBO.resize(m_SwapChain.SwapChainImagesSize());
-	m_LightUBOMemory.resize(m_SwapChain.SwapChainImagesSize());
+	FrameUniformOffsets offsets;
+	offsets.ViewProjection	= m_UniformRing.Push(&m_VPData, sizeof(ViewProjectionData));
+	offsets.Settings		= m_UniformRing.Push(&m_SettingsData, sizeof(SettingsData));
 
-	for (size_t i = 0; i < m_SwapChain.SwapChainImagesSize(); ++i)
+	// Reset here, incremented by the compute shader when a tile has more lights than its list can hold
+	const TiledLightingStats no_stats = {};
+	offsets.TiledStats			= m_UniformRing.Push(&no_stats, sizeof(TiledLightingStats));
+	m_TiledStatsOffsets[slot]	= m_SettingsData.lighting_mode == LIGHTING_TILED ? offsets.TiledStats : UINT32_MAX;
+
+	// Solo gli oggetti spostati dall'ultima scrittura di questa slice vengono copiati. L'offset della slice resta lo stesso
+	// e i command buffer del G-buffer restano validi, tranne quando il buffer cresce (il set degli oggetti viene riscritto)
+	if (m_ObjectBuffer.BeginFrame(frame))
 	{
-		Utility::CreateBuffer(buffer_settings, &m_LightUBO[i], &m_LightUBOMemory[i]);
+		m_Descriptors.UpdateObjectBufferDescriptor(m_ObjectBuffer.GetBuffer(), m_ObjectBuffer.GetSliceSize());
+		m_OffScreenCommandHandler.InvalidateOffScreenCommands();
 	}
 
-	buffer_settings.size = sizeof(SettingsData);
-	m_SettingsUBO.resize(m_SwapChain.SwapChainImagesSize());
-	m_SettingsUBOMemory.resize(m_SwapChain.SwapChainImagesSize());
+	offsets.Objects = m_ObjectBuffer.GetFrameOffset();
+
+	// Culling su GPU: frustum della camera corrente, occlusione contro la depth del frame precedente
+	const glm::mat4 view_proj = m_VPData.proj * m_VPData.view;
+
+	CullData* cull_data = static_cast<CullData*>(m_UniformRing.Reserve(sizeof(CullData), &offsets.Culling));
+	m_DrawList.FillCullData(*cull_data, view_proj, m_PrevViewProj, m_HiZ.MipExtents[0], m_HiZValid);
+
+	// Questo frame (se esegue il culling) ricostruisce la Hi-Z con la propria depth
+	m_PrevViewProj	= view_proj;
+	m_HiZValid		= m_DrawList.IsCullingEnabled();
 
-	for (size_t i = 0; i < m_SwapChain.SwapChainImagesSize(); ++i)
+	// Solo le luci cambiate dall'ultima scrittura di questa slice vengono copiate
+	if (m_LightManager.BeginFrame(frame))
+		m_Descriptors.UpdateLightBufferDescriptors(m_LightManager.GetBuffer(), m_LightManager.GetSliceSize());
+
+	offsets.Lights = m_LightManager.GetFrameOffset();
+
+	m_ClusterBuildMs = 0.0f;
+
+	if (m_SettingsData.lighting_mode == LIGHTING_CLUSTERED)
 	{
-		Utility::CreateBuffer(buffer_settings, &m_SettingsUBO[i], &m_SettingsUBOMemory[i]);
-	}
+		auto const build_begin = std::chrono::high_resolution_clock::now();
 
-}
+		m_LightClusters.Build(m_LightManager.GetLights(), m_VPData.view, m_VPData.proj, m_NearPlane, m_FarPlane);
 
-void VulkanRenderer::UpdateUniformBuffersWithData(uint32_t imageIndex)
-{
-	void* vp_data;
-	vkMapMemory(m_MainDevice.LogicalDevice, m_ViewProjectionUBOMemory[imageIndex], 0, 
-		sizeof(ViewProjectionData), 0, &vp_data);
-	memcpy(vp_data, &m_VPData, sizeof(ViewProjectionData));
-	vkUnmapMemory(m_MainDevice.LogicalDevice, m_ViewProjectionUBOMemory[imageIndex]);
+		m_ClusterBuildMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - build_begin).count();
 
-	void* light_data;
-	auto light_data_size = m_LightData.size() * sizeof(LightData);
-	vkMapMemory(m_MainDevice.LogicalDevice, m_LightUBOMemory[imageIndex], 0, light_data_size, 0, &light_data);
-	memcpy(light_data, m_LightData.data(), light_data_size);
-	vkUnmapMemory(m_MainDevice.LogicalDevice, m_LightUBOMemory[imageIndex]);
+		m_LightClusters.WriteTo(m_UniformRing.Reserve(m_LightClusters.GetByteSize(), &offsets.Clusters));
+	}
 
-	void* settings_data;
-	auto settings_data_size = sizeof(SettingsData);
-	const void* ptr_settings = &m_SettingsData;
-	vkMapMemory(m_MainDevice.LogicalDevice, m_SettingsUBOMemory[imageIndex], 0, settings_data_size, 0, &settings_data);
-	memcpy(settings_data, ptr_settings, settings_data_size);
-	vkUnmapMemory(m_MainDevice.LogicalDevice, m_SettingsUBOMemory[imageIndex]);
+	return offsets;
 }
 
 void VulkanRenderer::Cleanup()
@@ -781,12 +1296,20 @@ void VulkanRenderer::Cleanup()
 	// quindi  corretto aspettare che il dispositivo sia inattivo prima di eliminare gli oggetti.
 	vkDeviceWaitIdle(m_MainDevice.LogicalDevice);
 
+	RetireUploads(true);
+
 	for (size_t i = 0; i < m_MeshModelList.size(); i++)
 	{
 		m_MeshModelList[i].DestroyMeshModel();
 	}
 
-	GUI::GetInstance()->Destroy();
+	// Dropping the last handles destroys the shared meshes and textures
+	AssetCache::GetInstance()->Clear();
+
+#ifndef HEADLESS_ONLY
+	if (!m_Headless)
+		GUI::GetInstance()->Destroy();
+#endif
 
 	m_Descriptors.DestroyImguiPool();
 	m_Descriptors.DestroyTexturePool();
@@ -794,58 +1317,67 @@ void VulkanRenderer::Cleanup()
 
 	vkDestroySampler(m_MainDevice.LogicalDevice, m_TextureObjects.TextureSampler, nullptr);
 
+	// A texture load that failed half-way leaves images without a view
+	for (size_t i = 0; i < m_TextureObjects.TextureImageViews.size(); i++)
+		vkDestroyImageView(m_MainDevice.LogicalDevice, m_TextureObjects.TextureImageViews[i], nullptr);
+
 	for (size_t i = 0; i < m_TextureObjects.TextureImages.size(); i++)
 	{
-		vkDestroyImageView(m_MainDevice.LogicalDevice, m_TextureObjects.TextureImageViews[i], nullptr);
-		vkDestroyImage(m_MainDevice.LogicalDevice, m_TextureObjects.TextureImages[i], nullptr);
-		vkFreeMemory(m_MainDevice.LogicalDevice, m_TextureObjects.TextureImageMemory[i], nullptr);
+		Utility::DestroyImage(m_TextureObjects.TextureImages[i], m_TextureObjects.TextureImageMemory[i]);
 	}
 
 	m_Descriptors.DestroyInputPool();
 	m_Descriptors.DestroyInputAttachmentsLayout();
 	for (size_t i = 0; i < m_ColorBufferImages.size(); i++)
 	{
-		m_PositionBufferImages[i].DestroyAndFree(m_MainDevice);
-		m_ColorBufferImages[i].DestroyAndFree(m_MainDevice);
-		m_NormalBufferImages[i].DestroyAndFree(m_MainDevice);
+		Utility::DestroyBufferImage(m_ColorBufferImages[i]);
+		Utility::DestroyBufferImage(m_NormalBufferImages[i]);
+		Utility::DestroyBufferImage(m_GBufferDepthImages[i]);
+		Utility::DestroyBufferImage(m_LightingBufferImages[i]);
 	}
 
-	m_DepthBufferImage.DestroyAndFree(m_MainDevice);
+	Utility::DestroyBufferImage(m_DepthBufferImage);
+	Utility::DestroyHiZPyramid(m_HiZ);
 	
 	m_Descriptors.DestroyViewProjectionPool();
 	m_Descriptors.DestroyViewProjectionLayout();
 
-	for (size_t i = 0; i < m_ViewProjectionUBO.size(); ++i)
-	{
-		vkDestroyBuffer(m_MainDevice.LogicalDevice, m_ViewProjectionUBO[i], nullptr);
-		vkFreeMemory(m_MainDevice.LogicalDevice, m_ViewProjectionUBOMemory[i], nullptr);
-	}
-
 	m_Descriptors.DestroyLightPool();
 	m_Descriptors.DestroyLightLayout();
 
-	for (size_t i = 0; i < m_LightUBO.size(); ++i)
-	{
-		vkDestroyBuffer(m_MainDevice.LogicalDevice, m_LightUBO[i], nullptr);
-		vkFreeMemory(m_MainDevice.LogicalDevice, m_LightUBOMemory[i], nullptr);
-	}
-
 	m_Descriptors.DestroySettingsPool();
 	m_Descriptors.DestroySettingsLayout();
 
-	for (size_t i = 0; i < m_SettingsUBO.size(); ++i)
-	{
-		vkDestroyBuffer(m_MainDevice.LogicalDevice, m_SettingsUBO[i], nullptr);
-		vkFreeMemory(m_MainDevice.LogicalDevice, m_SettingsUBOMemory[i], nullptr);
-	}
+	m_Descriptors.DestroyTiledLightingPool();
+	m_Descriptors.DestroyTiledLightingLayout();
+
+	m_Descriptors.DestroyCompositePool();
+	m_Descriptors.DestroyCompositeLayout();
 
+	m_Descriptors.DestroyClusterPool();
+	m_Descriptors.DestroyClusterLayout();
+	m_Descriptors.DestroyObjectPool();
+	m_Descriptors.DestroyObjectLayout();
+	m_Descriptors.DestroyHiZPool();
+	m_Descriptors.DestroyHiZLayout();
+	m_Descriptors.DestroyCullPool();
+	m_Descriptors.DestroyCullLayout();
+	m_Descriptors.DestroyBindlessTexturePool();
+	m_Descriptors.DestroyBindlessTextureLayout();
 
+	m_UniformRing.DestroyBuffer();
+	m_DrawList.DestroyBuffer();
+	m_LightManager.DestroyBuffer();
+	m_ObjectBuffer.DestroyBuffer();
 
 	for (size_t i = 0; i < m_MeshList.size(); i++)
 	{
 		m_MeshList[i].destroyBuffers();
 	}
 
+	// Tutte le mesh hanno restituito il loro range, i buffer condivisi possono essere distrutti
+	GeometryArena::GetInstance()->Destroy();
+
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 	{
 		vkDestroySemaphore(m_MainDevice.LogicalDevice, m_SyncObjects[i].RenderFinished, nullptr);
@@ -854,6 +1386,12 @@ void VulkanRenderer::Cleanup()
 		vkDestroyFence(m_MainDevice.LogicalDevice, m_SyncObjects[i].InFlight, nullptr);
 	}
 
+	m_GPUProfiler.DestroyQueryPool();
+
+	if (m_QueueFamilyIndices.HasDedicatedTransfer())
+		vkDestroyCommandPool(m_MainDevice.LogicalDevice, m_TransferCommandPool, nullptr);
+
+	m_OffScreenCommandHandler.DestroySecondaryCommandBuffers();
 	m_OffScreenCommandHandler.DestroyCommandPool();
 	m_CommandHandler.DestroyCommandPool();
 
@@ -862,12 +1400,17 @@ void VulkanRenderer::Cleanup()
 	m_SwapChain.DestroyFrameBuffers();
 
 	m_GraphicPipeline.DestroyPipeline();
+	m_ComputePipeline.DestroyPipeline();
 	m_RenderPassHandler.DestroyRenderPass();
 
 	m_SwapChain.DestroySwapChainImageViews();
 	m_SwapChain.DestroySwapChain();
 
-	vkDestroySurfaceKHR(m_VulkanInstance, m_Surface, nullptr);	// Distrugge la Surface (GLFW si utilizza solo per settarla)
+	// Every buffer and image is gone, the memory blocks can be released
+	MemoryAllocator::GetInstance()->Destroy();
+
+	if (!m_Headless)
+		vkDestroySurfaceKHR(m_VulkanInstance, m_Surface, nullptr);	// Distrugge la Surface (GLFW si utilizza solo per settarla)
 
 #ifdef ENABLED_VALIDATION_LAYERS
 	DebugMessanger::GetInstance()->Clear();
@@ -875,6 +1418,8 @@ void VulkanRenderer::Cleanup()
 
 	vkDestroyDevice(m_MainDevice.LogicalDevice, nullptr);
 	vkDestroyInstance(m_VulkanInstance, nullptr);					
+
+	ThreadPool::GetInstance()->Destroy();
 }
 
 const VulkanRenderData VulkanRenderer::GetRenderData()
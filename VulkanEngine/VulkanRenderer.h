@@ -2,7 +2,11 @@
 
 #include "pch.h"
 
+#ifdef HEADLESS_ONLY
+class Window;
+#else
 #include "Window.h"
+#endif
 #include "Mesh.h"
 #include "Utilities.h"
 #include "DebugMessanger.h"
@@ -10,18 +14,26 @@
 #include "SwapChainHandler.h"
 #include "RenderPassHandler.h"
 #include "GraphicPipeline.h"
+#include "ComputePipeline.h"
 #include "CommandHandler.h"
 #include "DescriptorsHandler.h"
+#include "UniformRing.h"
 #include "Scene.h"
+#ifndef HEADLESS_ONLY
 #include "GUI.h"
+#endif
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "MeshModel.h"
+#include "CookedMesh.h"
 #include "Light.h"
+#include "LightManager.h"
+#include "ObjectBuffer.h"
+#include "DrawList.h"
 
-constexpr std::size_t NUM_LIGHTS = 20;
+constexpr std::size_t NUM_LIGHTS = 20;		// Luci create all'avvio, il LightManager non ha un limite
 
 class VulkanRenderer
 {
@@ -30,17 +42,32 @@ public:
 	~VulkanRenderer();
 
 	int Init(Window* window);
+	int InitHeadless(uint32_t width, uint32_t height);
+	void SetVertexFormat(VertexFormat format) { m_VertexFormat = format; }	// Prima di Init: le mesh vengono caricate nel formato scelto
 	void UpdateModel(int modelID, glm::mat4 newModel);
+	uint32_t AddModelInstance(int modelID, const glm::mat4& model);
+	void UpdateModelInstance(int modelID, uint32_t instance, const glm::mat4& model);
 	void UpdateCameraPosition(const glm::mat4& view_matrix);
 	void UpdateLightPosition(unsigned int lightID, const glm::vec3 &pos);
 	void UpdateLightColour(unsigned int lightID, const glm::vec3 &col);
+	void UpdateLightRadius(unsigned int lightID, float radius);
+	void SetLightCount(uint32_t count);
+	float GetLastClusterBuildTime() const { return m_ClusterBuildMs; }
+	const TiledLightingStats& GetTiledLightingStats() const { return m_TiledLightingStats; }
+	uint32_t GetLightCount() const { return static_cast<uint32_t>(m_SceneLights.size()); }
+	LightManager& GetLightManager() { return m_LightManager; }
 	void Draw(ImDrawData * draw_data);
+	void LoadMeshModel(const std::string& file);
 	void Cleanup();
 
 	const VulkanRenderData GetRenderData();
 	SettingsData* GetUBOSettingsRef();
 
 	int const GetCurrentFrame() const;
+	bool IsHeadless() const { return m_Headless; }
+	const GPUTimings& GetGPUTimings() const { return m_GPUProfiler.GetTimings(); }
+	uint64_t GetFrameCount() const { return m_FrameCount; }
+	float GetLastFenceWaitTime() const { return m_FenceWaitMs; }
 
 private:
 	VkInstance			m_VulkanInstance;
@@ -50,42 +77,55 @@ private:
 	SwapChain			m_SwapChain;
 	RenderPassHandler	m_RenderPassHandler;
 	GraphicPipeline		m_GraphicPipeline;
+	ComputePipeline		m_ComputePipeline;
 	CommandHandler		m_CommandHandler;
 	CommandHandler		m_OffScreenCommandHandler;
 	Descriptors			m_Descriptors;
+	GPUProfiler			m_GPUProfiler;
+	bool				m_Headless = false;	// No window/swapchain, frames are rendered into offscreen images
+	VertexFormat		m_VertexFormat = VertexFormat::Full;	// Layout dei vertici nella GeometryArena
 
-	const std::vector<const char*> m_RequestedDeviceExtensions =
+	std::vector<const char*> m_RequestedDeviceExtensions =
 	{
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
 	int	m_CurrentFrame   = 0;	    
+	uint64_t m_FrameCount = 0;
+	float	 m_FenceWaitMs = 0.0f;	// CPU time spent waiting for a free frame slot in the last Draw
+	float	 m_ClusterBuildMs = 0.0f;	// CPU time of the light assignment to the clusters in the last Draw
+	TiledLightingStats m_TiledLightingStats = {};	// Counters of the last tiled lighting frame whose fence has signaled
+	std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> m_TiledStatsOffsets;	// Ring offset of the counters of each slot, UINT32_MAX if not tiled
 	TextureObjects	  m_TextureObjects;
 
 	QueueFamilyIndices m_QueueFamilyIndices;			
 	VkQueue	m_GraphicsQueue;							
 	VkQueue	m_PresentationQueue;						
+	VkQueue	m_TransferQueue;
+	VkCommandPool m_TransferCommandPool;
 
-	std::vector<BufferImage> m_PositionBufferImages;
-	std::vector<BufferImage> m_ColorBufferImages;
-	std::vector<BufferImage> m_NormalBufferImages;
+	std::vector<UploadBatch> m_PendingUploads;	// Uploads submitted during the session, waiting for their fence
+
+	std::vector<BufferImage> m_ColorBufferImages;		// Albedo (RGBA8 sRGB)
+	std::vector<BufferImage> m_NormalBufferImages;		// Normali ottaedriche (RG16)
+	std::vector<BufferImage> m_GBufferDepthImages;		// Depth del G-buffer, da qui si ricostruisce la posizione
+	std::vector<BufferImage> m_LightingBufferImages;	// Output del tiled lighting (RGBA16F), composto nel render pass finale
 	BufferImage m_DepthBufferImage;
+	HiZPyramid	m_HiZ;									// Max depth del G-buffer per l'occlusion culling del frame successivo
+	glm::mat4	m_PrevViewProj = glm::mat4(1.f);		// View-Projection con cui  stata scritta la depth della Hi-Z
+	bool		m_HiZValid = false;						// La Hi-Z contiene la depth di un frame (falso prima del primo)
 
 	std::vector<VkFramebuffer>	 m_OffScreenFrameBuffer;
 	
-	std::vector<VkBuffer>		 m_ViewProjectionUBO;
-	std::vector<VkDeviceMemory>  m_ViewProjectionUBOMemory;
+	UniformRing					 m_UniformRing;		// VP, settings e cluster di ogni frame in flight
 	ViewProjectionData			 m_VPData;
-
-	std::vector<VkBuffer>		 m_LightUBO;
-	std::vector<VkDeviceMemory>	 m_LightUBOMemory;
-	std::array<LightData, NUM_LIGHTS>		 m_LightData;
-
-	std::vector<VkBuffer>		 m_SettingsUBO;
-	std::vector<VkDeviceMemory>	 m_SettingsUBOMemory;
+	LightManager				 m_LightManager;	// Luci della scena nel light buffer, caricate solo se cambiano
+	ObjectBuffer				 m_ObjectBuffer;	// Model e normal matrix di ogni istanza per object ID, caricate solo se cambiano
+	std::vector<LightHandle>	 m_SceneLights;		// Handle delle luci indirizzate per indice (UpdateLight*, SetLightCount)
 	SettingsData				 m_SettingsData;
-
-	VkPushConstantRange			 m_PushCostantRange;
+	LightClusters				 m_LightClusters;	// Liste di luci per cluster, ricostruite ogni frame in LIGHTING_CLUSTERED
+	float						 m_NearPlane = 0.1f;
+	float						 m_FarPlane	 = 100.0f;
 
 	std::vector<SubmissionSyncObjects> m_SyncObjects;
 
@@ -93,8 +133,13 @@ private:
 	Scene m_Scene;
 	std::vector<Mesh> m_MeshList;
 	std::vector<MeshModel> m_MeshModelList;
+	uint64_t m_SceneVersion = 0;	// Cambia quando cambiano le draw del G-buffer: i command buffer offscreen vanno ri-registrati
+	DrawList m_DrawList;			// Comandi indirect del G-buffer, ricostruiti quando cambia m_SceneVersion
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> m_DrawListSetVersions;	// Scene version dei buffer nel cull/object set di ogni slot
 
 private:
+	int  InitRenderer();
+	void CreateGBufferImages();
 	void CreateOffScreenFrameBuffer();
 
 	/* Core Renderer Functions */
@@ -104,17 +149,22 @@ private:
 	void CreateLogicalDevice();	
 	void CreateSurface();
 	void CreateSynchronizationObjects();
+	void CreateTransferCommandPool();
 
 
-	void CreateMeshModel(const std::string& file);
+	void CreateMeshModel(const std::string& file, UploadBatch& upload_batch);
+	MeshHandle ImportMeshModel(const std::string& file, UploadBatch& upload_batch);
+	MeshHandle LoadCookedMeshModel(const CookedMesh& cooked, UploadBatch& upload_batch);
+	std::vector<int> LoadModelTextures(const std::vector<std::string>& texture_names, UploadBatch& upload_batch, std::vector<TextureHandle>& textures);
+	UploadBatch CreateUploadBatch();
+	void RetireUploads(bool wait_all);
 
 	/* Auxiliary function for creation */
 	void LoadGlfwExtensions(std::vector<const char*>& instanceExtensions);
 
 	/* Uniform Data */
-	void SetupPushCostantRange();
 	void CreateUniformBuffers();
-	void UpdateUniformBuffersWithData(uint32_t imageIndex);
+	FrameUniformOffsets UpdateUniformBuffersWithData(uint32_t frame);
 	void SetUniformDataStructures();
 	void SetLightsDataStructures();
 
@@ -1,5 +1,7 @@
 #pragma once
+#ifdef _MSC_VER
 #pragma warning(disable : 26812 26495)
+#endif
 
 // Standard Library
 #include <vector>
@@ -13,13 +15,26 @@
 #include <fstream>
 #include <random>
 #include <map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <queue>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+#include <memory>
 
 // Project Data Structures
 #include "DataStructures.h"
 
-// GLFW
+// GLFW (the headless-only build talks to Vulkan directly)
+#ifdef HEADLESS_ONLY
+#include <vulkan/vulkan.h>
+#else
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#endif
 
 // GLM
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -31,7 +46,9 @@
 
 // DEAR IMGUI
 #include "imgui_impl_vulkan.h"
+#ifndef HEADLESS_ONLY
 #include "imgui_impl_glfw.h"
+#endif
 #include "imgui.h"
 
 // PCG